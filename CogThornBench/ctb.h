@@ -0,0 +1,65 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb.h>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CTB_INCLUDE_
+#define _CTB_INCLUDE_ 
+
+#include "../CogThorn.h"
+
+#include <stdio.h>
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								TEST RUNNER
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// every test or benchmark is one function which prints its own results
+/// and returns FALSE when one of its checks failed. benchmarks only check
+/// that the work they timed was done correctly, never how fast it was.
+/// CTBRunThreads starts threadCount threads which all wait on one gate,
+/// opens the gate, and returns the usec from opening to the last thread
+/// finishing
+
+#define CTB_CHECK(cond)																			\
+	if (!(cond)) {																				\
+		printf("    CHECK FAILED: %s (%s:%d)\n", #cond, __FILE__, __LINE__);					\
+		return FALSE;																			\
+	}
+
+typedef BOOL (*PCTBFUNCTEST)(void);
+typedef void (*PCTBFUNCTHREAD)(UINT32 threadIndex, PVOID input);
+
+typedef struct CTBEntry {
+	PCHAR			name;
+	PCTBFUNCTEST	func;
+} CTBEntry, *PCTBEntry;
+
+UINT64	CTBRunThreads(UINT32 threadCount, PCTBFUNCTHREAD func, PVOID input);
+UINT64	CTBPercentile(PUINT64 samples, UINT32 sampleCount, UINT32 percent);
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								TESTS
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+BOOL	CTBTestFrameAllocs(void);
+BOOL	CTBBenchAlloc(void);
+BOOL	CTBBenchDynListRemove(void);
+BOOL	CTBBenchDynListIterate(void);
+BOOL	CTBBenchDynListParallel(void);
+BOOL	CTBBenchQueue(void);
+BOOL	CTBBenchPoolTasks(void);
+BOOL	CTBBenchParallelFor(void);
+BOOL	CTBBenchTaskLatency(void);
+BOOL	CTBBenchPaceJitter(void);
+BOOL	CTBBenchTextureSample(void);
+BOOL	CTBBenchFrameBufferFill(void);
+
+#endif
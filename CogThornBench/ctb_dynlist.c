@@ -0,0 +1,375 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb_dynlist.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ctb.h"
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							RANDOM REMOVE BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// removal cost should not depend on how many nodes the list has. a remove
+/// which walks the node chain costs about 10x more per element at 100k
+/// than at 10k, a remove which reads the slot header does not
+
+#define __CTB_REMOVE_ELEMENTS_PER_NODE	0x100
+
+typedef struct __CTBRemoveSum {
+	UINT64	sum;
+	UINT32	count;
+} __CTBRemoveSum, *P__CTBRemoveSum;
+
+static BOOL __HCTBRemoveSumElement(PUINT64 element, P__CTBRemoveSum sum) {
+	sum->sum += *element;
+	sum->count++;
+	return TRUE;
+}
+
+static BOOL __HCTBRemoveRun(UINT32 elementCount) {
+
+	/// SUMMARY:
+	/// add elements, each holding its own index
+	/// shuffle element pointers
+	/// time removing the first half of the shuffled pointers
+	/// remaining elements must be exactly the second half
+	/// time removing the second half
+	/// list must be empty
+
+	PCTDynList	list		= CTDynListCreate(sizeof(UINT64), __CTB_REMOVE_ELEMENTS_PER_NODE);
+	PUINT64*	elements	= CTAllocUninit(sizeof(PUINT64) * elementCount);
+
+	for (UINT32 elementIndex = 0; elementIndex < elementCount; elementIndex++) {
+		elements[elementIndex]	= CTDynListAdd(list);
+		*elements[elementIndex]	= elementIndex;
+	}
+
+	UINT32 seed = 0x2545F491u;
+	for (UINT32 elementIndex = elementCount - 1; elementIndex > 0; elementIndex--) {
+		seed = seed * 1664525u + 1013904223u;
+		UINT32	swapIndex			= (seed >> 8) % (elementIndex + 1);
+		PUINT64	swapElement			= elements[swapIndex];
+		elements[swapIndex]			= elements[elementIndex];
+		elements[elementIndex]		= swapElement;
+	}
+
+	UINT32 HALF_COUNT	= elementCount / 2;
+	UINT32 failCount	= 0;
+
+	UINT64 START_USEC = CTClockUsec();
+	for (UINT32 elementIndex = 0; elementIndex < HALF_COUNT; elementIndex++) {
+		if (CTDynListRemove(list, elements[elementIndex]) == FALSE) failCount++;
+	}
+	UINT64 halfUsec = CTClockUsec() - START_USEC;
+
+	__CTBRemoveSum expected = { 0 };
+	for (UINT32 elementIndex = HALF_COUNT; elementIndex < elementCount; elementIndex++) {
+		expected.sum += *elements[elementIndex];
+		expected.count++;
+	}
+	__CTBRemoveSum remaining = { 0 };
+	CTDynListForEach(list, __HCTBRemoveSumElement, &remaining);
+
+	START_USEC = CTClockUsec();
+	for (UINT32 elementIndex = HALF_COUNT; elementIndex < elementCount; elementIndex++) {
+		if (CTDynListRemove(list, elements[elementIndex]) == FALSE) failCount++;
+	}
+	UINT64 totalUsec = halfUsec + (CTClockUsec() - START_USEC);
+
+	printf(
+		"    %6u elements, %4u nodes: %7llu usec, %6.1f ns per remove\n",
+		elementCount,
+		list->nodeCount,
+		totalUsec,
+		(totalUsec * 1000.0) / elementCount
+	);
+
+	UINT32 endCount = list->elementsUsedCount;
+
+	CTFree(elements);
+	CTDynListDestroy(&list);
+
+	CTB_CHECK(failCount == 0);
+	CTB_CHECK(remaining.count == expected.count);
+	CTB_CHECK(remaining.sum == expected.sum);
+	CTB_CHECK(endCount == 0);
+
+	return TRUE;
+}
+
+BOOL	CTBBenchDynListRemove(void) {
+	if (__HCTBRemoveRun(10000) == FALSE) return FALSE;
+	if (__HCTBRemoveRun(100000) == FALSE) return FALSE;
+	return TRUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							SPARSE ITERATION BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// walks a list with 10% of its slots live, spread at random. the byte scan
+/// control reads one occupancy byte per slot the way iteration did before
+/// occupancy became a bitset (inlined, so it pays no call per element);
+/// the other paths skip whole empty 64 bit words
+
+#define __CTB_ITERATE_ELEMENTS			200000
+#define __CTB_ITERATE_ELEMENTS_PER_NODE	0x100
+#define __CTB_ITERATE_LIVE_PERCENT		10
+#define __CTB_ITERATE_BATCH_SIZE		0x40
+#define __CTB_ITERATE_PASSES			0x10
+
+typedef struct __CTBIterateSum {
+	UINT64	sum;
+	UINT32	count;
+} __CTBIterateSum, *P__CTBIterateSum;
+
+static void __HCTBIteratePrint(PCHAR label, UINT64 totalUsec, UINT32 liveCount) {
+	printf(
+		"    %-20s %7llu usec, %5.2f ns per live element\n",
+		label,
+		totalUsec,
+		(totalUsec * 1000.0) / ((UINT64)liveCount * __CTB_ITERATE_PASSES)
+	);
+}
+
+static BOOL __HCTBIterateCheck(P__CTBIterateSum result, P__CTBIterateSum expected) {
+	return	result->sum		== expected->sum * __CTB_ITERATE_PASSES &&
+			result->count	== expected->count * __CTB_ITERATE_PASSES;
+}
+
+BOOL	CTBBenchDynListIterate(void) {
+
+	/// SUMMARY:
+	/// add elements, each holding its own index
+	/// remove a random 90%, note sum and count of what is left
+	/// copy occupancy bits into one byte per slot for the control
+	/// time several passes of each walk:
+	///		byte scan control, CTIteratorIterate, CTIteratorIterateBatch,
+	///		CT_DYNLIST_FOREACH
+	/// every walk must see exactly the live elements
+
+	PCTDynList	list		= CTDynListCreate(sizeof(UINT64), __CTB_ITERATE_ELEMENTS_PER_NODE);
+	PUINT64*	elements	= CTAllocUninit(sizeof(PUINT64) * __CTB_ITERATE_ELEMENTS);
+
+	for (UINT32 elementIndex = 0; elementIndex < __CTB_ITERATE_ELEMENTS; elementIndex++) {
+		elements[elementIndex]	= CTDynListAdd(list);
+		*elements[elementIndex]	= elementIndex;
+	}
+
+	__CTBIterateSum	expected	= { 0 };
+	UINT32			seed		= 0x5BE0CD19u;
+	for (UINT32 elementIndex = 0; elementIndex < __CTB_ITERATE_ELEMENTS; elementIndex++) {
+		seed = seed * 1664525u + 1013904223u;
+		if ((seed >> 8) % 100 < __CTB_ITERATE_LIVE_PERCENT) {
+			expected.sum += elementIndex;
+			expected.count++;
+			continue;
+		}
+		CTDynListRemove(list, elements[elementIndex]);
+	}
+	CTFree(elements);
+
+	UINT32	EPN			= list->elementsPerNode;
+	PBYTE	useField	= CTAlloc((SIZE_T)list->nodeCount * EPN);
+	UINT32	nodeIndex	= 0;
+	for (PCTDynListNode node = list->nodeFirst; node != NULL; node = node->nextNode, nodeIndex++) {
+		for (UINT32 slot = 0; slot < EPN; slot++)
+			useField[((SIZE_T)nodeIndex * EPN) + slot] = (BYTE)((node->useBits[slot / 64] >> (slot % 64)) & 1);
+	}
+
+	printf(
+		"    %u slots, %u live, %u nodes, %u passes\n",
+		list->elementsTotalCount,
+		list->elementsUsedCount,
+		list->nodeCount,
+		__CTB_ITERATE_PASSES
+	);
+
+	__CTBIterateSum scanSum = { 0 };
+	UINT64 START_USEC = CTClockUsec();
+	for (UINT32 pass = 0; pass < __CTB_ITERATE_PASSES; pass++) {
+		nodeIndex = 0;
+		for (PCTDynListNode node = list->nodeFirst; node != NULL; node = node->nextNode, nodeIndex++) {
+			PBYTE nodeField = useField + ((SIZE_T)nodeIndex * EPN);
+			for (UINT32 slot = 0; slot < EPN; slot++) {
+				if (nodeField[slot] == FALSE) continue;
+				scanSum.sum += *(PUINT64)__CTDynListElement(list, node, slot);
+				scanSum.count++;
+			}
+		}
+	}
+	__HCTBIteratePrint("byte scan (old)", CTClockUsec() - START_USEC, expected.count);
+
+	__CTBIterateSum iterateSum = { 0 };
+	START_USEC = CTClockUsec();
+	for (UINT32 pass = 0; pass < __CTB_ITERATE_PASSES; pass++) {
+		CTIterator	iterator;
+		PUINT64		element;
+		CTIteratorBegin(list, &iterator);
+		while ((element = CTIteratorIterate(&iterator)) != NULL) {
+			iterateSum.sum += *element;
+			iterateSum.count++;
+		}
+		CTIteratorEnd(&iterator);
+	}
+	__HCTBIteratePrint("CTIteratorIterate", CTClockUsec() - START_USEC, expected.count);
+
+	__CTBIterateSum batchSum = { 0 };
+	START_USEC = CTClockUsec();
+	for (UINT32 pass = 0; pass < __CTB_ITERATE_PASSES; pass++) {
+		CTIterator	iterator;
+		PVOID		batch	[__CTB_ITERATE_BATCH_SIZE];
+		UINT32		batchCount;
+		CTIteratorBegin(list, &iterator);
+		while ((batchCount = CTIteratorIterateBatch(&iterator, batch, __CTB_ITERATE_BATCH_SIZE)) != 0) {
+			for (UINT32 batchIndex = 0; batchIndex < batchCount; batchIndex++)
+				batchSum.sum += *(PUINT64)batch[batchIndex];
+			batchSum.count += batchCount;
+		}
+		CTIteratorEnd(&iterator);
+	}
+	__HCTBIteratePrint("IterateBatch (64)", CTClockUsec() - START_USEC, expected.count);
+
+	__CTBIterateSum foreachSum = { 0 };
+	START_USEC = CTClockUsec();
+	for (UINT32 pass = 0; pass < __CTB_ITERATE_PASSES; pass++) {
+		PUINT64 element;
+		CTDynListReadBegin(list);
+		CT_DYNLIST_FOREACH(list, element) {
+			foreachSum.sum += *element;
+			foreachSum.count++;
+		}
+		CTDynListReadEnd(list);
+	}
+	__HCTBIteratePrint("CT_DYNLIST_FOREACH", CTClockUsec() - START_USEC, expected.count);
+
+	CTFree(useField);
+	CTDynListDestroy(&list);
+
+	CTB_CHECK(__HCTBIterateCheck(&scanSum, &expected));
+	CTB_CHECK(__HCTBIterateCheck(&iterateSum, &expected));
+	CTB_CHECK(__HCTBIterateCheck(&batchSum, &expected));
+	CTB_CHECK(__HCTBIterateCheck(&foreachSum, &expected));
+
+	return TRUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///						PARALLEL FOR EACH THREAD SWEEP
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// runs CTDynListParallelForEachEx over one dense list with 1, 2, 4, 8 and
+/// 16 threads (the caller plus a pool of n - 1 workers, no pool for 1) and
+/// reports speedup over the single thread run. every element gets a fixed
+/// amount of hashing so the walk is not bound by memory alone. counts past
+/// the machine's hardware threads can only show oversubscription
+
+#define __CTB_PARALLEL_ELEMENTS			0x40000
+#define __CTB_PARALLEL_ELEMENTS_PER_NODE	0x400
+#define __CTB_PARALLEL_HASH_ROUNDS		0x40
+#define __CTB_PARALLEL_PASSES			0x8
+
+typedef struct __CTBParallelElement {
+	UINT64	value;
+	UINT32	visitCount;
+} __CTBParallelElement, *P__CTBParallelElement;
+
+static BOOL __HCTBParallelVisit(P__CTBParallelElement element, PVOID input) {
+	UINT64 value = element->value;
+	for (UINT32 round = 0; round < __CTB_PARALLEL_HASH_ROUNDS; round++) {
+		value ^= value << 13;
+		value ^= value >> 7;
+		value ^= value << 17;
+	}
+	element->value = value;
+	element->visitCount++;
+	return TRUE;
+}
+
+BOOL	CTBBenchDynListParallel(void) {
+
+	/// SUMMARY:
+	/// fill list
+	/// loop (thread counts)
+	///		create pool of thread count - 1 workers (none for 1 thread)
+	///		warm up with one walk, then time several walks
+	///		print usec per walk and speedup over 1 thread
+	///		destroy pool
+	/// every element must have been visited once per walk
+
+	UINT32 THREAD_COUNTS[] = { 1, 2, 4, 8, 16 };
+	UINT32 SWEEP_COUNT = sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]);
+
+	PCTDynList list = CTDynListCreate(sizeof(__CTBParallelElement), __CTB_PARALLEL_ELEMENTS_PER_NODE);
+	for (UINT32 elementIndex = 0; elementIndex < __CTB_PARALLEL_ELEMENTS; elementIndex++) {
+		P__CTBParallelElement element	= CTDynListAdd(list);
+		element->value					= elementIndex + 1;
+		element->visitCount				= 0;
+	}
+
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	printf(
+		"    %u elements, %u hash rounds each, %u hardware threads\n",
+		__CTB_PARALLEL_ELEMENTS,
+		__CTB_PARALLEL_HASH_ROUNDS,
+		sysInfo.dwNumberOfProcessors
+	);
+
+	UINT64 singleUsec	= 0;
+	UINT32 walkCount	= 0;
+	UINT32 failCount	= 0;
+
+	for (UINT32 sweepIndex = 0; sweepIndex < SWEEP_COUNT; sweepIndex++) {
+		UINT32			threadCount	= THREAD_COUNTS[sweepIndex];
+		PCTThreadPool	pool		= (threadCount > 1) ? CTThreadPoolCreate(threadCount - 1) : NULL;
+
+		if (CTDynListParallelForEachEx(list, __HCTBParallelVisit, NULL, 0, pool) == FALSE) failCount++;
+		walkCount++;
+
+		UINT64 START_USEC = CTClockUsec();
+		for (UINT32 pass = 0; pass < __CTB_PARALLEL_PASSES; pass++) {
+			if (CTDynListParallelForEachEx(list, __HCTBParallelVisit, NULL, 0, pool) == FALSE) failCount++;
+		}
+		UINT64 walkUsec = (CTClockUsec() - START_USEC) / __CTB_PARALLEL_PASSES;
+		walkCount += __CTB_PARALLEL_PASSES;
+
+		if (threadCount == 1)
+			singleUsec = walkUsec;
+
+		printf(
+			"    %2u threads: %7llu usec per walk, %5.2fx speedup, %5.1f%% efficiency\n",
+			threadCount,
+			walkUsec,
+			(singleUsec * 1.0) / max(1, walkUsec),
+			(100.0 * singleUsec) / (max(1, walkUsec) * threadCount)
+		);
+
+		if (pool != NULL)
+			CTThreadPoolDestroy(&pool);
+	}
+
+	UINT32					missCount = 0;
+	P__CTBParallelElement	element;
+	CTDynListReadBegin(list);
+	CT_DYNLIST_FOREACH(list, element) {
+		if (element->visitCount != walkCount) missCount++;
+	}
+	CTDynListReadEnd(list);
+
+	CTDynListDestroy(&list);
+
+	CTB_CHECK(failCount == 0);
+	CTB_CHECK(missCount == 0);
+
+	return TRUE;
+}
@@ -0,0 +1,221 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb_framebuffer.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ctb.h"
+
+#include <float.h>
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							FILL AND PRESENT BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// fills every pixel of a framebuffer per format, with and without a depth
+/// plane, then blends a translucent pass over it and converts it to BGRA the
+/// way presenting does. the switch control fills a second framebuffer with
+/// the per pixel format switch CTFrameBufferSetEx used before pixelOps, and
+/// goes through a function pointer like CTFrameBufferSetEx so neither is
+/// inlined into the loop. the ops fill fetches pixelOps once and calls set
+/// per pixel, as CTDraw does. every fill must present to the same pixels
+
+#define __CTB_FB_WIDTH		0x400
+#define __CTB_FB_HEIGHT		0x300
+#define __CTB_FB_PASSES		0x4
+
+static CTColor __HCTBFrameBufferColor(UINT32 x, UINT32 y, BYTE alpha) {
+	CTColor col = {
+		.b = (BYTE)(x * 3),
+		.g = (BYTE)(y * 5),
+		.r = (BYTE)((x + y) * 7),
+		.a = alpha
+	};
+	return col;
+}
+
+typedef BOOL (*__PCTBFUNCFBSET)(PCTFB fb, CTPoint pt, CTColor col, FLOAT depth, BOOL safe);
+
+static BOOL __HCTBFrameBufferSetSwitch(PCTFB fb, CTPoint pt, CTColor col, FLOAT depth, BOOL safe) {
+
+	UINT32 index		= pt.x + ((fb->height - pt.y - 1) * fb->width);
+	fb->depth[index]	= depth;
+
+	switch (fb->format)
+	{
+
+	case CT_COLOR_FORMAT_BGRA8888:
+		fb->color[index] = col;
+		break;
+
+	case CT_COLOR_FORMAT_RGB565:
+		((PUINT16)fb->packed)[index] = (UINT16)(((col.r >> 3) << 11) | ((col.g >> 2) << 5) | (col.b >> 3));
+		break;
+
+	case CT_COLOR_FORMAT_INDEXED8:
+		((PBYTE)fb->packed)[index] = fb->paletteLookup[((col.r >> 3) << 10) | ((col.g >> 3) << 5) | (col.b >> 3)];
+		break;
+
+	}
+
+	return TRUE;
+}
+
+static UINT64 __HCTBFrameBufferFill(PCTFB fb, __PCTBFUNCFBSET setFunc) {
+
+	/// volatile, so the compiler can not specialize this loop for one
+	/// function and inline it
+	__PCTBFUNCFBSET volatile set = setFunc;
+
+	UINT64 START_USEC = CTClockUsec();
+	for (UINT32 pass = 0; pass < __CTB_FB_PASSES; pass++) {
+		for (UINT32 y = 0; y < __CTB_FB_HEIGHT; y++) {
+			for (UINT32 x = 0; x < __CTB_FB_WIDTH; x++) {
+				CTColor col	= __HCTBFrameBufferColor(x + pass, y, 255);
+				CTPoint pt	= { .x = x, .y = y };
+				set(fb, pt, col, 1.0f, FALSE);
+			}
+		}
+	}
+	return CTClockUsec() - START_USEC;
+}
+
+static UINT64 __HCTBFrameBufferFillDirect(PCTFB fb) {
+
+	/// SUMMARY:
+	/// fetch pixelOps once, then write depth and call set per pixel
+	/// (what CTDraw does per pixel)
+
+	PCTFrameBufferPixelOps ops = fb->pixelOps;
+
+	UINT64 START_USEC = CTClockUsec();
+	for (UINT32 pass = 0; pass < __CTB_FB_PASSES; pass++) {
+		for (UINT32 y = 0; y < __CTB_FB_HEIGHT; y++) {
+			for (UINT32 x = 0; x < __CTB_FB_WIDTH; x++) {
+				CTColor col		= __HCTBFrameBufferColor(x + pass, y, 255);
+				UINT32	index	= x + ((fb->height - y - 1) * fb->width);
+				if (fb->depth != NULL)
+					fb->depth[index] = 1.0f;
+				ops->set(fb, index, col);
+			}
+		}
+	}
+	return CTClockUsec() - START_USEC;
+}
+
+static UINT64 __HCTBFrameBufferBlend(PCTFB fb) {
+
+	UINT64 START_USEC = CTClockUsec();
+	for (UINT32 pass = 0; pass < __CTB_FB_PASSES; pass++) {
+		for (UINT32 y = 0; y < __CTB_FB_HEIGHT; y++) {
+			for (UINT32 x = 0; x < __CTB_FB_WIDTH; x++) {
+				CTColor col	= __HCTBFrameBufferColor(y, x, 0x80);
+				CTPoint pt	= { .x = x, .y = y };
+				CTFrameBufferBlendEx(fb, pt, col, 0.5f, FALSE);
+			}
+		}
+	}
+	return CTClockUsec() - START_USEC;
+}
+
+static UINT64 __HCTBFrameBufferPresent(PCTFB fb, PCTColor out) {
+
+	UINT64 START_USEC = CTClockUsec();
+	for (UINT32 pass = 0; pass < __CTB_FB_PASSES; pass++) {
+		CTFrameBufferLock(fb);
+		CTFrameBufferConvert(fb, out);
+		CTFrameBufferUnlock(fb);
+	}
+	return CTClockUsec() - START_USEC;
+}
+
+static FLOAT __HCTBFrameBufferNsPerPixel(UINT64 usec) {
+	return (FLOAT)((usec * 1000.0) / ((UINT64)__CTB_FB_WIDTH * __CTB_FB_HEIGHT * __CTB_FB_PASSES));
+}
+
+static BOOL __HCTBFrameBufferRun(PCHAR label, UINT32 format, UINT32 flags) {
+
+	/// SUMMARY:
+	/// create framebuffer and a control framebuffer of the same format
+	/// time control fill (per pixel switch), then fill through pixelOps
+	/// fetched once and fill through CTFrameBufferSetEx
+	/// every fill must present to the same pixels
+	/// time translucent blend pass, then present
+	/// every pixel read back must match the presented pixel
+
+	SIZE_T		PIXEL_COUNT	= (SIZE_T)__CTB_FB_WIDTH * __CTB_FB_HEIGHT;
+	PCTFB		fb			= CTFrameBufferCreateEx(__CTB_FB_WIDTH, __CTB_FB_HEIGHT, format, flags);
+	PCTFB		control		= CTFrameBufferCreateEx(__CTB_FB_WIDTH, __CTB_FB_HEIGHT, format, 0);
+	PCTColor	presented	= CTAllocUninit(sizeof(CTColor) * PIXEL_COUNT);
+	PCTColor	expected	= CTAllocUninit(sizeof(CTColor) * PIXEL_COUNT);
+	CTB_CHECK(fb != NULL);
+	CTB_CHECK(control != NULL);
+
+	UINT64 switchUsec	= __HCTBFrameBufferFill(control, __HCTBFrameBufferSetSwitch);
+	UINT64 directUsec	= __HCTBFrameBufferFillDirect(fb);
+
+	CTFrameBufferConvert(control, expected);
+	CTFrameBufferConvert(fb, presented);
+	BOOL fillMatches = (memcmp(expected, presented, sizeof(CTColor) * PIXEL_COUNT) == 0);
+
+	UINT64 fillUsec		= __HCTBFrameBufferFill(fb, CTFrameBufferSetEx);
+
+	CTFrameBufferConvert(fb, presented);
+	fillMatches = fillMatches && (memcmp(expected, presented, sizeof(CTColor) * PIXEL_COUNT) == 0);
+
+	UINT64 blendUsec	= __HCTBFrameBufferBlend(fb);
+	UINT64 presentUsec	= __HCTBFrameBufferPresent(fb, presented);
+
+	UINT32 mismatchCount = 0;
+	for (UINT32 y = 0; y < __CTB_FB_HEIGHT; y++) {
+		for (UINT32 x = 0; x < __CTB_FB_WIDTH; x++) {
+			CTColor col;
+			CTPoint pt = { .x = x, .y = y };
+			CTFrameBufferGetEx(fb, pt, &col, NULL, FALSE);
+			PCTColor shown = presented + x + ((SIZE_T)(__CTB_FB_HEIGHT - y - 1) * __CTB_FB_WIDTH);
+			if (*(PUINT32)&col != *(PUINT32)shown) mismatchCount++;
+		}
+	}
+
+	FLOAT depth;
+	CTPoint origin = { 0 };
+	CTFrameBufferGetEx(fb, origin, NULL, &depth, FALSE);
+
+	printf(
+		"    %-18s fill: switch %5.2f, SetEx %5.2f, ops %5.2f ns/px; blend %5.2f, present %5.2f\n",
+		label,
+		__HCTBFrameBufferNsPerPixel(switchUsec),
+		__HCTBFrameBufferNsPerPixel(fillUsec),
+		__HCTBFrameBufferNsPerPixel(directUsec),
+		__HCTBFrameBufferNsPerPixel(blendUsec),
+		__HCTBFrameBufferNsPerPixel(presentUsec)
+	);
+
+	BOOL hasDepth = (fb->depth != NULL);
+
+	CTFree(presented);
+	CTFree(expected);
+	CTFrameBufferDestroy(&fb);
+	CTFrameBufferDestroy(&control);
+
+	CTB_CHECK(fillMatches);
+	CTB_CHECK(mismatchCount == 0);
+	CTB_CHECK(hasDepth == ((flags & CT_FRAMEBUFFER_FLAG_NO_DEPTH) == 0));
+	CTB_CHECK(depth == (hasDepth ? 0.5f : FLT_MAX));
+
+	return TRUE;
+}
+
+BOOL	CTBBenchFrameBufferFill(void) {
+	if (__HCTBFrameBufferRun("BGRA8888",			CT_COLOR_FORMAT_BGRA8888,	0) == FALSE) return FALSE;
+	if (__HCTBFrameBufferRun("BGRA8888 no depth",	CT_COLOR_FORMAT_BGRA8888,	CT_FRAMEBUFFER_FLAG_NO_DEPTH) == FALSE) return FALSE;
+	if (__HCTBFrameBufferRun("RGB565",				CT_COLOR_FORMAT_RGB565,		0) == FALSE) return FALSE;
+	if (__HCTBFrameBufferRun("RGB565 no depth",		CT_COLOR_FORMAT_RGB565,		CT_FRAMEBUFFER_FLAG_NO_DEPTH) == FALSE) return FALSE;
+	if (__HCTBFrameBufferRun("INDEXED8",			CT_COLOR_FORMAT_INDEXED8,	0) == FALSE) return FALSE;
+	if (__HCTBFrameBufferRun("INDEXED8 no depth",	CT_COLOR_FORMAT_INDEXED8,	CT_FRAMEBUFFER_FLAG_NO_DEPTH) == FALSE) return FALSE;
+	return TRUE;
+}
@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb_main.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ctb.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static CTBEntry __ctbEntries[] = {
+	{ "frame_allocs",		CTBTestFrameAllocs		},
+	{ "alloc",				CTBBenchAlloc			},
+	{ "dynlist_remove",		CTBBenchDynListRemove	},
+	{ "dynlist_iterate",	CTBBenchDynListIterate	},
+	{ "dynlist_parallel",	CTBBenchDynListParallel	},
+	{ "queue",				CTBBenchQueue			},
+	{ "pool_tasks",			CTBBenchPoolTasks		},
+	{ "parallel_for",		CTBBenchParallelFor		},
+	{ "task_latency",		CTBBenchTaskLatency		},
+	{ "pace_jitter",		CTBBenchPaceJitter		},
+	{ "texture_sample",		CTBBenchTextureSample	},
+	{ "framebuffer_fill",	CTBBenchFrameBufferFill	},
+};
+
+#define __CTB_ENTRY_COUNT	(sizeof(__ctbEntries) / sizeof(__ctbEntries[0]))
+#define __CTB_THREADS_MAX	0x40
+
+typedef struct __CTBThreadStart {
+	PCTBFUNCTHREAD	func;
+	PVOID			input;
+	UINT32			threadIndex;
+	HANDLE			gate;
+} __CTBThreadStart, *P__CTBThreadStart;
+
+static DWORD WINAPI __HCTBThreadProc(P__CTBThreadStart start) {
+	WaitForSingleObject(start->gate, INFINITE);
+	start->func(start->threadIndex, start->input);
+	CTAllocThreadCacheFlush();
+	return 0;
+}
+
+UINT64	CTBRunThreads(UINT32 threadCount, PCTBFUNCTHREAD func, PVOID input) {
+
+	/// SUMMARY:
+	/// create all threads, blocked on the gate
+	/// open gate, wait for all threads, return usec taken
+
+	threadCount = min(max(threadCount, 1), __CTB_THREADS_MAX);
+
+	__CTBThreadStart	starts	[__CTB_THREADS_MAX];
+	HANDLE				threads	[__CTB_THREADS_MAX];
+	HANDLE				gate	= CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	for (UINT32 threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+		starts[threadIndex].func		= func;
+		starts[threadIndex].input		= input;
+		starts[threadIndex].threadIndex	= threadIndex;
+		starts[threadIndex].gate		= gate;
+		threads[threadIndex] = CreateThread(NULL, 0, __HCTBThreadProc, starts + threadIndex, 0, NULL);
+	}
+
+	UINT64 START_USEC = CTClockUsec();
+	SetEvent(gate);
+	WaitForMultipleObjects(threadCount, threads, TRUE, INFINITE);
+	UINT64 END_USEC = CTClockUsec();
+
+	for (UINT32 threadIndex = 0; threadIndex < threadCount; threadIndex++)
+		CloseHandle(threads[threadIndex]);
+	CloseHandle(gate);
+
+	return END_USEC - START_USEC;
+}
+
+static int __HCTBCompareU64(const void* a, const void* b) {
+	UINT64 left		= *(const UINT64*)a;
+	UINT64 right	= *(const UINT64*)b;
+	return (left > right) - (left < right);
+}
+
+UINT64	CTBPercentile(PUINT64 samples, UINT32 sampleCount, UINT32 percent) {
+	if (sampleCount == 0) return 0;
+
+	/// sorts samples in place
+	qsort(samples, sampleCount, sizeof(UINT64), __HCTBCompareU64);
+	return samples[((UINT64)(sampleCount - 1) * percent) / 100];
+}
+
+int main(int argc, char** argv) {
+
+	/// SUMMARY:
+	/// init library
+	/// loop (all entries)
+	///		if (names were given and entry is not one of them)
+	///			skip
+	///		run entry, count failures
+	/// terminate library
+	/// exit code is amount of failed entries
+
+	if (CogThornInit() == FALSE) {
+		puts("CogThornInit failed");
+		return 1;
+	}
+
+	int failCount = 0;
+
+	for (UINT32 entryIndex = 0; entryIndex < __CTB_ENTRY_COUNT; entryIndex++) {
+		PCTBEntry entry = __ctbEntries + entryIndex;
+
+		BOOL selected = (argc < 2);
+		for (int argIndex = 1; argIndex < argc; argIndex++) {
+			if (strcmp(argv[argIndex], entry->name) == 0)
+				selected = TRUE;
+		}
+		if (selected == FALSE) continue;
+
+		printf("[ RUN  ] %s\n", entry->name);
+		BOOL passed = entry->func();
+		printf("[ %s ] %s\n", passed ? " OK " : "FAIL", entry->name);
+
+		if (passed == FALSE)
+			failCount++;
+	}
+
+	CogThornTerminate();
+
+	return failCount;
+}
@@ -0,0 +1,230 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb_memory.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ctb.h"
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							FRAME ALLOCATION TEST
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#define __CTB_FRAME_COUNT			0x100
+#define __CTB_FRAME_LIST_ELEMENTS	0x400
+
+typedef struct __CTBFrameProbe {
+	SIZE_T	worstCount;
+} __CTBFrameProbe, *P__CTBFrameProbe;
+
+static void __HCTBFramePrimShader(CTPrimCtx ctx, PCTPrimitive prim, P__CTBFrameProbe* input) {
+
+	/// runs while CTDraw's scratch copies are live
+	P__CTBFrameProbe probe	= *input;
+	probe->worstCount		= max(probe->worstCount, CTAllocCount());
+}
+
+static BOOL __HCTBFramePixShader(CTPixCtx ctx, PCTPixel pixel, PVOID input) {
+	return TRUE;
+}
+
+static void __HCTBRunFrame(PCTDynList list, PCTFB fb, PCTMesh mesh, PCTShader shader, P__CTBFrameProbe probe) {
+
+	/// SUMMARY:
+	/// walk list with a created iterator, probing while it is live
+	/// draw mesh, probing from the primitive shader
+
+	PCTIterator iter	= CTIteratorCreate(list);
+	probe->worstCount	= max(probe->worstCount, CTAllocCount());
+	while (CTIteratorIterate(iter) != NULL);
+	CTIteratorDestroy(&iter);
+
+	CTDraw(
+		CT_DRAW_METHOD_FILL,
+		fb,
+		mesh,
+		shader,
+		&probe,
+		0.0f
+	);
+}
+
+BOOL	CTBTestFrameAllocs(void) {
+
+	/// SUMMARY:
+	/// build list, mesh, framebuffer and probing shader
+	/// control: run frame without a frame arena, heap path must be seen
+	/// bind frame arena, run one warmup frame so the arena owns its blocks
+	/// loop (frames)
+	///		reset arena, note live allocation count
+	///		run frame
+	///		live count must never rise above the noted count
+	/// unbind arena and destroy everything
+
+	FLOAT verts	[] = { -0.5f, -0.5f, 0.5f, -0.5f, 0.0f, 0.5f };
+	FLOAT uvs	[] = {  0.0f,  0.0f, 1.0f,  0.0f, 0.5f, 1.0f };
+
+	PCTDynList	list	= CTDynListCreate(sizeof(UINT64), 0x100);
+	PCTMesh		mesh	= CTMeshCreate(verts, uvs, 3);
+	PCTFB		fb		= CTFrameBufferCreate(0x40, 0x40);
+	PCTShader	shader	= CTShaderCreate(
+		__HCTBFramePrimShader,
+		__HCTBFramePixShader,
+		sizeof(P__CTBFrameProbe),
+		1,
+		1,
+		FALSE
+	);
+
+	for (UINT32 elementIndex = 0; elementIndex < __CTB_FRAME_LIST_ELEMENTS; elementIndex++)
+		CTDynListAdd(list);
+
+	__CTBFrameProbe probe = { 0 };
+
+	SIZE_T CONTROL_BASE = CTAllocCount();
+	probe.worstCount	= CONTROL_BASE;
+	__HCTBRunFrame(list, fb, mesh, shader, &probe);
+	SIZE_T controlDelta = probe.worstCount - CONTROL_BASE;
+
+	PCTArena arena = CTArenaCreate(CT_ARENA_BLOCK_SIZE_DEFAULT);
+	CTArenaFrameSet(arena);
+	__HCTBRunFrame(list, fb, mesh, shader, &probe);
+
+	SIZE_T worstDelta = 0;
+	for (UINT32 frameIndex = 0; frameIndex < __CTB_FRAME_COUNT; frameIndex++) {
+		CTArenaReset(arena);
+
+		SIZE_T FRAME_BASE	= CTAllocCount();
+		probe.worstCount	= FRAME_BASE;
+		__HCTBRunFrame(list, fb, mesh, shader, &probe);
+
+		worstDelta = max(worstDelta, probe.worstCount - FRAME_BASE);
+		worstDelta = max(worstDelta, CTAllocCount() - FRAME_BASE);
+	}
+
+	CTArenaFrameSet(NULL);
+	CTArenaDestroy(&arena);
+
+	printf("    no arena:    +%zu live allocations inside frame\n", controlDelta);
+	printf("    frame arena: +%zu live allocations inside %u frames\n", worstDelta, __CTB_FRAME_COUNT);
+
+	CTShaderDestroy(&shader);
+	CTFrameBufferDestroy(&fb);
+	CTMeshDestroy(&mesh);
+	CTDynListDestroy(&list);
+
+	CTB_CHECK(controlDelta > 0);
+	CTB_CHECK(worstDelta == 0);
+
+	return TRUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							ALLOCATOR BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// the heap path is what CTAlloc/CTFree did before the slab allocator:
+/// HeapAlloc from one shared heap, zero fill, HeapSize on free
+
+#define __CTB_ALLOC_ROUNDS		0x1000
+#define __CTB_ALLOC_BATCH		0x40
+#define __CTB_ALLOC_SIZE_MAX	0x200
+
+typedef struct __CTBAllocJob {
+	HANDLE			heap;
+	BOOL			useHeap;
+	volatile LONG	dirtyCount;
+} __CTBAllocJob, *P__CTBAllocJob;
+
+static void __HCTBAllocThread(UINT32 threadIndex, P__CTBAllocJob job) {
+
+	/// SUMMARY:
+	/// loop (rounds)
+	///		allocate a batch of mixed sizes, check zeroed and dirty them
+	///		free the batch
+
+	PUINT64	blocks	[__CTB_ALLOC_BATCH];
+	SIZE_T	sizes	[__CTB_ALLOC_BATCH];
+	UINT32	seed	= 0x9E3779B9u * (threadIndex + 1);
+	LONG	dirty	= 0;
+
+	for (UINT32 round = 0; round < __CTB_ALLOC_ROUNDS; round++) {
+		for (UINT32 blockIndex = 0; blockIndex < __CTB_ALLOC_BATCH; blockIndex++) {
+			seed = seed * 1664525u + 1013904223u;
+			SIZE_T sizeBytes = sizeof(UINT64) + (seed >> 8) % __CTB_ALLOC_SIZE_MAX;
+
+			PUINT64 block;
+			if (job->useHeap) {
+				block = HeapAlloc(job->heap, 0, sizeBytes);
+				__stosb((PBYTE)block, 0, sizeBytes);
+			}
+			else {
+				block = CTAlloc(sizeBytes);
+			}
+
+			if (block[0] != 0) dirty++;
+			block[0]			= ~0ull;
+			blocks[blockIndex]	= block;
+			sizes[blockIndex]	= sizeBytes;
+		}
+
+		for (UINT32 blockIndex = 0; blockIndex < __CTB_ALLOC_BATCH; blockIndex++) {
+			if (job->useHeap) {
+				if (HeapSize(job->heap, 0, blocks[blockIndex]) < sizes[blockIndex]) dirty++;
+				HeapFree(job->heap, 0, blocks[blockIndex]);
+			}
+			else {
+				CTFree(blocks[blockIndex]);
+			}
+		}
+	}
+
+	InterlockedExchangeAdd(&job->dirtyCount, dirty);
+}
+
+BOOL	CTBBenchAlloc(void) {
+
+	/// SUMMARY:
+	/// loop (1, 4, 16 threads)
+	///		time heap path, time CTAlloc path
+	///		print ns per alloc/free pair for both
+	/// every block must have come back zeroed, live count must balance
+
+	UINT32	threadCounts[] = { 1, 4, 16 };
+	SIZE_T	ALLOC_BASE	= CTAllocCount();
+	HANDLE	heap		= HeapCreate(0, 0, 0);
+
+	__CTBAllocJob job = { 0 };
+	job.heap = heap;
+
+	for (UINT32 countIndex = 0; countIndex < sizeof(threadCounts) / sizeof(threadCounts[0]); countIndex++) {
+		UINT32 threadCount	= threadCounts[countIndex];
+		UINT64 pairCount	= (UINT64)threadCount * __CTB_ALLOC_ROUNDS * __CTB_ALLOC_BATCH;
+
+		job.useHeap			= TRUE;
+		UINT64 heapUsec		= CTBRunThreads(threadCount, __HCTBAllocThread, &job);
+		job.useHeap			= FALSE;
+		UINT64 slabUsec		= CTBRunThreads(threadCount, __HCTBAllocThread, &job);
+
+		printf(
+			"    %2u threads: heap %7.1f ns/pair, CTAlloc %7.1f ns/pair (%.1fx)\n",
+			threadCount,
+			(heapUsec * 1000.0) / pairCount * threadCount,
+			(slabUsec * 1000.0) / pairCount * threadCount,
+			(double)heapUsec / max(slabUsec, 1)
+		);
+	}
+
+	HeapDestroy(heap);
+
+	CTB_CHECK(job.dirtyCount == 0);
+	CTB_CHECK(CTAllocCount() == ALLOC_BASE);
+
+	return TRUE;
+}
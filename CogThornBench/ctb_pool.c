@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb_pool.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ctb.h"
+
+/// every task and parallel-for index runs the same small hash so the
+/// work per index is fixed and the result can be checked against a serial
+/// run
+
+#define __CTB_POOL_HASH_ROUNDS		0x20
+
+static __forceinline UINT32 __HCTBPoolHash(UINT32 value) {
+	for (UINT32 round = 0; round < __CTB_POOL_HASH_ROUNDS; round++) {
+		value ^= value >> 15;
+		value *= 0x2C1B3C6Du;
+		value ^= value >> 12;
+	}
+	return value;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							TASK THROUGHPUT BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#define __CTB_POOL_TASKS			0x10000
+#define __CTB_POOL_TASK_FANOUT		0x10
+
+typedef struct __CTBPoolTaskJob {
+	volatile LONG64	sum;
+	volatile LONG	taskCount;
+} __CTBPoolTaskJob, *P__CTBPoolTaskJob;
+
+static void __HCTBPoolLeafTask(P__CTBPoolTaskJob job) {
+	UINT32 index = (UINT32)InterlockedIncrement(&job->taskCount);
+	InterlockedExchangeAdd64(&job->sum, __HCTBPoolHash(index));
+}
+
+static void __HCTBPoolBranchTask(P__CTBPoolTaskJob job) {
+
+	/// spawned from inside the pool, so the leaves land in this
+	/// worker's deque and idle workers have to steal them
+
+	CTTaskGroup group;
+	CTTaskGroupBegin(CTThreadPoolDefault(), &group);
+	for (UINT32 leafIndex = 0; leafIndex < __CTB_POOL_TASK_FANOUT; leafIndex++)
+		CTTaskGroupSpawn(&group, __HCTBPoolLeafTask, job);
+	CTTaskGroupWait(&group);
+}
+
+BOOL	CTBBenchPoolTasks(void) {
+
+	/// SUMMARY:
+	/// spawn branch tasks from this thread, each spawning leaf tasks
+	/// print tasks per second and ns per task
+	/// every leaf must have run once, sum must match serial sum
+
+	PCTThreadPool	pool		= CTThreadPoolDefault();
+	UINT32			BRANCHES	= __CTB_POOL_TASKS / __CTB_POOL_TASK_FANOUT;
+
+	CTB_CHECK(pool != NULL);
+
+	LONG64 expectedSum = 0;
+	for (UINT32 index = 1; index <= __CTB_POOL_TASKS; index++)
+		expectedSum += __HCTBPoolHash(index);
+
+	__CTBPoolTaskJob job = { 0 };
+
+	UINT64 START_USEC = CTClockUsec();
+
+	CTTaskGroup group;
+	CTTaskGroupBegin(pool, &group);
+	for (UINT32 branchIndex = 0; branchIndex < BRANCHES; branchIndex++)
+		CTTaskGroupSpawn(&group, __HCTBPoolBranchTask, &job);
+	CTTaskGroupWait(&group);
+
+	UINT64 elapsedUsec = max(CTClockUsec() - START_USEC, 1);
+
+	printf(
+		"    %u workers: %u tasks in %llu usec, %.0f tasks/sec, %.1f ns per task\n",
+		pool->workerCount,
+		__CTB_POOL_TASKS + BRANCHES,
+		elapsedUsec,
+		(__CTB_POOL_TASKS + BRANCHES) * 1000000.0 / elapsedUsec,
+		(elapsedUsec * 1000.0) / (__CTB_POOL_TASKS + BRANCHES)
+	);
+
+	CTB_CHECK(job.taskCount == __CTB_POOL_TASKS);
+	CTB_CHECK(job.sum == expectedSum);
+
+	return TRUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							PARALLEL FOR BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#define __CTB_PARALLEL_FOR_COUNT	0x100000
+
+static void __HCTBParallelForRange(INT64 indexBegin, INT64 indexEnd, PUINT32 values) {
+	for (INT64 index = indexBegin; index < indexEnd; index++)
+		values[index] = __HCTBPoolHash((UINT32)index);
+}
+
+BOOL	CTBBenchParallelFor(void) {
+
+	/// SUMMARY:
+	/// time serial run as the baseline
+	/// loop (grain sizes)
+	///		time CTParallelFor over the same range
+	///		print usec and speedup over serial
+	///		result must match the serial result
+
+	INT64	grains[]		= { 0x40, 0x400, 0x4000, 0x40000 };
+	SIZE_T	VALUES_BYTES	= sizeof(UINT32) * __CTB_PARALLEL_FOR_COUNT;
+	PUINT32	serialValues	= CTAllocUninit(VALUES_BYTES);
+	PUINT32	values			= CTAllocUninit(VALUES_BYTES);
+	UINT32	mismatchCount	= 0;
+
+	UINT64 START_USEC = CTClockUsec();
+	__HCTBParallelForRange(0, __CTB_PARALLEL_FOR_COUNT, serialValues);
+	UINT64 serialUsec = max(CTClockUsec() - START_USEC, 1);
+
+	printf(
+		"    %u workers, serial: %7llu usec\n",
+		CTThreadPoolDefault() ? CTThreadPoolDefault()->workerCount : 0,
+		serialUsec
+	);
+
+	for (UINT32 grainIndex = 0; grainIndex < sizeof(grains) / sizeof(grains[0]); grainIndex++) {
+		__stosb((PBYTE)values, 0, VALUES_BYTES);
+
+		START_USEC = CTClockUsec();
+		CTParallelFor(0, __CTB_PARALLEL_FOR_COUNT, grains[grainIndex], __HCTBParallelForRange, values);
+		UINT64 parallelUsec = max(CTClockUsec() - START_USEC, 1);
+
+		printf(
+			"    grain %6lld: %7llu usec, %.2fx serial\n",
+			grains[grainIndex],
+			parallelUsec,
+			(double)serialUsec / parallelUsec
+		);
+
+		if (memcmp(values, serialValues, VALUES_BYTES) != 0)
+			mismatchCount++;
+	}
+
+	CTFree(values);
+	CTFree(serialValues);
+
+	CTB_CHECK(mismatchCount == 0);
+
+	return TRUE;
+}
@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb_queue.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ctb.h"
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							QUEUE ENQUEUE BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// thread 0 is the consumer and drains in batches, every other thread is a
+/// producer timing each CTQueueEnqueue. the ring is kept small enough that
+/// producers sometimes spill into the overflow segments, which are part of
+/// the latency a producer sees
+
+#define __CTB_QUEUE_PRODUCERS_MAX	0x10
+#define __CTB_QUEUE_ENQUEUES		0x4000
+#define __CTB_QUEUE_CAPACITY		0x400
+#define __CTB_QUEUE_BATCH			0x100
+
+typedef struct __CTBQueueElement {
+	UINT32	producerIndex;
+	UINT32	sequence;
+} __CTBQueueElement, *P__CTBQueueElement;
+
+typedef struct __CTBQueueJob {
+	PCTQueue		queue;
+	UINT32			producerCount;
+	PUINT64			samples;
+	volatile LONG	orderErrors;
+} __CTBQueueJob, *P__CTBQueueJob;
+
+static void __HCTBQueueConsume(P__CTBQueueJob job) {
+
+	/// SUMMARY:
+	/// loop (until every producer's elements arrived)
+	///		dequeue batch, yield if empty
+	///		each element must be the next sequence of its producer
+
+	__CTBQueueElement	batch			[__CTB_QUEUE_BATCH];
+	UINT32				nextSequence	[__CTB_QUEUE_PRODUCERS_MAX] = { 0 };
+	UINT64				TOTAL_COUNT		= (UINT64)job->producerCount * __CTB_QUEUE_ENQUEUES;
+	UINT64				receivedCount	= 0;
+	LONG				orderErrors		= 0;
+
+	while (receivedCount < TOTAL_COUNT) {
+		UINT32 batchCount = CTQueueDequeueBatch(job->queue, batch, __CTB_QUEUE_BATCH);
+		if (batchCount == 0) {
+			SwitchToThread();
+			continue;
+		}
+
+		for (UINT32 batchIndex = 0; batchIndex < batchCount; batchIndex++) {
+			P__CTBQueueElement element = batch + batchIndex;
+			if (element->producerIndex >= job->producerCount ||
+				element->sequence != nextSequence[element->producerIndex]) {
+				orderErrors++;
+				continue;
+			}
+			nextSequence[element->producerIndex]++;
+		}
+		receivedCount += batchCount;
+	}
+
+	job->orderErrors = orderErrors;
+}
+
+static void __HCTBQueueThread(UINT32 threadIndex, P__CTBQueueJob job) {
+	if (threadIndex == 0) {
+		__HCTBQueueConsume(job);
+		return;
+	}
+
+	UINT32	producerIndex	= threadIndex - 1;
+	PUINT64	samples			= job->samples + ((SIZE_T)producerIndex * __CTB_QUEUE_ENQUEUES);
+
+	for (UINT32 sequence = 0; sequence < __CTB_QUEUE_ENQUEUES; sequence++) {
+		__CTBQueueElement element = { producerIndex, sequence };
+
+		UINT64 START_TICKS = CTClockTicks();
+		CTQueueEnqueue(job->queue, &element);
+		samples[sequence] = CTClockTicks() - START_TICKS;
+	}
+}
+
+BOOL	CTBBenchQueue(void) {
+
+	/// SUMMARY:
+	/// loop (1, 2, 4, 8, 16 producers)
+	///		run consumer and producers on a fresh queue
+	///		convert samples to nsec, print p50, p99 and max
+	/// every element must have arrived once and in producer order
+
+	UINT32	producerCounts[]	= { 1, 2, 4, 8, 16 };
+	PUINT64	samples				= CTAllocUninit(sizeof(UINT64) * __CTB_QUEUE_PRODUCERS_MAX * __CTB_QUEUE_ENQUEUES);
+	LONG	orderErrors			= 0;
+
+	for (UINT32 countIndex = 0; countIndex < sizeof(producerCounts) / sizeof(producerCounts[0]); countIndex++) {
+		__CTBQueueJob job	= { 0 };
+		job.queue			= CTQueueCreate(sizeof(__CTBQueueElement), __CTB_QUEUE_CAPACITY);
+		job.producerCount	= producerCounts[countIndex];
+		job.samples			= samples;
+
+		CTBRunThreads(job.producerCount + 1, __HCTBQueueThread, &job);
+
+		UINT32 sampleCount = job.producerCount * __CTB_QUEUE_ENQUEUES;
+		for (UINT32 sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++)
+			samples[sampleIndex] = CTClockTicksToNsec(samples[sampleIndex]);
+
+		printf(
+			"    %2u producers: p50 %6llu ns, p99 %7llu ns, max %9llu ns\n",
+			job.producerCount,
+			CTBPercentile(samples, sampleCount, 50),
+			CTBPercentile(samples, sampleCount, 99),
+			CTBPercentile(samples, sampleCount, 100)
+		);
+
+		orderErrors += job.orderErrors;
+		CTQueueDestroy(&job.queue);
+	}
+
+	CTFree(samples);
+
+	CTB_CHECK(orderErrors == 0);
+
+	return TRUE;
+}
@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb_texture.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ctb.h"
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							TEXTURE SAMPLING BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// random texel reads from a sprite-like source (runs of clear and opaque
+/// texels) in BGRA and RLE. the walk control reads RLE the way CTTextureGet
+/// did before the run table, stepping over every run left of x, so its
+/// cost grows with the row's run count while the run table search does not
+
+#define __CTB_TEXTURE_SIZE			0x400
+#define __CTB_TEXTURE_RUN_MAX		0x40
+#define __CTB_TEXTURE_SAMPLE_COUNT	0x100000
+#define __CTB_TEXTURE_RLE_LITERAL	0x80
+
+typedef CTColor (*__PCTBFUNCSAMPLE)(PCTTexture texture, UINT32 x, UINT32 y);
+
+static CTColor __HCTBTextureWalkRLE(PCTTexture texture, UINT32 x, UINT32 y) {
+
+	PBYTE	run			= texture->data + texture->rowOffsets[texture->height - y - 1];
+	UINT32	runStart	= 0;
+
+	while (TRUE) {
+		BYTE	op			= run[0];
+		UINT32	runLength	= (op & ~__CTB_TEXTURE_RLE_LITERAL) + 1;
+
+		if (x < runStart + runLength) {
+			if (op & __CTB_TEXTURE_RLE_LITERAL)
+				return ((PCTColor)(run + 1))[x - runStart];
+			break;
+		}
+
+		runStart	+= runLength;
+		run			+= 1 + ((op & __CTB_TEXTURE_RLE_LITERAL) ? sizeof(CTColor) * runLength : 0);
+	}
+
+	CTColor clear = { 0 };
+	return clear;
+}
+
+static void __HCTBTextureSampleRun(
+	PCHAR				label,
+	PCTTexture			texture,
+	__PCTBFUNCSAMPLE	sample,
+	PUINT32				coords,
+	PUINT32				results) {
+
+	/// SUMMARY:
+	/// time reading every sample coordinate, keeping every texel read
+	/// print ns per sample
+
+	UINT64 START_USEC = CTClockUsec();
+	for (UINT32 sampleIndex = 0; sampleIndex < __CTB_TEXTURE_SAMPLE_COUNT; sampleIndex++) {
+		UINT32	coord			= coords[sampleIndex];
+		CTColor	texel			= sample(texture, coord & 0xFFFF, coord >> 16);
+		results[sampleIndex]	= *(PUINT32)&texel;
+	}
+	UINT64 totalUsec = CTClockUsec() - START_USEC;
+
+	printf(
+		"    %-16s %7llu usec, %6.1f ns per sample\n",
+		label,
+		totalUsec,
+		(totalUsec * 1000.0) / __CTB_TEXTURE_SAMPLE_COUNT
+	);
+}
+
+BOOL	CTBBenchTextureSample(void) {
+
+	/// SUMMARY:
+	/// fill source with rows of random length runs, clear or opaque
+	/// create BGRA and RLE textures from it
+	/// every RLE texel must match the BGRA texel
+	/// pick random sample coordinates
+	/// time BGRA reads, RLE reads through the run table and RLE walks
+	/// every sampled texel must match across the three
+
+	PCTFB	source	= CTFrameBufferCreate(__CTB_TEXTURE_SIZE, __CTB_TEXTURE_SIZE);
+	UINT32	seed	= 0x9E3779B9u;
+
+	for (UINT32 memRow = 0; memRow < __CTB_TEXTURE_SIZE; memRow++) {
+		UINT32	column	= 0;
+		BOOL	clear	= FALSE;
+		while (column < __CTB_TEXTURE_SIZE) {
+			seed = seed * 1664525u + 1013904223u;
+			UINT32 runEnd = min(__CTB_TEXTURE_SIZE, column + 1 + ((seed >> 8) % __CTB_TEXTURE_RUN_MAX));
+			for (; column < runEnd; column++) {
+				seed = seed * 1664525u + 1013904223u;
+				UINT32 packed = clear ? 0 : (seed | 0xFF000000u);
+				*(PUINT32)&source->color[column + (memRow * __CTB_TEXTURE_SIZE)] = packed;
+			}
+			clear = !clear;
+		}
+	}
+
+	PCTTexture bgra	= CTTextureCreate(source, CT_TEXTURE_FORMAT_BGRA);
+	PCTTexture rle	= CTTextureCreate(source, CT_TEXTURE_FORMAT_RLE);
+	CTFrameBufferDestroy(&source);
+	CTB_CHECK(bgra != NULL);
+	CTB_CHECK(rle != NULL);
+
+	UINT32 mismatchCount = 0;
+	for (UINT32 y = 0; y < __CTB_TEXTURE_SIZE; y++) {
+		for (UINT32 x = 0; x < __CTB_TEXTURE_SIZE; x++) {
+			CTColor expected	= CTTextureGet(bgra, x, y);
+			CTColor texel		= CTTextureGet(rle, x, y);
+			if (*(PUINT32)&expected != *(PUINT32)&texel) mismatchCount++;
+		}
+	}
+
+	PUINT32 coords		= CTAllocUninit(sizeof(UINT32) * __CTB_TEXTURE_SAMPLE_COUNT);
+	PUINT32 bgraTexels	= CTAllocUninit(sizeof(UINT32) * __CTB_TEXTURE_SAMPLE_COUNT);
+	PUINT32 rleTexels	= CTAllocUninit(sizeof(UINT32) * __CTB_TEXTURE_SAMPLE_COUNT);
+	PUINT32 walkTexels	= CTAllocUninit(sizeof(UINT32) * __CTB_TEXTURE_SAMPLE_COUNT);
+
+	for (UINT32 sampleIndex = 0; sampleIndex < __CTB_TEXTURE_SAMPLE_COUNT; sampleIndex++) {
+		seed = seed * 1664525u + 1013904223u;
+		coords[sampleIndex] = ((seed >> 4) % __CTB_TEXTURE_SIZE) | (((seed >> 20) % __CTB_TEXTURE_SIZE) << 16);
+	}
+
+	printf(
+		"    %ux%u, %u runs, RLE %llu bytes (BGRA %llu bytes)\n",
+		__CTB_TEXTURE_SIZE,
+		__CTB_TEXTURE_SIZE,
+		rle->rowRuns[rle->height],
+		(UINT64)rle->sizeBytes,
+		(UINT64)bgra->sizeBytes
+	);
+	__HCTBTextureSampleRun("BGRA", bgra, CTTextureGet, coords, bgraTexels);
+	__HCTBTextureSampleRun("RLE run table", rle, CTTextureGet, coords, rleTexels);
+	__HCTBTextureSampleRun("RLE walk", rle, __HCTBTextureWalkRLE, coords, walkTexels);
+
+	UINT32 sampleMismatchCount = 0;
+	for (UINT32 sampleIndex = 0; sampleIndex < __CTB_TEXTURE_SAMPLE_COUNT; sampleIndex++) {
+		if (rleTexels[sampleIndex] != bgraTexels[sampleIndex]) sampleMismatchCount++;
+		if (walkTexels[sampleIndex] != bgraTexels[sampleIndex]) sampleMismatchCount++;
+	}
+
+	CTFree(coords);
+	CTFree(bgraTexels);
+	CTFree(rleTexels);
+	CTFree(walkTexels);
+	CTTextureDestroy(&bgra);
+	CTTextureDestroy(&rle);
+
+	CTB_CHECK(mismatchCount == 0);
+	CTB_CHECK(sampleMismatchCount == 0);
+
+	return TRUE;
+}
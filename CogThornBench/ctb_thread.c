@@ -0,0 +1,264 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ctb_thread.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ctb.h"
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							TASK LATENCY BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// tasks are posted to a thread spinning every 10 ms, at random points in
+/// its spin, and time themselves from submit to run. the control run
+/// creates the thread with CT_THREAD_FLAG_TASK_NO_WAKE, so tasks wait for
+/// the end of the next spin as they did before wakeups (p50 about half the
+/// interval). woken on submit, the latency is the OS wake latency
+
+#define __CTB_TASK_SPIN_USEC		10000
+#define __CTB_TASK_COUNT			0x100
+#define __CTB_TASK_SYNC_COUNT		0x40
+#define __CTB_TASK_GAP_MSEC_MAX		10
+
+typedef struct __CTBTaskSlot {
+	UINT64	submitTicks;
+	UINT64	runTicks;
+} __CTBTaskSlot, *P__CTBTaskSlot;
+
+static void __HCTBTaskIdleProc(UINT32 reason, PVOID thread, PVOID threadData, PVOID input) {
+	return;
+}
+
+static void __HCTBTaskStamp(PVOID thread, PVOID threadData, P__CTBTaskSlot slot) {
+	slot->runTicks = CTClockTicks();
+}
+
+static void __HCTBTaskNothing(PVOID thread, PVOID threadData, PVOID input) {
+	return;
+}
+
+static void __HCTBTaskPrint(PCHAR label, PUINT64 samples, UINT32 sampleCount) {
+	printf(
+		"    %-24s p50 %6llu usec, p99 %6llu usec, max %6llu usec\n",
+		label,
+		CTBPercentile(samples, sampleCount, 50),
+		CTBPercentile(samples, sampleCount, 99),
+		CTBPercentile(samples, sampleCount, 100)
+	);
+}
+
+static BOOL __HCTBTaskLatencyRun(UINT32 threadFlags) {
+
+	/// SUMMARY:
+	/// start an idle thread spinning every 10 ms
+	/// loop (async tasks)
+	///		sleep a random part of the interval, stamp and post task
+	/// post a sync task so every async task has run
+	/// time a run of sync tasks from call to return
+	/// print async and sync p50/p99/max and the thread's own histogram
+	/// every async task must have run
+
+	__CTBTaskSlot	slots	[__CTB_TASK_COUNT]		= { 0 };
+	UINT64			samples	[__CTB_TASK_COUNT];
+	UINT32			seed	= 0x6A09E667u;
+	PCHAR			MODE	= (threadFlags & CT_THREAD_FLAG_TASK_NO_WAKE) ? "spin drain" : "wake on submit";
+	CHAR			label	[0x40];
+
+	PCTThread thread = CTThreadCreateEx(
+		__HCTBTaskIdleProc,
+		0,
+		NULL,
+		__CTB_TASK_SPIN_USEC,
+		threadFlags,
+		TRUE
+	);
+	CTB_CHECK(thread != NULL);
+
+	CTThreadLatencyStats stats = { 0 };
+	CTThreadTaskLatency(thread, &stats, TRUE);
+
+	for (UINT32 taskIndex = 0; taskIndex < __CTB_TASK_COUNT; taskIndex++) {
+		seed = seed * 1664525u + 1013904223u;
+		Sleep((seed >> 8) % __CTB_TASK_GAP_MSEC_MAX);
+
+		slots[taskIndex].submitTicks = CTClockTicks();
+		CTThreadTask(thread, __HCTBTaskStamp, slots + taskIndex, FALSE);
+	}
+	CTThreadTask(thread, __HCTBTaskNothing, NULL, TRUE);
+
+	UINT32 missingCount = 0;
+	for (UINT32 taskIndex = 0; taskIndex < __CTB_TASK_COUNT; taskIndex++) {
+		if (slots[taskIndex].runTicks == 0) {
+			missingCount++;
+			samples[taskIndex] = 0;
+			continue;
+		}
+		samples[taskIndex] = CTClockTicksToUsec(slots[taskIndex].runTicks - slots[taskIndex].submitTicks);
+	}
+	sprintf_s(label, sizeof(label), "%s, async", MODE);
+	__HCTBTaskPrint(label, samples, __CTB_TASK_COUNT);
+
+	for (UINT32 taskIndex = 0; taskIndex < __CTB_TASK_SYNC_COUNT; taskIndex++) {
+		seed = seed * 1664525u + 1013904223u;
+		Sleep((seed >> 8) % __CTB_TASK_GAP_MSEC_MAX);
+
+		UINT64 START_TICKS = CTClockTicks();
+		CTThreadTask(thread, __HCTBTaskNothing, NULL, TRUE);
+		samples[taskIndex] = CTClockTicksToUsec(CTClockTicks() - START_TICKS);
+	}
+	sprintf_s(label, sizeof(label), "%s, sync", MODE);
+	__HCTBTaskPrint(label, samples, __CTB_TASK_SYNC_COUNT);
+
+	CTThreadTaskLatency(thread, &stats, FALSE);
+	printf(
+		"    %-24s %llu tasks, p50 <= %llu usec, p99 <= %llu usec, max %llu usec\n",
+		"thread histogram",
+		stats.sampleCount,
+		stats.p50Usec,
+		stats.p99Usec,
+		stats.maxUsec
+	);
+
+	CTThreadDestroy(&thread);
+
+	CTB_CHECK(missingCount == 0);
+	CTB_CHECK(stats.sampleCount >= __CTB_TASK_COUNT + __CTB_TASK_SYNC_COUNT);
+
+	return TRUE;
+}
+
+BOOL	CTBBenchTaskLatency(void) {
+	if (__HCTBTaskLatencyRun(CT_THREAD_FLAG_TASK_NO_WAKE) == FALSE) return FALSE;
+	if (__HCTBTaskLatencyRun(0) == FALSE) return FALSE;
+	return TRUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///							PACE JITTER BENCHMARK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// the same 40 Hz thread with 2-8 ms of work per spin is run unpaced and
+/// paced. every spin's start is compared with the ideal deadline counted
+/// from the first spin, so late starts which add up over frames show as
+/// drift and a lower rate, not just as jitter
+
+#define __CTB_PACE_INTERVAL_USEC	25000
+#define __CTB_PACE_SPINS			0x80
+#define __CTB_PACE_WORK_USEC_MIN	2000
+#define __CTB_PACE_WORK_USEC_MAX	8000
+
+typedef struct __CTBPaceJob {
+	UINT64			spinStartUsec	[__CTB_PACE_SPINS];
+	volatile LONG	spinCount;
+	UINT32			seed;
+} __CTBPaceJob, *P__CTBPaceJob;
+
+static void __HCTBPaceProc(UINT32 reason, PVOID thread, P__CTBPaceJob* threadData, P__CTBPaceJob input) {
+
+	/// SUMMARY:
+	/// on init keep job in thread data
+	/// on spin
+	///		note spin start
+	///		busy-work for a random 2-8 ms
+
+	if (reason == CT_THREADPROC_REASON_INIT) {
+		*threadData = input;
+		return;
+	}
+	if (reason != CT_THREADPROC_REASON_SPIN)
+		return;
+
+	P__CTBPaceJob	job			= *threadData;
+	UINT64			SPIN_START	= CTClockUsec();
+
+	if (job->spinCount >= __CTB_PACE_SPINS)
+		return;
+	job->spinStartUsec[job->spinCount] = SPIN_START;
+
+	job->seed = job->seed * 1664525u + 1013904223u;
+	CTClockSpinUntil(
+		SPIN_START + __CTB_PACE_WORK_USEC_MIN +
+		(job->seed >> 8) % (__CTB_PACE_WORK_USEC_MAX - __CTB_PACE_WORK_USEC_MIN)
+	);
+
+	InterlockedIncrement(&job->spinCount);
+}
+
+static BOOL __HCTBPaceRun(UINT32 threadFlags) {
+
+	/// SUMMARY:
+	/// run thread until enough spins were noted, then destroy it
+	/// rate and drift from first to last spin start
+	/// deviation of every spin start from its ideal deadline
+	/// print rate, drift, p50/p99/max deviation and, if paced, the
+	/// thread's own jitter histogram
+
+	P__CTBPaceJob job	= CTAlloc(sizeof(*job));
+	job->seed			= 0xBB67AE85u;
+
+	PCTThread thread = CTThreadCreateEx(
+		__HCTBPaceProc,
+		sizeof(P__CTBPaceJob),
+		job,
+		__CTB_PACE_INTERVAL_USEC,
+		threadFlags,
+		TRUE
+	);
+	CTB_CHECK(thread != NULL);
+
+	while (job->spinCount < __CTB_PACE_SPINS)
+		Sleep(__CTB_PACE_INTERVAL_USEC / 1000);
+
+	CTThreadLatencyStats stats = { 0 };
+	CTThreadPaceJitter(thread, &stats, FALSE);
+	CTThreadDestroy(&thread);
+
+	UINT64	FIRST_USEC		= job->spinStartUsec[0];
+	UINT64	ELAPSED_USEC	= job->spinStartUsec[__CTB_PACE_SPINS - 1] - FIRST_USEC;
+	INT64	driftUsec		= (INT64)ELAPSED_USEC - (INT64)(__CTB_PACE_SPINS - 1) * __CTB_PACE_INTERVAL_USEC;
+
+	UINT64 deviations[__CTB_PACE_SPINS];
+	for (UINT32 spinIndex = 0; spinIndex < __CTB_PACE_SPINS; spinIndex++) {
+		INT64 deviation			= (INT64)(job->spinStartUsec[spinIndex] - FIRST_USEC) - (INT64)spinIndex * __CTB_PACE_INTERVAL_USEC;
+		deviations[spinIndex]	= (UINT64)(deviation < 0 ? -deviation : deviation);
+	}
+
+	printf(
+		"    %-7s %6.2f Hz, drift %7lld usec, deadline deviation p50 %6llu usec, p99 %6llu usec, max %6llu usec\n",
+		(threadFlags & CT_THREAD_FLAG_PACED) ? "paced" : "unpaced",
+		(__CTB_PACE_SPINS - 1) * 1000000.0 / max(ELAPSED_USEC, 1),
+		driftUsec,
+		CTBPercentile(deviations, __CTB_PACE_SPINS, 50),
+		CTBPercentile(deviations, __CTB_PACE_SPINS, 99),
+		CTBPercentile(deviations, __CTB_PACE_SPINS, 100)
+	);
+	if (threadFlags & CT_THREAD_FLAG_PACED) {
+		printf(
+			"    thread jitter: %llu spins, p50 <= %llu usec, p99 <= %llu usec, max %llu usec\n",
+			stats.sampleCount,
+			stats.p50Usec,
+			stats.p99Usec,
+			stats.maxUsec
+		);
+	}
+
+	CTFree(job);
+
+	if (threadFlags & CT_THREAD_FLAG_PACED)
+		CTB_CHECK(stats.sampleCount >= __CTB_PACE_SPINS - 1);
+
+	return TRUE;
+}
+
+BOOL	CTBBenchPaceJitter(void) {
+	if (__HCTBPaceRun(0) == FALSE) return FALSE;
+	if (__HCTBPaceRun(CT_THREAD_FLAG_PACED) == FALSE) return FALSE;
+	return TRUE;
+}
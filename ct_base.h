@@ -16,6 +16,7 @@
 #endif
 
 #include <Windows.h>
+#include <intrin.h>
 
 //////////////////////////////////////////////////////////////////////////////
 ///
@@ -23,10 +24,101 @@
 /// 
 //////////////////////////////////////////////////////////////////////////////
 
+/// allocations up to 2KB come from power-of-two size class slabs. each
+/// thread caches freed slots per class and trades them with the shared
+/// free lists in batches, so most CTAlloc/CTFree calls take no lock.
+/// larger allocations go straight to the heap. every block has a small
+/// header holding its size, class and memory tag. CTAllocUninit skips zeroing
+///
+/// every allocation (CTGFXAlloc included) is accounted against a memory
+/// tag. each thread keeps its own pending counters and only publishes them
+/// to the shared totals once they pass a threshold, so accounting costs no
+/// atomics on most calls. CTMemoryReport sums shared and pending counters.
+/// high-water marks are exact to within the publish threshold per thread
+
+#define CT_ALLOC_CLASS_MIN_SHIFT	4
+#define CT_ALLOC_CLASS_COUNT		8
+#define CT_ALLOC_CLASS_MAX_SIZE		(1 << (CT_ALLOC_CLASS_MIN_SHIFT + CT_ALLOC_CLASS_COUNT - 1))
+#define CT_ALLOC_CLASS_LARGE		0xFFFFFFFF
+#define CT_ALLOC_SLAB_SIZE			0x10000
+#define CT_ALLOC_CACHE_MAX			64
+#define CT_ALLOC_CACHE_BATCH		32
+
+#define CT_MEMORY_TAG_USER			0
+#define CT_MEMORY_TAG_BASE			1
+#define CT_MEMORY_TAG_DYNLIST		2
+#define CT_MEMORY_TAG_LOGGING		3
+#define CT_MEMORY_TAG_GFX			4
+#define CT_MEMORY_TAG_FRAMEBUFFER	5
+#define CT_MEMORY_TAG_TEXTURE		6
+#define CT_MEMORY_TAG_MESH			7
+#define CT_MEMORY_TAG_COUNT			8
+#define CT_MEMORY_PUBLISH_BYTES		0x10000
+#define CT_MEMORY_PUBLISH_COUNT		64
+
+typedef struct CTMemoryTagStats {
+	SIZE_T	liveBytes;
+	SIZE_T	liveCount;
+	SIZE_T	peakBytes;
+} CTMemoryTagStats, *PCTMemoryTagStats;
+
+typedef struct CTMemoryStats {
+	CTMemoryTagStats	tags [CT_MEMORY_TAG_COUNT];
+	SIZE_T				liveBytes;
+	SIZE_T				liveCount;
+	SIZE_T				peakBytes;
+} CTMemoryStats, *PCTMemoryStats;
+
 CTCALL	PVOID	CTAlloc(SIZE_T sizeBytes);
+CTCALL	PVOID	CTAllocUninit(SIZE_T sizeBytes);
+CTCALL	PVOID	CTAllocEx(SIZE_T sizeBytes, UINT32 tag, BOOL zeroMemory);
 CTCALL	void	CTFree(PVOID ptr);
 CTCALL	SIZE_T	CTAllocCount(void);
 CTCALL	SIZE_T	CTAllocSizeBytes(void);
+CTCALL	void	CTAllocThreadCacheFlush(void);
+CTCALL	BOOL	CTMemoryReport(PCTMemoryStats statsOut);
+CTCALL	PCHAR	CTMemoryTagName(UINT32 tag);
+void	__CTAllocInit(void);
+void	__CTAllocCleanup(void);
+void	__CTMemoryAccount(UINT32 tag, SSIZE_T sizeBytes, SSIZE_T count);
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								ARENA
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// an arena hands out zeroed memory by bumping a pointer and only gives it
+/// back all at once on reset. blocks are kept across resets, so an arena in
+/// steady state makes no heap calls. every CTThread owns a frame arena which
+/// is reset before each spin; CTArenaFrameGet returns it (or NULL on threads
+/// which have none bound). frame arena memory must not outlive the spin
+
+#define CT_ARENA_BLOCK_SIZE_DEFAULT	0x10000
+#define CT_ARENA_ALIGNMENT			0x10
+
+typedef struct CTArenaBlock {
+	PVOID	nextBlock;
+	SIZE_T	sizeBytes;
+	SIZE_T	usedBytes;
+	PBYTE	data;
+} CTArenaBlock, *PCTArenaBlock;
+
+typedef struct CTArena {
+	PCTArenaBlock	blockFirst;
+	PCTArenaBlock	blockLast;
+	PCTArenaBlock	blockCurrent;
+	SIZE_T			blockSizeBytes;
+	SIZE_T			allocBytes;
+	SIZE_T			peakAllocBytes;
+} CTArena, *PCTArena;
+
+CTCALL	PCTArena	CTArenaCreate(SIZE_T blockSizeBytes);
+CTCALL	BOOL		CTArenaDestroy(PCTArena* pArena);
+CTCALL	PVOID		CTArenaAlloc(PCTArena arena, SIZE_T sizeBytes);
+CTCALL	BOOL		CTArenaReset(PCTArena arena);
+CTCALL	PCTArena	CTArenaFrameGet(void);
+CTCALL	BOOL		CTArenaFrameSet(PCTArena arena);
 
 //////////////////////////////////////////////////////////////////////////////
 ///
@@ -70,6 +162,9 @@ CTCALL	void		CTErrorAddCallback(PCTFUNCERRORCALLBACK pfErrCallback);
 typedef struct CTFile {
 	CHAR	fileName [CT_FILENAME_MAX_LENGTH];
 	HANDLE	hFile;
+	HANDLE	hMapping;
+	PVOID	mapView;
+	SIZE_T	mapSize;
 } CTFile, *PCTFile;
 
 CTCALL	BOOL		CTFileExists(PCHAR path);
@@ -80,6 +175,8 @@ CTCALL	BOOL		CTFileClose(PCTFile* pFile);
 CTCALL	SIZE_T		CTFileSize(PCTFile file);
 CTCALL	BOOL		CTFileRead(PCTFile file, PVOID buffer, SIZE_T offset, SIZE_T sizeBytes);
 CTCALL	BOOL		CTFileWrite(PCTFile file, PVOID buffer, SIZE_T offset, SIZE_T sizeBytes);
+CTCALL	PVOID		CTFileMap(PCTFile file);
+CTCALL	BOOL		CTFileUnmap(PCTFile file);
 
 //////////////////////////////////////////////////////////////////////////////
 ///
@@ -96,47 +193,257 @@ CTCALL	BOOL		CTLockDestroy(PCTLock* pLock);
 CTCALL	BOOL		CTLockEnter(PCTLock lock);
 CTCALL	BOOL		CTLockLeave(PCTLock lock);
 
+//////////////////////////////////////////////////////////////////////////////
+///
+///								CLOCK
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// thin layer over the performance counter. tick conversions split off
+/// whole seconds first, so they stay exact and never overflow. timestamps
+/// are only meaningful relative to each other. CTClockSpinUntil busy waits
+/// and is meant for the last stretch of a wait which must end on time
+
+#define CT_CLOCK_SPIN_PAUSES	0x20
+
+CTCALL	UINT64		CTClockFrequency(void);
+CTCALL	UINT64		CTClockTicks(void);
+CTCALL	UINT64		CTClockTicksToUsec(UINT64 ticks);
+CTCALL	UINT64		CTClockTicksToNsec(UINT64 ticks);
+CTCALL	UINT64		CTClockUsec(void);
+CTCALL	UINT64		CTClockNsec(void);
+CTCALL	void		CTClockSpinUntil(UINT64 deadlineUsec);
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								EPOCH RECLAMATION
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// readers wrap any lock-free walk of shared data in CTEpochEnter/Leave
+/// (calls nest). writers tag what they unlink with CTEpochCurrent and only
+/// free it once CTEpochSafe returns TRUE for that tag, which happens after
+/// every thread that was reading at the time has left. CTEpochSafe also tries
+/// to move the global epoch forward, so polling writers drive reclamation.
+/// threads which read call CTEpochThreadRelease before they exit so their
+/// record can be reused
+
+#define CT_EPOCH_GRACE_PERIODS	2
+
+CTCALL	BOOL		CTEpochEnter(void);
+CTCALL	BOOL		CTEpochLeave(void);
+CTCALL	UINT64		CTEpochCurrent(void);
+CTCALL	BOOL		CTEpochSafe(UINT64 epoch);
+CTCALL	void		CTEpochThreadRelease(void);
+void	__CTEpochInit(void);
+void	__CTEpochCleanup(void);
+
 //////////////////////////////////////////////////////////////////////////////
 ///
 ///								DYNAMIC LIST
 /// 
 //////////////////////////////////////////////////////////////////////////////
 
+/// every node keeps a stack of its free element indices, and nodes with at
+/// least one free element are linked into the list's free node chain, so
+/// CTDynListAdd never has to scan. every element is preceded by a small slot
+/// header naming its node and index, so CTDynListRemove never has to scan.
+/// elements are 16 byte aligned and slotSizeBytes apart. slot occupancy is
+/// a bitset of 64 bit words, iteration skips whole empty words at a time.
+/// CTIteratorIterateBatch hands out up to maxCount elements per call
+///
+/// CTIteratorBegin/End drive an iterator which lives on the caller's stack.
+/// CTDynListForEach calls func on every element until func returns FALSE.
+/// CT_DYNLIST_FOREACH walks the node arrays inline with no calls at all; the
+/// caller must be inside CTDynListReadBegin/End. break only leaves the
+/// innermost of its loops, so use the callback form (or goto) to stop early
+///
+/// CTDynListParallelForEach cuts every node into chunks of about grainSize
+/// slots (coarser when that would give a thread more than a few chunks)
+/// and hands them out to pool workers and the calling thread. the list
+/// is held for reading by the caller for the whole walk, so func may touch
+/// its own element freely but must not add to or remove from the list.
+/// CTDynListParallelForEachEx takes the CTThreadPool to use instead of the
+/// default one; with NULL every chunk runs on the calling thread
+///
+/// lists created with CT_DYNLIST_FLAG_HANDLES give every element a handle
+/// (32 bit table index + 32 bit generation) which stays valid while the
+/// element moves. CTDynListCompact moves at most maxMoves elements out of
+/// the sparsest node into free slots elsewhere and frees the node once it is
+/// empty, so it can be run a little every frame. raw element pointers of a
+/// handle list are only valid until the next CTDynListCompact call
+///
+/// lists created with CT_DYNLIST_FLAG_EPOCH can be read without the lock.
+/// readers wrap their walk in CTDynListReadBegin/End (an epoch for these
+/// lists, the lock for all others) and writers still take the lock. an add
+/// only reserves its slot; the caller fills it in and calls CTDynListPublish
+/// before readers can see it (a reserved slot may also just be removed).
+/// removed slots and freed nodes are kept intact until every reader that
+/// could still hold them has left its epoch, so a reader may see an element
+/// which was just removed but never a reused one.
+/// epoch lists can not be compacted
+
+#define __CT_DYNLIST_SLOT_HEADER_SIZE	0x10
+#define __CT_DYNLIST_WORD_BITS			64
+
+#define CT_DYNLIST_PARALLEL_GRAIN_DEFAULT	0x400
+
+#define CT_DYNLIST_FLAG_HANDLES				0x01
+#define CT_DYNLIST_FLAG_EPOCH				0x02
+
+typedef UINT64 CTHandle, *PCTHandle;
+#define CT_HANDLE_NULL						0
+
+typedef BOOL (*PCTFUNCDYNLISTFOREACH)(PVOID element, PVOID input);
+
 typedef struct CTDynListNode {
+	PVOID	parent;
 	PBYTE	elements;
 	UINT32	elementUseCount;
-	UINT32	seekHead;
-	PBYTE	useField;
+	UINT32	freeCount;
+	PUINT32	freeStack;
+	PUINT64	useBits;
+	PUINT64	reserveBits;
 	PVOID	nextNode;
+	PVOID	nextFreeNode;
+	PVOID	prevFreeNode;
 } CTDynListNode, *PCTDynListNode;
 
 typedef struct CTDynList {
 	CRITICAL_SECTION	lock;
 	PCTDynListNode		nodeFirst;
 	PCTDynListNode		nodeLast;
+	PCTDynListNode		nodeFreeFirst;
+	PVOID				nodeTable;
+	UINT32				nodeTableCapacity;
 	UINT32				nodeCount;
 	SIZE_T				elementSizeBytes;
+	SIZE_T				slotSizeBytes;
 	UINT32				elementsPerNode;
 	UINT32				elementsUsedCount;
 	UINT32				elementsTotalCount;
+	UINT32				flags;
+	PVOID				handleTable;
+	UINT32				handleCapacity;
+	UINT32				handleUsedCount;
+	UINT32				handleFreeFirst;
+	PCTDynListNode		compactNode;
+	PVOID				retireList;
+	UINT32				retireCount;
+	UINT32				retireCapacity;
 } CTDynList, *PCTDynList;
 
 typedef struct CTIterator {
 	PCTDynList		parent;
 	PCTDynListNode	currentNode;
 	UINT32			currentNodeIndex;
+	PCTArena		arena;
 } CTIterator, *PCTIterator;
 
 CTCALL	PCTDynList	CTDynListCreate(SIZE_T elemSize, UINT32 elemsPerNode);
+CTCALL	PCTDynList	CTDynListCreateEx(SIZE_T elemSize, UINT32 elemsPerNode, UINT32 flags);
 CTCALL	BOOL		CTDynListDestroy(PCTDynList* pList);
 CTCALL	BOOL		CTDynListClear(PCTDynList list);
 CTCALL	BOOL		CTDynListLock(PCTDynList list);
 CTCALL	BOOL		CTDynListUnlock(PCTDynList list);
+CTCALL	BOOL		CTDynListReadBegin(PCTDynList list);
+CTCALL	BOOL		CTDynListReadEnd(PCTDynList list);
 CTCALL	PVOID		CTDynListAdd(PCTDynList list);
+CTCALL	BOOL		CTDynListPublish(PCTDynList list, PVOID element);
 CTCALL	BOOL		CTDynListRemove(PCTDynList list, PVOID element);
 CTCALL	BOOL		CTDynListClean(PCTDynList list);
+CTCALL	CTHandle	CTDynListAddHandle(PCTDynList list, PVOID* pElement);
+CTCALL	BOOL		CTDynListRemoveHandle(PCTDynList list, CTHandle handle);
+CTCALL	PVOID		CTDynListResolve(PCTDynList list, CTHandle handle);
+CTCALL	CTHandle	CTDynListHandleOf(PCTDynList list, PVOID element);
+CTCALL	UINT32		CTDynListCompact(PCTDynList list, UINT32 maxMoves);
 CTCALL	PCTIterator	CTIteratorCreate(PCTDynList list);
 CTCALL	BOOL		CTIteratorDestroy(PCTIterator* pIterator);
 CTCALL	PVOID		CTIteratorIterate(PCTIterator iterator);
+CTCALL	UINT32		CTIteratorIterateBatch(PCTIterator iterator, PVOID* elementsOut, UINT32 maxCount);
+CTCALL	BOOL		CTIteratorBegin(PCTDynList list, PCTIterator iterator);
+CTCALL	BOOL		CTIteratorEnd(PCTIterator iterator);
+CTCALL	BOOL		CTDynListForEach(PCTDynList list, PCTFUNCDYNLISTFOREACH func, PVOID input);
+CTCALL	BOOL		CTDynListParallelForEach(PCTDynList list, PCTFUNCDYNLISTFOREACH func, PVOID input, UINT32 grainSize);
+CTCALL	BOOL		CTDynListParallelForEachEx(PCTDynList list, PCTFUNCDYNLISTFOREACH func, PVOID input, UINT32 grainSize, PVOID threadPool);
+
+static __forceinline ULONG __CTDynListLowestBit(UINT64 word) {
+	ULONG bit;
+#ifdef _WIN64
+	_BitScanForward64(&bit, word);
+#else
+	if (_BitScanForward(&bit, (ULONG)word) == 0) {
+		_BitScanForward(&bit, (ULONG)(word >> 32));
+		bit += 32;
+	}
+#endif
+	return bit;
+}
+
+static __forceinline UINT32 __CTDynListWordCount(PCTDynList list) {
+	return (list->elementsPerNode + __CT_DYNLIST_WORD_BITS - 1) / __CT_DYNLIST_WORD_BITS;
+}
+
+static __forceinline PVOID __CTDynListElement(PCTDynList list, PCTDynListNode node, SIZE_T index) {
+	return node->elements + (index * list->slotSizeBytes) + __CT_DYNLIST_SLOT_HEADER_SIZE;
+}
+
+#define CT_DYNLIST_FOREACH(list, element)																		\
+	for (PCTDynListNode __ctNode = (list)->nodeFirst; __ctNode != NULL; __ctNode = __ctNode->nextNode)			\
+	for (UINT32 __ctWord = 0; __ctWord < __CTDynListWordCount(list); __ctWord++)								\
+	for (UINT64 __ctBits = __ctNode->useBits[__ctWord];															\
+		__ctBits != 0 && (((element) = __CTDynListElement((list), __ctNode,										\
+			(__ctWord * __CT_DYNLIST_WORD_BITS) + __CTDynListLowestBit(__ctBits))), TRUE);						\
+		__ctBits &= __ctBits - 1)
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								LOCK-FREE QUEUE
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// multi-producer single-consumer queue over one preallocated ring of
+/// cells. every cell carries a sequence number which tells producers and
+/// the consumer whose turn it is, so enqueue is a single compare-exchange
+/// and dequeue hands each cell back with one interlocked store (no
+/// compare-exchange). capacity is rounded up to a power of two.
+/// when the ring is full, producers spill into overflow segments of the
+/// same capacity which are linked behind the ring under overflowLock, so
+/// enqueue never fails and never waits on the consumer. this matters when
+/// the consumer thread enqueues into its own queue. while overflow is
+/// active new elements go to the overflow, and the consumer only reads it
+/// once the ring is empty, so elements from one producer stay in order.
+/// one drained segment is kept as a spare, the rest are freed.
+/// CTQueueEnqueueBegin/End let a producer build an element in place.
+/// only one thread may ever dequeue from a queue
+
+#define CT_QUEUE_CACHE_LINE_SIZE	0x40
+#define CT_QUEUE_CELL_HEADER_SIZE	0x10
+
+typedef struct CTQueue {
+	volatile LONG64		enqueuePos;
+	BYTE				enqueuePad [CT_QUEUE_CACHE_LINE_SIZE - sizeof(LONG64)];
+	volatile LONG64		dequeuePos;
+	BYTE				dequeuePad [CT_QUEUE_CACHE_LINE_SIZE - sizeof(LONG64)];
+	PBYTE				cells;
+	SIZE_T				elementSizeBytes;
+	SIZE_T				cellSizeBytes;
+	UINT32				capacity;
+	UINT32				capacityMask;
+	CRITICAL_SECTION	overflowLock;
+	volatile LONG		overflowActive;
+	volatile LONG		overflowCount;
+	PVOID				overflowHead;
+	PVOID				overflowTail;
+	PVOID				overflowSpare;
+} CTQueue, *PCTQueue;
+
+CTCALL	PCTQueue	CTQueueCreate(SIZE_T elemSize, UINT32 capacity);
+CTCALL	BOOL		CTQueueDestroy(PCTQueue* pQueue);
+CTCALL	BOOL		CTQueueEnqueue(PCTQueue queue, PVOID element);
+CTCALL	PVOID		CTQueueEnqueueBegin(PCTQueue queue);
+CTCALL	BOOL		CTQueueEnqueueEnd(PCTQueue queue, PVOID element);
+CTCALL	UINT32		CTQueueDequeueBatch(PCTQueue queue, PVOID elementsOut, UINT32 maxCount);
+CTCALL	UINT32		CTQueueCount(PCTQueue queue);
 
 #endif
@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_base_arena.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_base.h"
+
+#include <intrin.h>
+
+static __declspec(thread) PCTArena __ctFrameArena = NULL;
+
+static PCTArenaBlock __HCTArenaBlockCreate(SIZE_T sizeBytes) {
+	PCTArenaBlock block	= CTAllocEx(sizeof(*block) + sizeBytes + CT_ARENA_ALIGNMENT, CT_MEMORY_TAG_BASE, FALSE);
+	block->nextBlock	= NULL;
+	block->sizeBytes	= sizeBytes;
+	block->usedBytes	= 0;
+	block->data			= (PBYTE)(((UINT_PTR)(block + 1) + CT_ARENA_ALIGNMENT - 1) & ~((UINT_PTR)CT_ARENA_ALIGNMENT - 1));
+	return block;
+}
+
+CTCALL	PCTArena	CTArenaCreate(SIZE_T blockSizeBytes) {
+	if (blockSizeBytes == 0) {
+		CTErrorSetParamValue("CTArenaCreate failed: blockSizeBytes was 0");
+		return NULL;
+	}
+
+	PCTArena arena			= CTAllocEx(sizeof(*arena), CT_MEMORY_TAG_BASE, TRUE);
+	arena->blockSizeBytes	= blockSizeBytes;
+	arena->blockFirst		= __HCTArenaBlockCreate(blockSizeBytes);
+	arena->blockLast		= arena->blockFirst;
+	arena->blockCurrent		= arena->blockFirst;
+
+	return arena;
+}
+
+CTCALL	BOOL		CTArenaDestroy(PCTArena* pArena) {
+	if (pArena == NULL) {
+		CTErrorSetBadObject("CTArenaDestroy failed: pArena was NULL");
+		return FALSE;
+	}
+
+	PCTArena arena = *pArena;
+
+	if (arena == NULL) {
+		CTErrorSetBadObject("CTArenaDestroy failed: arena was NULL");
+		return FALSE;
+	}
+
+	if (__ctFrameArena == arena)
+		__ctFrameArena = NULL;
+
+	PCTArenaBlock block = arena->blockFirst;
+	while (block != NULL) {
+		PCTArenaBlock nextBlock = block->nextBlock;
+		CTFree(block);
+		block = nextBlock;
+	}
+
+	CTFree(arena);
+
+	*pArena = NULL;
+	return TRUE;
+}
+
+CTCALL	PVOID		CTArenaAlloc(PCTArena arena, SIZE_T sizeBytes) {
+	if (arena == NULL) {
+		CTErrorSetBadObject("CTArenaAlloc failed: arena was NULL");
+		return NULL;
+	}
+
+	/// SUMMARY:
+	/// round size up to alignment
+	/// walk forward from current block until one has room
+	/// if (no block has room)
+	///		append new block (at least large enough for this allocation)
+	/// bump block and zero the returned memory
+
+	SIZE_T alignedSize = (sizeBytes + CT_ARENA_ALIGNMENT - 1) & ~((SIZE_T)CT_ARENA_ALIGNMENT - 1);
+
+	PCTArenaBlock block = arena->blockCurrent;
+	while (block != NULL && block->usedBytes + alignedSize > block->sizeBytes) {
+		block = block->nextBlock;
+	}
+
+	if (block == NULL) {
+		block = __HCTArenaBlockCreate(max(arena->blockSizeBytes, alignedSize));
+		arena->blockLast->nextBlock = block;
+		arena->blockLast			= block;
+	}
+
+	arena->blockCurrent = block;
+
+	PBYTE ptr			= block->data + block->usedBytes;
+	block->usedBytes	+= alignedSize;
+
+	arena->allocBytes		+= alignedSize;
+	arena->peakAllocBytes	= max(arena->peakAllocBytes, arena->allocBytes);
+
+	__stosb(ptr, 0, sizeBytes);
+	return ptr;
+}
+
+CTCALL	BOOL		CTArenaReset(PCTArena arena) {
+	if (arena == NULL) {
+		CTErrorSetBadObject("CTArenaReset failed: arena was NULL");
+		return FALSE;
+	}
+
+	for (PCTArenaBlock block = arena->blockFirst; block != NULL; block = block->nextBlock) {
+		block->usedBytes = 0;
+	}
+
+	arena->blockCurrent	= arena->blockFirst;
+	arena->allocBytes	= 0;
+
+	return TRUE;
+}
+
+CTCALL	PCTArena	CTArenaFrameGet(void) {
+	return __ctFrameArena;
+}
+
+CTCALL	BOOL		CTArenaFrameSet(PCTArena arena) {
+	__ctFrameArena = arena;
+	return TRUE;
+}
@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_base_clock.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_base.h"
+
+static volatile LONG64 __ctClockFrequency = 0;
+
+static UINT64 __HCTClockTicksScale(UINT64 ticks, UINT64 unitsPerSecond) {
+
+	/// SUMMARY:
+	/// split ticks into whole seconds and remainder so that
+	/// ticks * units does not overflow on long uptimes
+
+	UINT64 frequency	= CTClockFrequency();
+	UINT64 seconds		= ticks / frequency;
+	UINT64 remainder	= ticks % frequency;
+
+	return (seconds * unitsPerSecond) + ((remainder * unitsPerSecond) / frequency);
+}
+
+CTCALL	UINT64		CTClockFrequency(void) {
+	if (__ctClockFrequency == 0) {
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		__ctClockFrequency = frequency.QuadPart;
+	}
+
+	return __ctClockFrequency;
+}
+
+CTCALL	UINT64		CTClockTicks(void) {
+	LARGE_INTEGER ticks;
+	QueryPerformanceCounter(&ticks);
+	return ticks.QuadPart;
+}
+
+CTCALL	UINT64		CTClockTicksToUsec(UINT64 ticks) {
+	return __HCTClockTicksScale(ticks, 1000000);
+}
+
+CTCALL	UINT64		CTClockTicksToNsec(UINT64 ticks) {
+	return __HCTClockTicksScale(ticks, 1000000000);
+}
+
+CTCALL	UINT64		CTClockUsec(void) {
+	return CTClockTicksToUsec(CTClockTicks());
+}
+
+CTCALL	UINT64		CTClockNsec(void) {
+	return CTClockTicksToNsec(CTClockTicks());
+}
+
+CTCALL	void		CTClockSpinUntil(UINT64 deadlineUsec) {
+	
+	/// SUMMARY:
+	/// busy wait until deadline, yielding the core to its hyperthread
+	/// every so often. only meant for the last few hundred microseconds
+	/// of a wait, which no timed wait can hit reliably
+
+	while (CTClockUsec() < deadlineUsec) {
+		for (UINT32 pause = 0; pause < CT_CLOCK_SPIN_PAUSES; pause++) {
+			YieldProcessor();
+		}
+	}
+}
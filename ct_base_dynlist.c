@@ -7,33 +7,379 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "ct_base.h"
+#include "ct_thread.h"
 
 #include <stdio.h>
-#include <intrin.h>
+
+typedef struct __CTDynListSlotHeader {
+	PCTDynListNode	owner;
+	UINT32			index;
+	UINT32			handleIndex;
+} __CTDynListSlotHeader, *P__CTDynListSlotHeader;
+
+#define __CT_DYNLIST_SLOT_ALIGNMENT		0x10
+
+typedef struct __CTDynListNodeEntry {
+	PBYTE			elements;
+	PCTDynListNode	node;
+} __CTDynListNodeEntry, *P__CTDynListNodeEntry;
+
+#define __CT_DYNLIST_NODE_TABLE_MIN		0x10
+
+typedef struct __CTDynListHandleEntry {
+	PVOID	element;
+	UINT32	generation;
+	UINT32	nextFree;
+} __CTDynListHandleEntry, *P__CTDynListHandleEntry;
+
+#define __CT_DYNLIST_HANDLE_NONE		0xFFFFFFFF
+#define __CT_DYNLIST_HANDLE_TABLE_MIN	0x40
+
+typedef struct __CTDynListRetireEntry {
+	PVOID	pointer;
+	UINT64	epoch;
+	UINT32	kind;
+} __CTDynListRetireEntry, *P__CTDynListRetireEntry;
+
+#define __CT_DYNLIST_RETIRE_SLOT		0
+#define __CT_DYNLIST_RETIRE_NODE		1
+#define __CT_DYNLIST_RETIRE_LIST_MIN	0x40
+#define __CT_DYNLIST_RETIRE_BATCH		0x40
+
+typedef struct __CTDynListParallelChunk {
+	PCTDynListNode	node;
+	UINT32			wordFirst;
+	UINT32			wordEnd;
+} __CTDynListParallelChunk, *P__CTDynListParallelChunk;
+
+typedef struct __CTDynListParallelJob {
+	PCTDynList					list;
+	PCTFUNCDYNLISTFOREACH		func;
+	PVOID						input;
+	P__CTDynListParallelChunk	chunks;
+	LONG						chunkCount;
+	volatile LONG				chunkNext;
+	volatile LONG				stopSignal;
+} __CTDynListParallelJob, *P__CTDynListParallelJob;
+
+#define __CT_DYNLIST_PARALLEL_CHUNKS_PER_WORKER	0x4
+#define __CT_DYNLIST_PARALLEL_STACK_CHUNKS		0x100
+
+static __forceinline P__CTDynListSlotHeader __HCTDynListSlotHeader(PVOID element) {
+	return (P__CTDynListSlotHeader)((PBYTE)element - __CT_DYNLIST_SLOT_HEADER_SIZE);
+}
+
+static UINT32 __HCTDynListHandleAlloc(PCTDynList list, PVOID element) {
+
+	/// SUMMARY:
+	/// if (free handle chain is empty)
+	///		if (handle table is full)
+	///			grow handle table to double capacity
+	///		take next never used table entry, starting at generation 1
+	/// else
+	///		pop entry off free handle chain
+	/// point entry at element
+
+	P__CTDynListHandleEntry	table		= list->handleTable;
+	UINT32					handleIndex	= 0;
+
+	if (list->handleFreeFirst == __CT_DYNLIST_HANDLE_NONE) {
+
+		if (list->handleUsedCount == list->handleCapacity) {
+			UINT32					newCapacity = max(__CT_DYNLIST_HANDLE_TABLE_MIN, list->handleCapacity * 2);
+			P__CTDynListHandleEntry	newTable	= CTAllocEx(newCapacity * sizeof(*newTable), CT_MEMORY_TAG_DYNLIST, TRUE);
+
+			if (table != NULL) {
+				memcpy(newTable, table, list->handleUsedCount * sizeof(*table));
+				CTFree(table);
+			}
+
+			list->handleTable		= newTable;
+			list->handleCapacity	= newCapacity;
+			table					= newTable;
+		}
+
+		handleIndex							= list->handleUsedCount++;
+		table[handleIndex].generation		= 1;
+
+	} else {
+
+		handleIndex							= list->handleFreeFirst;
+		list->handleFreeFirst				= table[handleIndex].nextFree;
+
+	}
+
+	table[handleIndex].element	= element;
+	table[handleIndex].nextFree	= __CT_DYNLIST_HANDLE_NONE;
+
+	return handleIndex;
+}
+
+static void __HCTDynListHandleFree(PCTDynList list, UINT32 handleIndex) {
+	P__CTDynListHandleEntry entry = (P__CTDynListHandleEntry)list->handleTable + handleIndex;
+
+	/// bump generation so outstanding handles go stale, 0 is never used
+	entry->element		= NULL;
+	entry->generation	+= 1;
+	if (entry->generation == 0)
+		entry->generation = 1;
+
+	entry->nextFree			= list->handleFreeFirst;
+	list->handleFreeFirst	= handleIndex;
+}
+
+static void __HCTDynListHandleReset(PCTDynList list) {
+	P__CTDynListHandleEntry table = list->handleTable;
+
+	list->handleFreeFirst = __CT_DYNLIST_HANDLE_NONE;
+
+	for (UINT32 handleIndex = list->handleUsedCount; handleIndex > 0; handleIndex--) {
+		if (table[handleIndex - 1].element != NULL) {
+			__HCTDynListHandleFree(list, handleIndex - 1);
+		} else {
+			table[handleIndex - 1].nextFree	= list->handleFreeFirst;
+			list->handleFreeFirst			= handleIndex - 1;
+		}
+	}
+}
+
+static P__CTDynListHandleEntry __HCTDynListHandleLookup(PCTDynList list, CTHandle handle) {
+	UINT32 handleIndex	= (UINT32)handle;
+	UINT32 generation	= (UINT32)(handle >> 32);
+
+	if (handleIndex >= list->handleUsedCount) return NULL;
+
+	P__CTDynListHandleEntry entry = (P__CTDynListHandleEntry)list->handleTable + handleIndex;
+	if (entry->element == NULL || entry->generation != generation) return NULL;
+
+	return entry;
+}
+
+static __forceinline CTHandle __HCTDynListHandleMake(PCTDynList list, UINT32 handleIndex) {
+	P__CTDynListHandleEntry entry = (P__CTDynListHandleEntry)list->handleTable + handleIndex;
+	return ((CTHandle)entry->generation << 32) | handleIndex;
+}
+
+static void __HCTDynListLinkFreeNode(PCTDynList list, PCTDynListNode node) {
+	node->prevFreeNode	= NULL;
+	node->nextFreeNode	= list->nodeFreeFirst;
+	if (list->nodeFreeFirst != NULL)
+		list->nodeFreeFirst->prevFreeNode = node;
+	list->nodeFreeFirst	= node;
+}
+
+static void __HCTDynListUnlinkFreeNode(PCTDynList list, PCTDynListNode node) {
+	PCTDynListNode prevFree = node->prevFreeNode;
+	PCTDynListNode nextFree = node->nextFreeNode;
+
+	if (prevFree != NULL)
+		prevFree->nextFreeNode	= nextFree;
+	else
+		list->nodeFreeFirst		= nextFree;
+
+	if (nextFree != NULL)
+		nextFree->prevFreeNode	= prevFree;
+
+	node->prevFreeNode = NULL;
+	node->nextFreeNode = NULL;
+}
+
+static UINT32 __HCTDynListNodeTableFind(PCTDynList list, PBYTE address) {
+
+	/// SUMMARY:
+	/// (node table is sorted by element block address)
+	/// binary search for last node whose element block starts at or
+	/// before address, return nodeCount if there is none
+	/// (the halving step is branch free, removes come in random order
+	///  so a branch would be mispredicted about half the time)
+
+	P__CTDynListNodeEntry	entries		= list->nodeTable;
+	UINT32					base		= 0;
+	UINT32					remaining	= list->nodeCount;
+	if (remaining == 0)
+		return 0;
+
+	while (remaining > 1) {
+		UINT32 half	= remaining / 2;
+		base		= (entries[base + half].elements <= address) ? base + half : base;
+		remaining	-= half;
+	}
+
+	return (entries[base].elements <= address) ? base : list->nodeCount;
+}
+
+static void __HCTDynListNodeTableInsert(PCTDynList list, PCTDynListNode node) {
+
+	/// SUMMARY:
+	/// if (node table is full)
+	///		grow node table to double capacity
+	/// shift up every node whose element block lies above node's
+	/// insert node in the gap
+
+	if (list->nodeCount == list->nodeTableCapacity) {
+		UINT32					newCapacity	= max(__CT_DYNLIST_NODE_TABLE_MIN, list->nodeTableCapacity * 2);
+		P__CTDynListNodeEntry	newTable	= CTAllocEx(newCapacity * sizeof(*newTable), CT_MEMORY_TAG_DYNLIST, FALSE);
+
+		if (list->nodeTable != NULL) {
+			memcpy(newTable, list->nodeTable, list->nodeCount * sizeof(*newTable));
+			CTFree(list->nodeTable);
+		}
+
+		list->nodeTable			= newTable;
+		list->nodeTableCapacity	= newCapacity;
+	}
+
+	P__CTDynListNodeEntry	entries		= list->nodeTable;
+	UINT32					insertIndex	= __HCTDynListNodeTableFind(list, node->elements);
+	insertIndex = (insertIndex == list->nodeCount) ? 0 : insertIndex + 1;
+
+	memmove(
+		entries + insertIndex + 1,
+		entries + insertIndex,
+		(list->nodeCount - insertIndex) * sizeof(*entries)
+	);
+	entries[insertIndex].elements	= node->elements;
+	entries[insertIndex].node		= node;
+}
+
+static void __HCTDynListNodeTableRemove(PCTDynList list, PCTDynListNode node) {
+	P__CTDynListNodeEntry	entries		= list->nodeTable;
+	UINT32					removeIndex	= __HCTDynListNodeTableFind(list, node->elements);
+
+	memmove(
+		entries + removeIndex,
+		entries + removeIndex + 1,
+		(list->nodeCount - removeIndex - 1) * sizeof(*entries)
+	);
+}
+
+static void __HCTDynListFreeNode(PCTDynListNode node) {
+	CTFree(node->elements);
+	CTFree(node->useBits);
+	CTFree(node->reserveBits);
+	CTFree(node->freeStack);
+	CTFree(node);
+}
+
+static void __HCTDynListRetire(PCTDynList list, PVOID pointer, UINT32 kind) {
+
+	/// SUMMARY:
+	/// if (retire list is full)
+	///		grow retire list to double capacity
+	/// append pointer tagged with current epoch
+	/// (epochs only go up, so retire list stays sorted by epoch)
+
+	if (list->retireCount == list->retireCapacity) {
+		UINT32					newCapacity = max(__CT_DYNLIST_RETIRE_LIST_MIN, list->retireCapacity * 2);
+		P__CTDynListRetireEntry	newList		= CTAllocEx(newCapacity * sizeof(*newList), CT_MEMORY_TAG_DYNLIST, FALSE);
+
+		if (list->retireList != NULL) {
+			memcpy(newList, list->retireList, list->retireCount * sizeof(*newList));
+			CTFree(list->retireList);
+		}
+
+		list->retireList		= newList;
+		list->retireCapacity	= newCapacity;
+	}
+
+	P__CTDynListRetireEntry entry = (P__CTDynListRetireEntry)list->retireList + list->retireCount++;
+	entry->pointer	= pointer;
+	entry->kind		= kind;
+	entry->epoch	= CTEpochCurrent();
+}
+
+static void __HCTDynListReclaim(PCTDynList list) {
+
+	/// SUMMARY:
+	/// while (oldest retired entry is past its grace period):
+	///		if (entry is a node)
+	///			free node
+	///		else if (slot's node has not been retired itself)
+	///			zero slot and push it onto node's free stack
+	///			if (node was full and is not being compacted)
+	///				link node into free node chain
+	/// shift remaining entries to front of retire list
+
+	P__CTDynListRetireEntry	entries		= list->retireList;
+	UINT32					doneCount	= 0;
+
+	while (doneCount < list->retireCount && CTEpochSafe(entries[doneCount].epoch) == TRUE) {
+		P__CTDynListRetireEntry entry = entries + doneCount++;
+
+		if (entry->kind == __CT_DYNLIST_RETIRE_NODE) {
+			__HCTDynListFreeNode(entry->pointer);
+			continue;
+		}
+
+		P__CTDynListSlotHeader	header	= __HCTDynListSlotHeader(entry->pointer);
+		PCTDynListNode			node	= header->owner;
+		if (node->parent == NULL) continue;
+
+		__stosb(
+			entry->pointer,
+			0,
+			list->elementSizeBytes
+		);
+
+		node->elementUseCount -= 1;
+		node->freeStack[node->freeCount++] = header->index;
+		if (node->freeCount == 1 && node != list->compactNode)
+			__HCTDynListLinkFreeNode(list, node);
+	}
+
+	if (doneCount == 0) return;
+
+	list->retireCount -= doneCount;
+	memmove(entries, entries + doneCount, list->retireCount * sizeof(*entries));
+}
 
 static void __HCTDynListAddNode(PCTDynList pList) {
 	EnterCriticalSection(&pList->lock);
 
 	/// SUMMARY:
 	/// creates a new node with appropriate element buffer and field size
+	/// writes owner and index into every slot header
+	/// fills free stack so that lower indicies are handed out first
+	/// inserts node into node table
 	/// increments nodecount and updates list nodes accordingly
+	/// (node is linked in with an interlocked store once it is fully built,
+	/// so lock-free readers never see it half initialized)
+	/// links node into free node chain
 	
-	PCTDynListNode node = CTAlloc(sizeof(*node));
+	PCTDynListNode node = CTAllocEx(sizeof(*node), CT_MEMORY_TAG_DYNLIST, TRUE);
+
+	node->parent	= pList;
+	node->elements	= CTAllocEx(pList->slotSizeBytes * pList->elementsPerNode, CT_MEMORY_TAG_DYNLIST, TRUE);
+	node->useBits	= CTAllocEx(__CTDynListWordCount(pList) * sizeof(*node->useBits), CT_MEMORY_TAG_DYNLIST, TRUE);
+	if ((pList->flags & CT_DYNLIST_FLAG_EPOCH) != 0)
+		node->reserveBits = CTAllocEx(__CTDynListWordCount(pList) * sizeof(*node->reserveBits), CT_MEMORY_TAG_DYNLIST, TRUE);
+	node->freeStack	= CTAllocEx(pList->elementsPerNode * sizeof(*node->freeStack), CT_MEMORY_TAG_DYNLIST, FALSE);
+	node->freeCount	= pList->elementsPerNode;
+
+	for (UINT32 slotIndex = 0; slotIndex < pList->elementsPerNode; slotIndex++) {
+		P__CTDynListSlotHeader header = (P__CTDynListSlotHeader)(node->elements + (slotIndex * pList->slotSizeBytes));
+		header->owner	= node;
+		header->index	= slotIndex;
+	}
 
-	node->elements = CTAlloc(pList->elementSizeBytes * pList->elementsPerNode);
-	node->useField = CTAlloc(pList->elementsPerNode * sizeof(*node->useField));
+	for (UINT32 stackIndex = 0; stackIndex < pList->elementsPerNode; stackIndex++) {
+		node->freeStack[stackIndex] = pList->elementsPerNode - stackIndex - 1;
+	}
 
 	if (pList->nodeLast == NULL) {
 		pList->nodeFirst	= node;
 		pList->nodeLast		= node;
 	} else {
-		pList->nodeLast->nextNode	= node;
+		InterlockedExchangePointer(&pList->nodeLast->nextNode, node);
 		pList->nodeLast				= node;
 	}
 	
+	__HCTDynListNodeTableInsert(pList, node);
 	pList->nodeCount			+= 1;
 	pList->elementsTotalCount	+= pList->elementsPerNode;
 
+	__HCTDynListLinkFreeNode(pList, node);
+
 	LeaveCriticalSection(&pList->lock);
 }
 
@@ -43,22 +389,39 @@ static void __HCTDynListRemoveNode(PCTDynList list, PCTDynListNode prevNode, PCT
 	/// if (node to remove is last node)
 	///		set list last node to prev node
 	/// 
-	/// prevNode.next = nodeToRemove.next (only if exists)
+	/// prevNode.next = nodeToRemove.next (only if exists, else list first)
+	/// unlink nodeToRemove from free node chain (unless being compacted,
+	/// compacted nodes are kept out of the chain) and from node table
 	/// 
-	/// free(nodeToRemove)
+	/// if (list is an epoch list)
+	///		retire nodeToRemove, readers may still be walking it
+	/// else
+	///		free(nodeToRemove)
 	
 	EnterCriticalSection(&list->lock);
 
+	if (nodeToRemove == list->compactNode)
+		list->compactNode = NULL;
+	else if (nodeToRemove->freeCount > 0)
+		__HCTDynListUnlinkFreeNode(list, nodeToRemove);
+
 	if (nodeToRemove == list->nodeLast) {
 		list->nodeLast = prevNode;
 	}
 
 	if (prevNode != NULL)
-		prevNode->nextNode = nodeToRemove->nextNode;
+		InterlockedExchangePointer(&prevNode->nextNode, nodeToRemove->nextNode);
+	else
+		InterlockedExchangePointer(&list->nodeFirst, nodeToRemove->nextNode);
 
-	CTFree(nodeToRemove->elements);
-	CTFree(nodeToRemove->useField);
-	CTFree(nodeToRemove);
+	__HCTDynListNodeTableRemove(list, nodeToRemove);
+
+	if ((list->flags & CT_DYNLIST_FLAG_EPOCH) != 0) {
+		nodeToRemove->parent = NULL;
+		__HCTDynListRetire(list, nodeToRemove, __CT_DYNLIST_RETIRE_NODE);
+	} else {
+		__HCTDynListFreeNode(nodeToRemove);
+	}
 
 	list->nodeCount				-= 1;
 	list->elementsTotalCount	-= list->elementsPerNode;
@@ -67,6 +430,10 @@ static void __HCTDynListRemoveNode(PCTDynList list, PCTDynListNode prevNode, PCT
 }
 
 CTCALL	PCTDynList	CTDynListCreate(SIZE_T elemSize, UINT32 elemsPerNode) {
+	return CTDynListCreateEx(elemSize, elemsPerNode, 0);
+}
+
+CTCALL	PCTDynList	CTDynListCreateEx(SIZE_T elemSize, UINT32 elemsPerNode, UINT32 flags) {
 	if (elemSize == 0) {
 		CTErrorSetParamValue("CTDynListCreate failed: elemSize was 0");
 		return NULL;
@@ -76,11 +443,15 @@ CTCALL	PCTDynList	CTDynListCreate(SIZE_T elemSize, UINT32 elemsPerNode) {
 		return NULL;
 	}
 
-	PCTDynList pList = CTAlloc(sizeof(*pList));
+	PCTDynList pList = CTAllocEx(sizeof(*pList), CT_MEMORY_TAG_DYNLIST, TRUE);
 	
 	InitializeCriticalSection(&pList->lock);
 	pList->elementSizeBytes = elemSize;
+	pList->slotSizeBytes	= __CT_DYNLIST_SLOT_HEADER_SIZE +
+		((elemSize + __CT_DYNLIST_SLOT_ALIGNMENT - 1) & ~((SIZE_T)__CT_DYNLIST_SLOT_ALIGNMENT - 1));
 	pList->elementsPerNode	= elemsPerNode;
+	pList->flags			= flags;
+	pList->handleFreeFirst	= __CT_DYNLIST_HANDLE_NONE;
 
 	__HCTDynListAddNode(pList);
 
@@ -106,15 +477,28 @@ CTCALL	BOOL		CTDynListDestroy(PCTDynList* pList) {
 	PCTDynListNode node		= list->nodeFirst;
 
 	while (node != NULL) {
-		CTFree(node->elements);
-		CTFree(node->useField);
-
 		PCTDynListNode tempNode = node;
 		node = node->nextNode;
 
-		CTFree(tempNode);
+		__HCTDynListFreeNode(tempNode);
 	}
 
+	/// free nodes which are still waiting out their grace period
+	P__CTDynListRetireEntry entries = list->retireList;
+	for (UINT32 retireIndex = 0; retireIndex < list->retireCount; retireIndex++) {
+		if (entries[retireIndex].kind == __CT_DYNLIST_RETIRE_NODE)
+			__HCTDynListFreeNode(entries[retireIndex].pointer);
+	}
+
+	if (list->retireList != NULL)
+		CTFree(list->retireList);
+
+	if (list->handleTable != NULL)
+		CTFree(list->handleTable);
+
+	if (list->nodeTable != NULL)
+		CTFree(list->nodeTable);
+
 	DeleteCriticalSection(&list->lock);
 	CTFree(list);
 
@@ -130,25 +514,33 @@ CTCALL	BOOL		CTDynListClear(PCTDynList list) {
 
 	EnterCriticalSection(&list->lock);
 
-	// clear all nodes
+	// clear all nodes (epoch lists retire them instead)
 	PCTDynListNode node = list->nodeFirst;
 
 	while (node != NULL) {
-		CTFree(node->elements);
-		CTFree(node->useField);
-
 		PCTDynListNode tempNode = node;
 		node = node->nextNode;
 
-		CTFree(tempNode);
+		if ((list->flags & CT_DYNLIST_FLAG_EPOCH) != 0) {
+			tempNode->parent = NULL;
+			__HCTDynListRetire(list, tempNode, __CT_DYNLIST_RETIRE_NODE);
+		} else {
+			__HCTDynListFreeNode(tempNode);
+		}
 	}
 
 	// reset everything
 	list->nodeFirst				= NULL;
 	list->nodeLast				= NULL;
+	list->nodeFreeFirst			= NULL;
+	list->compactNode			= NULL;
 	list->nodeCount				= 0;
 	list->elementsTotalCount	= 0;
 	list->elementsUsedCount		= 0;
+
+	// invalidate all handles
+	if ((list->flags & CT_DYNLIST_FLAG_HANDLES) != 0)
+		__HCTDynListHandleReset(list);
 	
 	// reset first node
 	__HCTDynListAddNode(list);
@@ -180,6 +572,34 @@ CTCALL	BOOL		CTDynListUnlock(PCTDynList list) {
 	return TRUE;
 }
 
+CTCALL	BOOL		CTDynListReadBegin(PCTDynList list) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListReadBegin failed: list was NULL");
+		return FALSE;
+	}
+
+	if ((list->flags & CT_DYNLIST_FLAG_EPOCH) != 0)
+		return CTEpochEnter();
+
+	EnterCriticalSection(&list->lock);
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTDynListReadEnd(PCTDynList list) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListReadEnd failed: list was NULL");
+		return FALSE;
+	}
+
+	if ((list->flags & CT_DYNLIST_FLAG_EPOCH) != 0)
+		return CTEpochLeave();
+
+	LeaveCriticalSection(&list->lock);
+
+	return TRUE;
+}
+
 CTCALL	PVOID		CTDynListAdd(PCTDynList list) {
 	if (list == NULL) {
 		CTErrorSetBadObject("CTDynListUnlock failed: list was NULL");
@@ -189,51 +609,119 @@ CTCALL	PVOID		CTDynListAdd(PCTDynList list) {
 	EnterCriticalSection(&list->lock);
 
 	/// SUMMARY:
-	/// if (all elements are used)
-	///		add new node to list
-	/// while (next node exists):
-	///		loop every element in node:
-	///			get index use flag
-	///			if (index is used)
-	///				skip
-	///			set use flag to true, increment element use count
-	///			get ptr of node element
-	///			return ptr
-	/// <should never reach here>
-	/// raise error
+	/// if (no node has a free element)
+	///		reclaim retired slots of epoch list first
+	///		if (still no node has a free element)
+	///			add new node to list
+	/// take first node of free node chain
+	/// pop free index from node's free stack
+	/// set use flag to true (epoch lists only set the reserve flag and wait
+	/// for CTDynListPublish), increment element use count
+	/// if (node is now full)
+	///		unlink node from free node chain
+	/// if (list uses handles)
+	///		give element a handle
+	/// return ptr of node element
 	
-	if (list->elementsUsedCount == list->elementsTotalCount) {
+	if (list->nodeFreeFirst == NULL && list->retireCount > 0) {
+		__HCTDynListReclaim(list);
+	}
+	if (list->nodeFreeFirst == NULL) {
 		__HCTDynListAddNode(list);
 	}
 
-	PVOID retPtr = NULL;
+	PCTDynListNode	node		= list->nodeFreeFirst;
+	UINT32			nodeIndex	= node->freeStack[--node->freeCount];
 
-	PCTDynListNode node = list->nodeFirst;
-	while (node != NULL) {
-		
-		for (UINT32 nodeIndex = node->seekHead; nodeIndex < list->elementsPerNode; nodeIndex++) {
-			
-			PBYTE fieldState = node->useField + nodeIndex;
+	if ((list->flags & CT_DYNLIST_FLAG_EPOCH) == 0)
+		node->useBits[nodeIndex / __CT_DYNLIST_WORD_BITS] |= 1ULL << (nodeIndex % __CT_DYNLIST_WORD_BITS);
+	else
+		node->reserveBits[nodeIndex / __CT_DYNLIST_WORD_BITS] |= 1ULL << (nodeIndex % __CT_DYNLIST_WORD_BITS);
+	node->elementUseCount		+= 1;
+	list->elementsUsedCount		+= 1;
 
-			if (*fieldState == TRUE) continue;
+	if (node->freeCount == 0)
+		__HCTDynListUnlinkFreeNode(list, node);
 
-			*fieldState				= TRUE;
-			node->elementUseCount	+= 1;
-			list->elementsUsedCount += 1;
-			node->seekHead			= nodeIndex;
+	PVOID retPtr = __CTDynListElement(list, node, nodeIndex);
 
-			retPtr = node->elements + (nodeIndex * list->elementSizeBytes);
-			LeaveCriticalSection(&list->lock);
+	if ((list->flags & CT_DYNLIST_FLAG_HANDLES) != 0)
+		__HCTDynListSlotHeader(retPtr)->handleIndex = __HCTDynListHandleAlloc(list, retPtr);
 
-			return retPtr;
+	LeaveCriticalSection(&list->lock);
 
-		}
-		
-		node = node->nextNode;
+	return retPtr;
+}
+
+static BOOL __HCTDynListSlotValid(PCTDynList list, PVOID element) {
+
+	/// SUMMARY:
+	/// find node whose element block could hold element, by address alone
+	/// if (element's header would not lie inside that block)
+	///		element is not from this list, header is never read
+	/// slot header must name that node and a slot which starts at element
+	/// (header line is prefetched first so its miss overlaps the search, a
+	///  prefetch never faults even when element is not from this list)
+
+	_mm_prefetch((PCHAR)element - __CT_DYNLIST_SLOT_HEADER_SIZE, _MM_HINT_T0);
+
+	UINT32 tableIndex = __HCTDynListNodeTableFind(list, element);
+	if (tableIndex == list->nodeCount)
+		return FALSE;
+
+	P__CTDynListNodeEntry	entry	= (P__CTDynListNodeEntry)list->nodeTable + tableIndex;
+	SIZE_T					offset	= (PBYTE)element - entry->elements;
+
+	if (offset < __CT_DYNLIST_SLOT_HEADER_SIZE ||
+		offset >= list->slotSizeBytes * list->elementsPerNode)
+		return FALSE;
+
+	P__CTDynListSlotHeader header = __HCTDynListSlotHeader(element);
+	return header->owner == entry->node && header->index < list->elementsPerNode &&
+		__CTDynListElement(list, entry->node, header->index) == element;
+}
+
+CTCALL	BOOL		CTDynListPublish(PCTDynList list, PVOID element) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListPublish failed: list was NULL");
+		return FALSE;
+	}
+	if (element == NULL) {
+		CTErrorSetParamValue("CTDynListPublish failed: element was NULL");
+		return FALSE;
+	}
+
+	/// elements of other lists are visible as soon as they are added
+	if ((list->flags & CT_DYNLIST_FLAG_EPOCH) == 0)
+		return TRUE;
+
+	EnterCriticalSection(&list->lock);
+
+	if (__HCTDynListSlotValid(list, element) == FALSE) {
+		LeaveCriticalSection(&list->lock);
+		CTErrorSetFunction("CTDynListPublish failed: element could not be found in list");
+		return FALSE;
 	}
 
-	CTErrorSetFunction("CTDynListAdd failed: critical failure");
-	ExitProcess(ERROR_FUNCTION_FAILED);
+	P__CTDynListSlotHeader	header		= __HCTDynListSlotHeader(element);
+	UINT32					wordIndex	= header->index / __CT_DYNLIST_WORD_BITS;
+	UINT64					bit			= 1ULL << (header->index % __CT_DYNLIST_WORD_BITS);
+
+	if ((header->owner->reserveBits[wordIndex] & bit) == 0) {
+		LeaveCriticalSection(&list->lock);
+		CTErrorSetFunction("CTDynListPublish failed: element was removed");
+		return FALSE;
+	}
+
+	/// interlocked or is a release store, element is fully written before
+	/// any reader can see its use flag
+	InterlockedOr64(
+		(volatile LONG64*)(header->owner->useBits + wordIndex),
+		(LONG64)bit
+	);
+
+	LeaveCriticalSection(&list->lock);
+	return TRUE;
 }
 
 CTCALL	BOOL		CTDynListRemove(PCTDynList list, PVOID element) {
@@ -249,59 +737,78 @@ CTCALL	BOOL		CTDynListRemove(PCTDynList list, PVOID element) {
 	EnterCriticalSection(&list->lock);
 
 	/// SUMMARY:
-	/// (walk through all nodes)
-	/// while (node is NOT NULL)
-	///		if (element lies within node)
-	///			if (element is already removed)
-	///				raise error
-	///			else
-	///				clear use flag and decrement element count and zero memory
-	/// 
-	///				return
-	///		else
-	///			set node to next node
-	/// (on reached here, all nodes have been tested to no avail)
-	/// raise error
-	
-	PCTDynListNode node		= list->nodeFirst;
-	PCTDynListNode prevNode	= NULL;
-	while (node != NULL) {
+	/// if (slot does not belong to this list)
+	///		raise error
+	/// read owning node and index from slot header
+	/// if (element is already removed)
+	///		raise error
+	/// if (list uses handles)
+	///		release element's handle
+	/// if (list is an epoch list and element was published)
+	///		clear use and reserve flags, decrement list element count
+	///		retire slot, it is zeroed and reused once readers have left
+	///		reclaim retired slots every so often
+	///		return
+	/// (an unpublished slot was never seen by readers, free it right away)
+	/// clear use flag and decrement element count and zero memory
+	/// push index onto node's free stack
+	/// if (node was full and is not being compacted)
+	///		link node into free node chain
+
+	if (__HCTDynListSlotValid(list, element) == FALSE) {
+		LeaveCriticalSection(&list->lock);
+		CTErrorSetFunction("CTDynListRemove failed: element could not be found in list");
+		return FALSE;
+	}
 
-		if (element < (node->elements + list->elementSizeBytes * list->elementsPerNode) &&
-			element >= node->elements) {
+	P__CTDynListSlotHeader	header	= __HCTDynListSlotHeader(element);
+	PCTDynListNode			node	= header->owner;
+	UINT32					index	= header->index;
 
-			SIZE_T elementIndex = ((PBYTE)element - node->elements) / list->elementSizeBytes;
-			PBYTE  fieldState	= node->useField + elementIndex;
+	PUINT64	useWord		= node->useBits + (index / __CT_DYNLIST_WORD_BITS);
+	UINT64	useBit		= 1ULL << (index % __CT_DYNLIST_WORD_BITS);
+	BOOL	isEpoch		= (list->flags & CT_DYNLIST_FLAG_EPOCH) != 0;
+	PUINT64	reserveWord	= isEpoch ? node->reserveBits + (index / __CT_DYNLIST_WORD_BITS) : useWord;
 
-			if (*fieldState == FALSE) {
-				LeaveCriticalSection(&list->lock);
-				CTErrorSetFunction("CTDynListRemove failed: element is already removed!");
-				return FALSE;
-			}
-			
-			*fieldState				 = FALSE;
-			node->elementUseCount	-= 1;
-			list->elementsUsedCount -= 1;
+	if ((*reserveWord & useBit) == 0) {
+		LeaveCriticalSection(&list->lock);
+		CTErrorSetFunction("CTDynListRemove failed: element is already removed!");
+		return FALSE;
+	}
 
-			node->seekHead	= min(node->seekHead, elementIndex);
+	if ((list->flags & CT_DYNLIST_FLAG_HANDLES) != 0)
+		__HCTDynListHandleFree(list, header->handleIndex);
 
-			__stosb(
-				node->elements + (elementIndex * list->elementSizeBytes),
-				0,
-				list->elementSizeBytes
-			);
+	if (isEpoch == TRUE && (*useWord & useBit) != 0) {
+		*reserveWord &= ~useBit;
+		InterlockedAnd64((volatile LONG64*)useWord, ~(LONG64)useBit);
+		list->elementsUsedCount -= 1;
 
-			LeaveCriticalSection(&list->lock);
-			return TRUE;
-		}
+		__HCTDynListRetire(list, element, __CT_DYNLIST_RETIRE_SLOT);
+		if (list->retireCount >= __CT_DYNLIST_RETIRE_BATCH)
+			__HCTDynListReclaim(list);
 
-		prevNode	= node;
-		node		= node->nextNode;
+		LeaveCriticalSection(&list->lock);
+		return TRUE;
 	}
 
+	*reserveWord			&= ~useBit;
+	*useWord				&= ~useBit;
+	node->elementUseCount	-= 1;
+	list->elementsUsedCount -= 1;
+
+	node->freeStack[node->freeCount++] = index;
+	if (node->freeCount == 1 && node != list->compactNode)
+		__HCTDynListLinkFreeNode(list, node);
+
+	__stosb(
+		element,
+		0,
+		list->elementSizeBytes
+	);
+
 	LeaveCriticalSection(&list->lock);
-	CTErrorSetFunction("CTDynListRemove failed: element could not be found in list");
-	return FALSE;
+	return TRUE;
 }
 
 CTCALL	BOOL		CTDynListClean(PCTDynList list) {
@@ -314,56 +821,256 @@ CTCALL	BOOL		CTDynListClean(PCTDynList list) {
 	EnterCriticalSection(&list->lock);
 
 	/// SUMMARY:
-	/// cache total amount of nodes
-	/// repeat cahced amt of node times:
-	///		get current amt of nodes
-	///		loop all nodes:
-	///			if (node is NOT first node && node has no elements)
-	///				remove node
-	///				break
-	///			else
-	///				increment good node counter
-	///		if (current amt of nodes == good node counter)
-	///			break
+	/// reclaim retired slots of epoch list so their nodes can empty out
+	/// walk nodes once, starting after first node (first node is kept):
+	///		if (node has no elements)
+	///			remove node, prev node stays the same
+	///		else
+	///			node becomes prev node
+
+	if (list->retireCount > 0)
+		__HCTDynListReclaim(list);
+
+	PCTDynListNode prevNode = list->nodeFirst;
+	PCTDynListNode node		= prevNode->nextNode;
+
+	while (node != NULL) {
+		PCTDynListNode nextNode = node->nextNode;
+
+		if (node->elementUseCount == 0) {
+			__HCTDynListRemoveNode(
+				list,
+				prevNode,
+				node
+			);
+		} else {
+			prevNode = node;
+		}
+
+		node = nextNode;
+	}
+
+	LeaveCriticalSection(&list->lock);
 	
-	UINT32 startNodeCount	= list->nodeCount;
+	return TRUE;
+}
+
+CTCALL	CTHandle	CTDynListAddHandle(PCTDynList list, PVOID* pElement) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListAddHandle failed: list was NULL");
+		return CT_HANDLE_NULL;
+	}
+	if ((list->flags & CT_DYNLIST_FLAG_HANDLES) == 0) {
+		CTErrorSetFunction("CTDynListAddHandle failed: list was not created with CT_DYNLIST_FLAG_HANDLES");
+		return CT_HANDLE_NULL;
+	}
 
-	for (UINT32 i = 0; i < startNodeCount; i++) {
+	EnterCriticalSection(&list->lock);
 
-		PCTDynListNode node		= list->nodeFirst;
-		PCTDynListNode prevNode = NULL;
+	PVOID		element = CTDynListAdd(list);
+	CTHandle	handle	= __HCTDynListHandleMake(list, __HCTDynListSlotHeader(element)->handleIndex);
 
-		UINT32 currentNodeCount = list->nodeCount;
-		UINT32 usedNodeCounter	= 0;
+	LeaveCriticalSection(&list->lock);
 
-		while (node != NULL) {
-			if (node != list->nodeFirst && node->elementUseCount == 0) {
+	if (pElement != NULL)
+		*pElement = element;
 
-				__HCTDynListRemoveNode(
-					list,
-					prevNode,
-					node
-				);
-				break;
+	return handle;
+}
 
-			}
-			else
-			{
-				usedNodeCounter++;
+CTCALL	BOOL		CTDynListRemoveHandle(PCTDynList list, CTHandle handle) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListRemoveHandle failed: list was NULL");
+		return FALSE;
+	}
+
+	EnterCriticalSection(&list->lock);
+
+	P__CTDynListHandleEntry entry = NULL;
+	if ((list->flags & CT_DYNLIST_FLAG_HANDLES) != 0)
+		entry = __HCTDynListHandleLookup(list, handle);
+
+	if (entry == NULL) {
+		LeaveCriticalSection(&list->lock);
+		CTErrorSetParamValue("CTDynListRemoveHandle failed: handle was invalid or stale");
+		return FALSE;
+	}
+
+	BOOL result = CTDynListRemove(list, entry->element);
+
+	LeaveCriticalSection(&list->lock);
+
+	return result;
+}
+
+CTCALL	PVOID		CTDynListResolve(PCTDynList list, CTHandle handle) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListResolve failed: list was NULL");
+		return NULL;
+	}
+
+	/// stale handles are expected here, so no error is raised for them
+
+	if ((list->flags & CT_DYNLIST_FLAG_HANDLES) == 0)
+		return NULL;
+
+	EnterCriticalSection(&list->lock);
+
+	P__CTDynListHandleEntry	entry	= __HCTDynListHandleLookup(list, handle);
+	PVOID					element = (entry != NULL) ? entry->element : NULL;
+
+	LeaveCriticalSection(&list->lock);
+
+	return element;
+}
+
+CTCALL	CTHandle	CTDynListHandleOf(PCTDynList list, PVOID element) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListHandleOf failed: list was NULL");
+		return CT_HANDLE_NULL;
+	}
+	if (element == NULL) {
+		CTErrorSetParamValue("CTDynListHandleOf failed: element was NULL");
+		return CT_HANDLE_NULL;
+	}
+	if ((list->flags & CT_DYNLIST_FLAG_HANDLES) == 0) {
+		CTErrorSetFunction("CTDynListHandleOf failed: list was not created with CT_DYNLIST_FLAG_HANDLES");
+		return CT_HANDLE_NULL;
+	}
+
+	EnterCriticalSection(&list->lock);
+
+	CTHandle handle = CT_HANDLE_NULL;
+
+	if (__HCTDynListSlotValid(list, element) == TRUE) {
+		P__CTDynListSlotHeader header = __HCTDynListSlotHeader(element);
+		if (header->handleIndex < list->handleUsedCount &&
+			((P__CTDynListHandleEntry)list->handleTable)[header->handleIndex].element == element)
+			handle = __HCTDynListHandleMake(list, header->handleIndex);
+	}
+
+	LeaveCriticalSection(&list->lock);
+
+	if (handle == CT_HANDLE_NULL)
+		CTErrorSetFunction("CTDynListHandleOf failed: element could not be found in list");
+
+	return handle;
+}
+
+CTCALL	UINT32		CTDynListCompact(PCTDynList list, UINT32 maxMoves) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListCompact failed: list was NULL");
+		return 0;
+	}
+	if ((list->flags & CT_DYNLIST_FLAG_HANDLES) == 0) {
+		CTErrorSetFunction("CTDynListCompact failed: list was not created with CT_DYNLIST_FLAG_HANDLES");
+		return 0;
+	}
+	if ((list->flags & CT_DYNLIST_FLAG_EPOCH) != 0) {
+		CTErrorSetFunction("CTDynListCompact failed: epoch lists can not be compacted");
+		return 0;
+	}
+
+	EnterCriticalSection(&list->lock);
+
+	/// SUMMARY:
+	/// if (no source node is being drained)
+	///		pick node with least live elements as source
+	///		if (other nodes can not hold all of source's elements)
+	///			list is already dense, return
+	///		unlink source from free node chain so adds skip it
+	/// while (moves left and source has live elements):
+	///		if (no free slot is left outside of source)
+	///			give up on source, link it back into free node chain
+	///			break
+	///		pop free slot of first free node, copy lowest live element over
+	///		point element's handle at the new slot
+	///		release and zero old slot
+	/// if (source is empty)
+	///		remove source node
+	/// return amount of elements moved
+
+	if (list->compactNode == NULL) {
+
+		if (list->nodeCount < 2) {
+			LeaveCriticalSection(&list->lock);
+			return 0;
+		}
+
+		PCTDynListNode source = list->nodeFirst;
+		for (PCTDynListNode node = source->nextNode; node != NULL; node = node->nextNode) {
+			if (node->elementUseCount < source->elementUseCount)
+				source = node;
+		}
+
+		UINT32 freeOutside = (list->elementsTotalCount - list->elementsUsedCount) - source->freeCount;
+		if (freeOutside < source->elementUseCount) {
+			LeaveCriticalSection(&list->lock);
+			return 0;
+		}
+
+		if (source->freeCount > 0)
+			__HCTDynListUnlinkFreeNode(list, source);
+		list->compactNode = source;
+	}
+
+	PCTDynListNode			source		= list->compactNode;
+	P__CTDynListHandleEntry	table		= list->handleTable;
+	UINT32					wordCount	= __CTDynListWordCount(list);
+	UINT32					moveCount	= 0;
+
+	for (UINT32 wordIndex = 0; wordIndex < wordCount && moveCount < maxMoves; wordIndex++) {
+		while (source->useBits[wordIndex] != 0 && moveCount < maxMoves) {
+
+			PCTDynListNode dest = list->nodeFreeFirst;
+			if (dest == NULL) {
+				if (source->freeCount > 0)
+					__HCTDynListLinkFreeNode(list, source);
+				list->compactNode = NULL;
+				LeaveCriticalSection(&list->lock);
+				return moveCount;
 			}
 
-			prevNode = node;
-			node	 = node->nextNode;
+			UINT32	sourceIndex		= (wordIndex * __CT_DYNLIST_WORD_BITS) + __CTDynListLowestBit(source->useBits[wordIndex]);
+			UINT32	destIndex		= dest->freeStack[--dest->freeCount];
+			PVOID	sourceElement	= __CTDynListElement(list, source, sourceIndex);
+			PVOID	destElement		= __CTDynListElement(list, dest, destIndex);
+			UINT32	handleIndex		= __HCTDynListSlotHeader(sourceElement)->handleIndex;
+
+			memcpy(destElement, sourceElement, list->elementSizeBytes);
+			__HCTDynListSlotHeader(destElement)->handleIndex	= handleIndex;
+			table[handleIndex].element							= destElement;
+
+			dest->useBits[destIndex / __CT_DYNLIST_WORD_BITS] |= 1ULL << (destIndex % __CT_DYNLIST_WORD_BITS);
+			dest->elementUseCount += 1;
+			if (dest->freeCount == 0)
+				__HCTDynListUnlinkFreeNode(list, dest);
+
+			source->useBits[wordIndex] &= ~(1ULL << (sourceIndex % __CT_DYNLIST_WORD_BITS));
+			source->elementUseCount -= 1;
+			source->freeStack[source->freeCount++] = sourceIndex;
+
+			__stosb(
+				sourceElement,
+				0,
+				list->elementSizeBytes
+			);
+
+			moveCount++;
 		}
+	}
 
-		//if (usedNodeCounter == currentNodeCount)
-		//	break;
+	if (source->elementUseCount == 0) {
+		PCTDynListNode prevNode = NULL;
+		for (PCTDynListNode node = list->nodeFirst; node != source; node = node->nextNode)
+			prevNode = node;
 
+		__HCTDynListRemoveNode(list, prevNode, source);
 	}
 
 	LeaveCriticalSection(&list->lock);
-	
-	return TRUE;
+
+	return moveCount;
 }
 
 CTCALL	PCTIterator	CTIteratorCreate(PCTDynList list) {
@@ -372,12 +1079,21 @@ CTCALL	PCTIterator	CTIteratorCreate(PCTDynList list) {
 		return NULL;
 	}
 
-	PCTIterator iter		= CTAlloc(sizeof(*iter));
+	/// SUMMARY:
+	/// take iterator from frame arena if thread has one, else heap
+	/// BEGIN READING LIST
+	/// setup iterator at first node (loaded inside read section, so node
+	/// cannot be reclaimed before the iterator reaches it)
+
+	PCTArena	arena		= CTArenaFrameGet();
+	PCTIterator	iter		= (arena != NULL) ? CTArenaAlloc(arena, sizeof(*iter)) : CTAllocEx(sizeof(*iter), CT_MEMORY_TAG_DYNLIST, TRUE);
+
+	CTDynListReadBegin(list);
+
 	iter->currentNode		= list->nodeFirst;
 	iter->currentNodeIndex	= 0;
 	iter->parent			= list;
-
-	CTDynListLock(list);
+	iter->arena				= arena;
 
 	return iter;
 }
@@ -395,8 +1111,9 @@ CTCALL	BOOL		CTIteratorDestroy(PCTIterator* pIterator) {
 		return FALSE;
 	}
 
-	CTDynListUnlock(iterator->parent);
-	CTFree(iterator);
+	CTDynListReadEnd(iterator->parent);
+	if (iterator->arena == NULL)
+		CTFree(iterator);
 
 	*pIterator = NULL;
 	return TRUE;
@@ -409,47 +1126,285 @@ CTCALL	PVOID		CTIteratorIterate(PCTIterator iterator) {
 		return FALSE;
 	}
 
+	PVOID element = NULL;
+	CTIteratorIterateBatch(iterator, &element, 1);
+	return element;
+}
+
+CTCALL	UINT32		CTIteratorIterateBatch(PCTIterator iterator, PVOID* elementsOut, UINT32 maxCount) {
+
+	if (iterator == NULL) {
+		CTErrorSetBadObject("CTIteratorIterateBatch failed: iterator was NULL");
+		return 0;
+	}
+	if (elementsOut == NULL) {
+		CTErrorSetParamValue("CTIteratorIterateBatch failed: elementsOut was NULL");
+		return 0;
+	}
+
 	/// SUMMARY:
-	/// while scanned node is NOT NULL:
-	///		if (node index is within node):
-	///			if (node is unused)
-	///				increment node index and continue
-	///			else
-	///				return index ptr and increment node index
-	///		else
+	/// while (batch is not full and scanned node is NOT NULL):
+	///		if (node index is past end of node)
 	///			update to next node and reset node index
 	///			(note: next node could be null)
-	/// (note: on reached here, no more nodes)
-	/// list iteration is complete, return NULL
-	
-	while (iterator->currentNode != NULL) {
+	///			continue
+	///		load occupancy word of node index, mask off bits below index
+	///		while (word has bits and batch is not full)
+	///			take lowest set bit, output its element
+	///		if (word was exhausted)
+	///			move node index to start of next word
+	///		else
+	///			move node index past last output element
+	/// return amount of elements output
+
+	PCTDynList	list	= iterator->parent;
+	UINT32		count	= 0;
+
+	while (count < maxCount && iterator->currentNode != NULL) {
+
+		PCTDynListNode	node		= iterator->currentNode;
+		UINT32			nodeIndex	= iterator->currentNodeIndex;
+
+		if (nodeIndex >= list->elementsPerNode) {
+			iterator->currentNode		= node->nextNode;
+			iterator->currentNodeIndex	= 0;
+			continue;
+		}
+
+		UINT32 wordIndex	= nodeIndex / __CT_DYNLIST_WORD_BITS;
+		UINT64 word			= node->useBits[wordIndex] & (~0ULL << (nodeIndex % __CT_DYNLIST_WORD_BITS));
+
+		while (word != 0 && count < maxCount) {
+			nodeIndex	= (wordIndex * __CT_DYNLIST_WORD_BITS) + __CTDynListLowestBit(word);
+			word		&= word - 1;
+			elementsOut[count++] = __CTDynListElement(list, node, nodeIndex);
+		}
+
+		iterator->currentNodeIndex = (word == 0) ?
+			(wordIndex + 1) * __CT_DYNLIST_WORD_BITS :
+			nodeIndex + 1;
+	}
+
+	return count;
+}
+
+CTCALL	BOOL		CTIteratorBegin(PCTDynList list, PCTIterator iterator) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTIteratorBegin failed: list was NULL");
+		return FALSE;
+	}
+	if (iterator == NULL) {
+		CTErrorSetBadObject("CTIteratorBegin failed: iterator was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// BEGIN READING LIST
+	/// setup caller owned iterator at first node (loaded inside read section)
+
+	CTDynListReadBegin(list);
+
+	iterator->currentNode		= list->nodeFirst;
+	iterator->currentNodeIndex	= 0;
+	iterator->parent			= list;
+	iterator->arena				= NULL;
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTIteratorEnd(PCTIterator iterator) {
+	if (iterator == NULL) {
+		CTErrorSetBadObject("CTIteratorEnd failed: iterator was NULL");
+		return FALSE;
+	}
+	if (iterator->parent == NULL) {
+		CTErrorSetBadObject("CTIteratorEnd failed: iterator was not started");
+		return FALSE;
+	}
+
+	CTDynListReadEnd(iterator->parent);
+	iterator->parent		= NULL;
+	iterator->currentNode	= NULL;
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTDynListForEach(PCTDynList list, PCTFUNCDYNLISTFOREACH func, PVOID input) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListForEach failed: list was NULL");
+		return FALSE;
+	}
+	if (func == NULL) {
+		CTErrorSetParamValue("CTDynListForEach failed: func was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// BEGIN READING LIST
+	/// for (each node, each non-empty occupancy word, each set bit)
+	///		call func with element
+	///		if (func returned FALSE)
+	///			stop iterating
+	/// END READING LIST
 
-		if (iterator->currentNodeIndex < iterator->parent->elementsPerNode) {
+	CTDynListReadBegin(list);
 
-			BOOL fieldState = iterator->currentNode->useField[iterator->currentNodeIndex];
+	UINT32 wordCount = __CTDynListWordCount(list);
 
-			if (fieldState == FALSE) {
+	for (PCTDynListNode node = list->nodeFirst; node != NULL; node = node->nextNode) {
+		for (UINT32 wordIndex = 0; wordIndex < wordCount; wordIndex++) {
+			for (UINT64 word = node->useBits[wordIndex]; word != 0; word &= word - 1) {
 
-				iterator->currentNodeIndex += 1;
-				continue;
+				UINT32 nodeIndex = (wordIndex * __CT_DYNLIST_WORD_BITS) + __CTDynListLowestBit(word);
 
-			} else {
+				if (func(__CTDynListElement(list, node, nodeIndex), input) == FALSE) {
+					CTDynListReadEnd(list);
+					return TRUE;
+				}
 
-				PBYTE elementPtr = 
-					iterator->currentNode->elements + 
-					(iterator->parent->elementSizeBytes * iterator->currentNodeIndex);
+			}
+		}
+	}
 
-				iterator->currentNodeIndex += 1;
-				return elementPtr;
+	CTDynListReadEnd(list);
+
+	return TRUE;
+}
+
+static void __HCTDynListParallelRun(P__CTDynListParallelJob job) {
+
+	/// SUMMARY:
+	/// while (no callback asked to stop):
+	///		claim next chunk, exit if none are left
+	///		call func on every live element of chunk
+	///		if (func returned FALSE)
+	///			signal all workers to stop
+
+	while (job->stopSignal == FALSE) {
+
+		LONG chunkIndex = InterlockedIncrement(&job->chunkNext) - 1;
+		if (chunkIndex >= job->chunkCount) return;
+
+		P__CTDynListParallelChunk chunk = job->chunks + chunkIndex;
+
+		for (UINT32 wordIndex = chunk->wordFirst; wordIndex < chunk->wordEnd; wordIndex++) {
+			for (UINT64 word = chunk->node->useBits[wordIndex]; word != 0; word &= word - 1) {
+
+				UINT32	nodeIndex	= (wordIndex * __CT_DYNLIST_WORD_BITS) + __CTDynListLowestBit(word);
+				PVOID	element		= __CTDynListElement(job->list, chunk->node, nodeIndex);
+
+				if (job->func(element, job->input) == FALSE) {
+					InterlockedExchange(&job->stopSignal, TRUE);
+					return;
+				}
 
 			}
-		} else {
+		}
+	}
+}
 
-			iterator->currentNode		= iterator->currentNode->nextNode;
-			iterator->currentNodeIndex	= 0;
+CTCALL	BOOL		CTDynListParallelForEach(PCTDynList list, PCTFUNCDYNLISTFOREACH func, PVOID input, UINT32 grainSize) {
+	return CTDynListParallelForEachEx(list, func, input, grainSize, CTThreadPoolDefault());
+}
 
+CTCALL	BOOL		CTDynListParallelForEachEx(PCTDynList list, PCTFUNCDYNLISTFOREACH func, PVOID input, UINT32 grainSize, PVOID threadPool) {
+	if (list == NULL) {
+		CTErrorSetBadObject("CTDynListParallelForEach failed: list was NULL");
+		return FALSE;
+	}
+	if (func == NULL) {
+		CTErrorSetParamValue("CTDynListParallelForEach failed: func was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// BEGIN READING LIST
+	/// if (list is empty) END READING LIST and return
+	/// cut every node into chunks of grainSize slots (rounded up to whole
+	/// occupancy words), coarsening the grain so the table holds about
+	/// CHUNKS_PER_WORKER chunks per thread taking part
+	/// take chunk table from the stack, or if it has too many nodes for
+	/// that from the frame arena (heap when the thread has no arena)
+	/// build chunk table (epoch lists may gain nodes while this runs, the
+	/// table is capped at its reserved size)
+	/// spawn one helper per pool worker, capped by chunk count - 1
+	/// run chunks on this thread too, then wait for the helpers
+	/// (workers need no epoch of their own, this thread's covers them)
+	/// END READING LIST
+
+	if (grainSize == 0)
+		grainSize = CT_DYNLIST_PARALLEL_GRAIN_DEFAULT;
+
+	CTDynListReadBegin(list);
+
+	UINT32 nodeCount = list->nodeCount;
+	if (nodeCount == 0 || list->elementsUsedCount == 0) {
+		CTDynListReadEnd(list);
+		return TRUE;
+	}
+
+	PCTThreadPool	pool			= threadPool;
+	UINT32			threadCount		= ((pool != NULL) ? pool->workerCount : 0) + 1;
+	UINT32			chunkTarget		= min(__CT_DYNLIST_PARALLEL_STACK_CHUNKS, threadCount * __CT_DYNLIST_PARALLEL_CHUNKS_PER_WORKER);
+	UINT32			wordCount		= __CTDynListWordCount(list);
+	UINT32			grainWords		= (grainSize + __CT_DYNLIST_WORD_BITS - 1) / __CT_DYNLIST_WORD_BITS;
+	UINT32			chunksPerNode	= (wordCount + grainWords - 1) / grainWords;
+
+	if ((UINT64)nodeCount * chunksPerNode > chunkTarget) {
+		chunksPerNode	= max(1, chunkTarget / nodeCount);
+		grainWords		= (wordCount + chunksPerNode - 1) / chunksPerNode;
+		chunksPerNode	= (wordCount + grainWords - 1) / grainWords;
+	}
+
+	__CTDynListParallelChunk	stackChunks[__CT_DYNLIST_PARALLEL_STACK_CHUNKS];
+	PVOID						heapChunks	= NULL;
+
+	__CTDynListParallelJob job = { 0 };
+	job.list		= list;
+	job.func		= func;
+	job.input		= input;
+	job.chunkCount	= nodeCount * chunksPerNode;
+	job.chunks		= stackChunks;
+
+	if (job.chunkCount > __CT_DYNLIST_PARALLEL_STACK_CHUNKS) {
+		PCTArena arena = CTArenaFrameGet();
+		if (arena != NULL)	job.chunks = CTArenaAlloc(arena, job.chunkCount * sizeof(*job.chunks));
+		else				job.chunks = heapChunks = CTAllocEx(job.chunkCount * sizeof(*job.chunks), CT_MEMORY_TAG_DYNLIST, FALSE);
+	}
+
+	P__CTDynListParallelChunk chunk		= job.chunks;
+	P__CTDynListParallelChunk chunkEnd	= job.chunks + job.chunkCount;
+	for (PCTDynListNode node = list->nodeFirst; node != NULL && chunk < chunkEnd; node = node->nextNode) {
+		if (node->elementUseCount == 0) continue;
+
+		for (UINT32 wordFirst = 0; wordFirst < wordCount && chunk < chunkEnd; wordFirst += grainWords) {
+			chunk->node			= node;
+			chunk->wordFirst	= wordFirst;
+			chunk->wordEnd		= min(wordFirst + grainWords, wordCount);
+			chunk++;
 		}
 	}
+	job.chunkCount = (LONG)(chunk - job.chunks);
+
+	LONG helperCount = (pool != NULL) ? min((LONG)pool->workerCount, job.chunkCount - 1) : 0;
+
+	CTTaskGroup group;
+	if (helperCount > 0) {
+		CTTaskGroupBegin(pool, &group);
+		for (LONG helperIndex = 0; helperIndex < helperCount; helperIndex++)
+			CTTaskGroupSpawn(&group, __HCTDynListParallelRun, &job);
+	}
+
+	if (job.chunkCount > 0)
+		__HCTDynListParallelRun(&job);
+
+	if (helperCount > 0)
+		CTTaskGroupWait(&group);
 
-	return NULL;
+	if (heapChunks != NULL)
+		CTFree(heapChunks);
+
+	CTDynListReadEnd(list);
+
+	return TRUE;
 }
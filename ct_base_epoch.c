@@ -0,0 +1,180 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_base_epoch.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_data.h"
+#include "ct_base.h"
+
+typedef struct __CTEpochRecord {
+	volatile LONG64	localEpoch;
+	volatile LONG	active;
+	BOOL			retired;
+	PVOID			next;
+} __CTEpochRecord, *P__CTEpochRecord;
+
+typedef struct __CTEpochThreadState {
+	UINT32				generation;
+	UINT32				nesting;
+	P__CTEpochRecord	record;
+} __CTEpochThreadState, *P__CTEpochThreadState;
+
+static __declspec(thread) __CTEpochThreadState __ctEpochState;
+static UINT32 __ctEpochGenerationCounter = 0;
+
+static P__CTEpochThreadState __HCTEpochGetState(void) {
+
+	/// SUMMARY:
+	/// if (state was filled before the last CogThornInit)
+	///		its record belongs to a destroyed heap, drop it
+
+	P__CTEpochThreadState state = &__ctEpochState;
+	if (state->generation != __ctdata.base.epoch.generation) {
+		ZeroMemory(state, sizeof(*state));
+		state->generation = __ctdata.base.epoch.generation;
+	}
+	return state;
+}
+
+static P__CTEpochRecord __HCTEpochGetRecord(P__CTEpochThreadState state) {
+	if (state->record != NULL)
+		return state->record;
+
+	/// SUMMARY:
+	/// ENTER LOCK
+	/// reuse record released by an exited thread if there is one
+	/// else allocate new record and publish it at the head of record list
+	/// (record list is walked without the lock, records are never unlinked)
+	/// LEAVE LOCK
+
+	EnterCriticalSection(&__ctdata.base.epoch.lock);
+
+	P__CTEpochRecord record = __ctdata.base.epoch.recordList;
+	while (record != NULL && record->retired == FALSE) {
+		record = record->next;
+	}
+
+	if (record == NULL) {
+		record			= HeapAlloc(__ctdata.base.heap, HEAP_ZERO_MEMORY, sizeof(*record));
+		record->next	= __ctdata.base.epoch.recordList;
+		InterlockedExchangePointer(&__ctdata.base.epoch.recordList, record);
+	}
+
+	record->retired	= FALSE;
+	state->record	= record;
+
+	LeaveCriticalSection(&__ctdata.base.epoch.lock);
+
+	return record;
+}
+
+static void __HCTEpochTryAdvance(void) {
+
+	/// SUMMARY:
+	/// read global epoch
+	/// if (any active reader entered before global epoch)
+	///		readers of an older epoch may still hold pointers, keep epoch
+	/// else
+	///		advance global epoch by one (unless another thread already did)
+
+	LONG64 globalEpoch = __ctdata.base.epoch.globalEpoch;
+
+	for (P__CTEpochRecord record = __ctdata.base.epoch.recordList; record != NULL; record = record->next) {
+		if (record->active == TRUE && record->localEpoch != globalEpoch)
+			return;
+	}
+
+	InterlockedCompareExchange64(
+		&__ctdata.base.epoch.globalEpoch,
+		globalEpoch + 1,
+		globalEpoch
+	);
+}
+
+CTCALL	BOOL		CTEpochEnter(void) {
+
+	/// SUMMARY:
+	/// if (thread is not already inside an epoch)
+	///		store global epoch into record, mark record active
+	///		store global epoch again, it may have moved before record was
+	///		seen as active (interlocked stores keep all later reads behind)
+	/// increment nesting
+
+	P__CTEpochThreadState	state	= __HCTEpochGetState();
+	P__CTEpochRecord		record	= __HCTEpochGetRecord(state);
+
+	if (state->nesting == 0) {
+		InterlockedExchange64(&record->localEpoch, __ctdata.base.epoch.globalEpoch);
+		InterlockedExchange(&record->active, TRUE);
+		InterlockedExchange64(&record->localEpoch, __ctdata.base.epoch.globalEpoch);
+	}
+
+	state->nesting += 1;
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTEpochLeave(void) {
+	P__CTEpochThreadState state = __HCTEpochGetState();
+
+	if (state->nesting == 0) {
+		CTErrorSetFunction("CTEpochLeave failed: thread was not inside an epoch");
+		return FALSE;
+	}
+
+	state->nesting -= 1;
+
+	if (state->nesting == 0)
+		InterlockedExchange(&state->record->active, FALSE);
+
+	return TRUE;
+}
+
+CTCALL	UINT64		CTEpochCurrent(void) {
+	return (UINT64)__ctdata.base.epoch.globalEpoch;
+}
+
+CTCALL	BOOL		CTEpochSafe(UINT64 epoch) {
+
+	/// SUMMARY:
+	/// memory retired at epoch E may still be seen by readers of E - 1 and E,
+	/// once global epoch has reached E + 2 all of those readers have left
+	/// if (not yet safe)
+	///		try to advance global epoch and check again
+
+	if ((UINT64)__ctdata.base.epoch.globalEpoch >= epoch + CT_EPOCH_GRACE_PERIODS)
+		return TRUE;
+
+	__HCTEpochTryAdvance();
+
+	return (UINT64)__ctdata.base.epoch.globalEpoch >= epoch + CT_EPOCH_GRACE_PERIODS;
+}
+
+CTCALL	void		CTEpochThreadRelease(void) {
+	P__CTEpochThreadState state = __HCTEpochGetState();
+
+	if (state->record == NULL || state->nesting != 0)
+		return;
+
+	EnterCriticalSection(&__ctdata.base.epoch.lock);
+	state->record->retired	= TRUE;
+	state->record			= NULL;
+	LeaveCriticalSection(&__ctdata.base.epoch.lock);
+}
+
+void	__CTEpochInit(void) {
+	InitializeCriticalSection(&__ctdata.base.epoch.lock);
+	__ctEpochGenerationCounter++;
+	__ctdata.base.epoch.generation	= __ctEpochGenerationCounter;
+	__ctdata.base.epoch.globalEpoch	= CT_EPOCH_GRACE_PERIODS;
+	__ctdata.base.epoch.recordList	= NULL;
+}
+
+void	__CTEpochCleanup(void) {
+
+	/// records live on the base heap and go away with it
+	DeleteCriticalSection(&__ctdata.base.epoch.lock);
+}
@@ -61,7 +61,7 @@ CTCALL	void		CTErrorAddCallback(PCTFUNCERRORCALLBACK pfErrCallback) {
 	/// inserts new callback node as first element of callback list
 	
 	PCTErrMsgCallbackNode oldFirstNode = __ctdata.base.errorCallbackList;
-	PCTErrMsgCallbackNode newFirstNode = CTAlloc(sizeof(*newFirstNode));
+	PCTErrMsgCallbackNode newFirstNode = CTAllocEx(sizeof(*newFirstNode), CT_MEMORY_TAG_BASE, TRUE);
 
 	__ctdata.base.errorCallbackList	= newFirstNode;
 	newFirstNode->func			= pfErrCallback;
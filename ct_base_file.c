@@ -22,7 +22,7 @@ CTCALL	PCTFile		CTFileCreate(PCHAR path) {
 		return NULL;
 	}
 
-	PCTFile file	= CTAlloc(sizeof(*file));
+	PCTFile file	= CTAllocEx(sizeof(*file), CT_MEMORY_TAG_BASE, TRUE);
 	file->hFile = CreateFileA(
 		path,
 		GENERIC_READ | GENERIC_WRITE,
@@ -73,7 +73,7 @@ CTCALL	PCTFile		CTFileOpen(PCHAR path) {
 		return NULL;
 	}
 
-	PCTFile file = CTAlloc(sizeof(*file));
+	PCTFile file = CTAllocEx(sizeof(*file), CT_MEMORY_TAG_BASE, TRUE);
 	file->hFile = CreateFileA(
 		path,
 		GENERIC_READ | GENERIC_WRITE,
@@ -113,6 +113,9 @@ CTCALL	BOOL		CTFileClose(PCTFile* pFile) {
 		return FALSE;
 	}
 
+	if (file->mapView != NULL)
+		CTFileUnmap(file);
+
 	CloseHandle(file->hFile);
 	CTFree(file);
 
@@ -140,7 +143,8 @@ CTCALL	BOOL		CTFileRead(PCTFile file, PVOID buffer, SIZE_T offset, SIZE_T sizeBy
 	}
 
 	OVERLAPPED readOffset	= { 0 };
-	readOffset.Offset		= offset;
+	readOffset.Offset		= (DWORD)offset;
+	readOffset.OffsetHigh	= (DWORD)((UINT64)offset >> 32);
 	BOOL rslt = ReadFile(
 		file->hFile,
 		buffer,
@@ -168,7 +172,8 @@ CTCALL	BOOL		CTFileWrite(PCTFile file, PVOID buffer, SIZE_T offset, SIZE_T sizeB
 	}
 
 	OVERLAPPED readOffset	= { 0 };
-	readOffset.Offset		= offset;
+	readOffset.Offset		= (DWORD)offset;
+	readOffset.OffsetHigh	= (DWORD)((UINT64)offset >> 32);
 
 	BOOL rslt = WriteFile(
 		file->hFile,
@@ -183,5 +188,80 @@ CTCALL	BOOL		CTFileWrite(PCTFile file, PVOID buffer, SIZE_T offset, SIZE_T sizeB
 		return FALSE;
 	}
 
+	return TRUE;
+}
+
+CTCALL	PVOID		CTFileMap(PCTFile file) {
+	if (file == NULL) {
+		CTErrorSetBadObject("CTFileMap failed: file was NULL");
+		return NULL;
+	}
+
+	/// SUMMARY:
+	/// if (already mapped)
+	///		return existing view
+	/// create read-only mapping of whole file
+	/// map view of whole file
+
+	if (file->mapView != NULL)
+		return file->mapView;
+
+	SIZE_T fileSize = CTFileSize(file);
+	if (fileSize == 0) {
+		CTErrorSetFunction("CTFileMap failed: file was empty");
+		return NULL;
+	}
+
+	file->hMapping = CreateFileMappingA(
+		file->hFile,
+		NULL,
+		PAGE_READONLY,
+		0,
+		0,
+		NULL
+	);
+
+	if (file->hMapping == NULL) {
+		CTErrorSetFunction("CTFileMap failed: could not create mapping");
+		return NULL;
+	}
+
+	file->mapView = MapViewOfFile(
+		file->hMapping,
+		FILE_MAP_READ,
+		0,
+		0,
+		0
+	);
+
+	if (file->mapView == NULL) {
+		CloseHandle(file->hMapping);
+		file->hMapping = NULL;
+		CTErrorSetFunction("CTFileMap failed: could not map view");
+		return NULL;
+	}
+
+	file->mapSize = fileSize;
+
+	return file->mapView;
+}
+
+CTCALL	BOOL		CTFileUnmap(PCTFile file) {
+	if (file == NULL) {
+		CTErrorSetBadObject("CTFileUnmap failed: file was NULL");
+		return FALSE;
+	}
+	if (file->mapView == NULL) {
+		CTErrorSetFunction("CTFileUnmap failed: file was not mapped");
+		return FALSE;
+	}
+
+	UnmapViewOfFile(file->mapView);
+	CloseHandle(file->hMapping);
+
+	file->mapView	= NULL;
+	file->hMapping	= NULL;
+	file->mapSize	= 0;
+
 	return TRUE;
 }
\ No newline at end of file
@@ -9,7 +9,7 @@
 #include "ct_base.h"
 
 CTCALL	PCTLock		CTLockCreate(void) {
-	PCTLock lock = CTAlloc(sizeof(*lock));
+	PCTLock lock = CTAllocEx(sizeof(*lock), CT_MEMORY_TAG_BASE, TRUE);
 	InitializeCriticalSection(&lock->lock);
 	return lock;
 }
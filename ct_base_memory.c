@@ -11,29 +11,414 @@
 
 #include <intrin.h>
 
+typedef struct __CTAllocHeader {
+	UINT64	sizeBytes;
+	UINT32	sizeClass;
+	UINT32	tag;
+} __CTAllocHeader, *P__CTAllocHeader;
+
+typedef struct __CTMemoryCounters {
+	SSIZE_T	pendingBytes	[CT_MEMORY_TAG_COUNT];
+	SSIZE_T	pendingCount	[CT_MEMORY_TAG_COUNT];
+	BOOL	retired;
+	PVOID	next;
+} __CTMemoryCounters, *P__CTMemoryCounters;
+
+typedef struct __CTAllocThreadCache {
+	UINT32				generation;
+	P__CTAllocHeader	freeList	[CT_ALLOC_CLASS_COUNT];
+	UINT32				freeCount	[CT_ALLOC_CLASS_COUNT];
+	P__CTMemoryCounters	counters;
+} __CTAllocThreadCache, *P__CTAllocThreadCache;
+
+static PCHAR __ctMemoryTagNames[CT_MEMORY_TAG_COUNT] = {
+	"User",
+	"Base",
+	"DynList",
+	"Logging",
+	"Graphics",
+	"FrameBuffer",
+	"Texture",
+	"Mesh"
+};
+
+static __declspec(thread) __CTAllocThreadCache __ctAllocCache;
+static UINT32 __ctAllocGenerationCounter = 0;
+
+#define __CT_ALLOC_NEXT(header)	(*(P__CTAllocHeader*)((header) + 1))
+
+static __forceinline UINT32 __HCTAllocSizeClass(SIZE_T sizeBytes) {
+	if (sizeBytes <= (1 << CT_ALLOC_CLASS_MIN_SHIFT))
+		return 0;
+	if (sizeBytes > CT_ALLOC_CLASS_MAX_SIZE)
+		return CT_ALLOC_CLASS_LARGE;
+
+	ULONG highBit;
+	_BitScanReverse(&highBit, (ULONG)(sizeBytes - 1));
+	return highBit + 1 - CT_ALLOC_CLASS_MIN_SHIFT;
+}
+
+static __forceinline SIZE_T __HCTAllocSlotSize(UINT32 sizeClass) {
+	return sizeof(__CTAllocHeader) + ((SIZE_T)1 << (sizeClass + CT_ALLOC_CLASS_MIN_SHIFT));
+}
+
+static P__CTAllocThreadCache __HCTAllocGetCache(void) {
+
+	/// SUMMARY:
+	/// if (cache was filled before the last CogThornInit)
+	///		its slots belong to a destroyed heap, drop them
+
+	P__CTAllocThreadCache cache = &__ctAllocCache;
+	if (cache->generation != __ctdata.base.slab.generation) {
+		ZeroMemory(cache, sizeof(*cache));
+		cache->generation = __ctdata.base.slab.generation;
+	}
+	return cache;
+}
+
+static P__CTMemoryCounters __HCTMemoryGetCounters(P__CTAllocThreadCache cache) {
+	if (cache->counters != NULL)
+		return cache->counters;
+
+	/// SUMMARY:
+	/// ENTER LOCK
+	/// reuse counters retired by an exited thread if there are any
+	/// else allocate new counters and link them into the counter list
+	/// LEAVE LOCK
+
+	EnterCriticalSection(&__ctdata.base.memory.lock);
+
+	P__CTMemoryCounters counters = __ctdata.base.memory.counterList;
+	while (counters != NULL && counters->retired == FALSE) {
+		counters = counters->next;
+	}
+
+	if (counters == NULL) {
+		counters		= HeapAlloc(__ctdata.base.heap, HEAP_ZERO_MEMORY, sizeof(*counters));
+		counters->next	= __ctdata.base.memory.counterList;
+		__ctdata.base.memory.counterList = counters;
+	}
+
+	counters->retired	= FALSE;
+	cache->counters		= counters;
+
+	LeaveCriticalSection(&__ctdata.base.memory.lock);
+
+	return counters;
+}
+
+static void __HCTMemoryRaisePeak(volatile LONG64* peak, LONG64 value) {
+	LONG64 prevPeak = *peak;
+	while (value > prevPeak) {
+		LONG64 seenPeak = InterlockedCompareExchange64(peak, value, prevPeak);
+		if (seenPeak == prevPeak) break;
+		prevPeak = seenPeak;
+	}
+}
+
+static void __HCTMemoryPublish(P__CTMemoryCounters counters, UINT32 tag) {
+
+	/// SUMMARY:
+	/// (caller holds memory lock, so CTMemoryReport never sees the
+	///  pending counters both added to shared totals and not yet cleared)
+	/// add pending counters of tag to shared totals
+	/// clear pending counters
+	/// raise tag and total high-water marks
+
+	SSIZE_T pendingBytes = counters->pendingBytes[tag];
+	SSIZE_T pendingCount = counters->pendingCount[tag];
+
+	LONG64 tagLive		= InterlockedExchangeAdd64(&__ctdata.base.memory.liveBytes[tag], pendingBytes) + pendingBytes;
+	LONG64 totalLive	= InterlockedExchangeAdd64(&__ctdata.base.memory.totalLiveBytes, pendingBytes) + pendingBytes;
+	InterlockedExchangeAdd64(&__ctdata.base.memory.liveCount[tag], pendingCount);
+
+	counters->pendingBytes[tag] = 0;
+	counters->pendingCount[tag] = 0;
+
+	__HCTMemoryRaisePeak(&__ctdata.base.memory.peakBytes[tag], tagLive);
+	__HCTMemoryRaisePeak(&__ctdata.base.memory.totalPeakBytes, totalLive);
+}
+
+static BOOL __HCTAllocRefill(P__CTAllocThreadCache cache, UINT32 sizeClass) {
+
+	/// SUMMARY:
+	/// ENTER LOCK
+	/// move up to a batch of slots from shared free list into cache
+	/// LEAVE LOCK
+	/// if (shared list was empty)
+	///		carve a new slab into the cache
+
+	EnterCriticalSection(&__ctdata.base.slab.lock);
+
+	P__CTAllocHeader sharedList = __ctdata.base.slab.freeList[sizeClass];
+	while (sharedList != NULL && cache->freeCount[sizeClass] < CT_ALLOC_CACHE_BATCH) {
+		P__CTAllocHeader nextSlot	= __CT_ALLOC_NEXT(sharedList);
+		__CT_ALLOC_NEXT(sharedList)	= cache->freeList[sizeClass];
+		cache->freeList[sizeClass]	= sharedList;
+		cache->freeCount[sizeClass]++;
+		sharedList = nextSlot;
+	}
+	__ctdata.base.slab.freeList[sizeClass] = sharedList;
+
+	LeaveCriticalSection(&__ctdata.base.slab.lock);
+
+	if (cache->freeCount[sizeClass] != 0)
+		return TRUE;
+
+	PBYTE slab = HeapAlloc(__ctdata.base.heap, 0, CT_ALLOC_SLAB_SIZE);
+	if (slab == NULL)
+		return FALSE;
+
+	SIZE_T slotSize		= __HCTAllocSlotSize(sizeClass);
+	SIZE_T slotCount	= CT_ALLOC_SLAB_SIZE / slotSize;
+	for (SIZE_T slotIndex = 0; slotIndex < slotCount; slotIndex++) {
+		P__CTAllocHeader slot		= (P__CTAllocHeader)(slab + (slotIndex * slotSize));
+		__CT_ALLOC_NEXT(slot)		= cache->freeList[sizeClass];
+		cache->freeList[sizeClass]	= slot;
+	}
+	cache->freeCount[sizeClass] += (UINT32)slotCount;
+
+	return TRUE;
+}
+
+static void __HCTAllocRelease(P__CTAllocThreadCache cache, UINT32 sizeClass, UINT32 releaseCount) {
+
+	/// SUMMARY:
+	/// detach releaseCount slots from head of cache
+	/// ENTER LOCK
+	/// splice them onto shared free list
+	/// LEAVE LOCK
+
+	P__CTAllocHeader releaseHead = cache->freeList[sizeClass];
+	P__CTAllocHeader releaseTail = releaseHead;
+	for (UINT32 slotIndex = 1; slotIndex < releaseCount; slotIndex++) {
+		releaseTail = __CT_ALLOC_NEXT(releaseTail);
+	}
+
+	cache->freeList[sizeClass]	= __CT_ALLOC_NEXT(releaseTail);
+	cache->freeCount[sizeClass]	-= releaseCount;
+
+	EnterCriticalSection(&__ctdata.base.slab.lock);
+	__CT_ALLOC_NEXT(releaseTail)			= __ctdata.base.slab.freeList[sizeClass];
+	__ctdata.base.slab.freeList[sizeClass]	= releaseHead;
+	LeaveCriticalSection(&__ctdata.base.slab.lock);
+}
+
+static PVOID __HCTAllocBlock(SIZE_T sizeBytes, UINT32 tag) {
+
+	/// SUMMARY:
+	/// if (large allocation)
+	///		allocate header + block from heap
+	/// else
+	///		if (thread cache for size class is empty)
+	///			refill it
+	///		pop slot from thread cache
+	/// write size and tag into header and account allocation
+
+	UINT32				sizeClass	= __HCTAllocSizeClass(sizeBytes);
+	P__CTAllocHeader	header		= NULL;
+
+	if (sizeClass == CT_ALLOC_CLASS_LARGE) {
+
+		header = HeapAlloc(__ctdata.base.heap, 0, sizeof(*header) + sizeBytes);
+
+	} else {
+
+		P__CTAllocThreadCache cache = __HCTAllocGetCache();
+
+		if (cache->freeCount[sizeClass] != 0 || __HCTAllocRefill(cache, sizeClass) == TRUE) {
+			header						= cache->freeList[sizeClass];
+			cache->freeList[sizeClass]	= __CT_ALLOC_NEXT(header);
+			cache->freeCount[sizeClass]--;
+		}
+
+	}
+
+	if (header == NULL) {
+		CTErrorSetFunction("CTAlloc failed: heap error");
+		return NULL;
+	}
+
+	header->sizeBytes = sizeBytes;
+	header->sizeClass = sizeClass;
+	header->tag		  = tag;
+
+	__CTMemoryAccount(tag, sizeBytes, 1);
+
+	return header + 1;
+}
+
 CTCALL	PVOID	CTAlloc(SIZE_T sizeBytes) {
+	return CTAllocEx(sizeBytes, CT_MEMORY_TAG_USER, TRUE);
+}
+
+CTCALL	PVOID	CTAllocUninit(SIZE_T sizeBytes) {
+	return CTAllocEx(sizeBytes, CT_MEMORY_TAG_USER, FALSE);
+}
 
-	__ctdata.base.heapAllocBytes += sizeBytes;
-	__ctdata.base.heapAllocCount += 1;
+CTCALL	PVOID	CTAllocEx(SIZE_T sizeBytes, UINT32 tag, BOOL zeroMemory) {
+	if (tag >= CT_MEMORY_TAG_COUNT) {
+		CTErrorSetParamValue("CTAllocEx failed: invalid tag");
+		return NULL;
+	}
 
-	PVOID ptr = HeapAlloc(__ctdata.base.heap, 0, sizeBytes);
-	__stosb(ptr, 0, sizeBytes);
+	PVOID ptr = __HCTAllocBlock(sizeBytes, tag);
+	if (ptr != NULL && zeroMemory == TRUE)
+		__stosb(ptr, 0, sizeBytes);
 
 	return ptr;
 }
 
 CTCALL	void	CTFree(PVOID ptr) {
+	if (ptr == NULL)
+		return;
+
+	/// SUMMARY:
+	/// read size, class and tag from header and account free
+	/// if (large allocation)
+	///		return block to heap
+	/// else
+	///		push slot onto thread cache
+	///		if (thread cache for size class is full)
+	///			release a batch to the shared free list
+
+	P__CTAllocHeader header = (P__CTAllocHeader)ptr - 1;
 
-	__ctdata.base.heapAllocBytes -= HeapSize(__ctdata.base.heap, 0, ptr);
-	__ctdata.base.heapAllocCount -= 1;
+	__CTMemoryAccount(header->tag, -(SSIZE_T)header->sizeBytes, -1);
 
-	HeapFree(__ctdata.base.heap, 0, ptr);
+	UINT32 sizeClass = header->sizeClass;
+
+	if (sizeClass == CT_ALLOC_CLASS_LARGE) {
+		HeapFree(__ctdata.base.heap, 0, header);
+		return;
+	}
+
+	P__CTAllocThreadCache cache = __HCTAllocGetCache();
+	__CT_ALLOC_NEXT(header)		= cache->freeList[sizeClass];
+	cache->freeList[sizeClass]	= header;
+	cache->freeCount[sizeClass]++;
+
+	if (cache->freeCount[sizeClass] > CT_ALLOC_CACHE_MAX)
+		__HCTAllocRelease(cache, sizeClass, CT_ALLOC_CACHE_BATCH);
 }
 
 CTCALL	SIZE_T	CTAllocCount(void) {
-	return __ctdata.base.heapAllocCount;
+	CTMemoryStats stats;
+	CTMemoryReport(&stats);
+	return stats.liveCount;
 }
 
 CTCALL	SIZE_T	CTAllocSizeBytes(void) {
-	return __ctdata.base.heapAllocBytes;
+	CTMemoryStats stats;
+	CTMemoryReport(&stats);
+	return stats.liveBytes;
+}
+
+CTCALL	void	CTAllocThreadCacheFlush(void) {
+
+	/// SUMMARY:
+	/// release all cached slots to shared free lists
+	/// publish all pending counters and retire them for reuse
+
+	P__CTAllocThreadCache cache = __HCTAllocGetCache();
+	for (UINT32 sizeClass = 0; sizeClass < CT_ALLOC_CLASS_COUNT; sizeClass++) {
+		if (cache->freeCount[sizeClass] != 0)
+			__HCTAllocRelease(cache, sizeClass, cache->freeCount[sizeClass]);
+	}
+
+	if (cache->counters == NULL)
+		return;
+
+	EnterCriticalSection(&__ctdata.base.memory.lock);
+	for (UINT32 tag = 0; tag < CT_MEMORY_TAG_COUNT; tag++) {
+		__HCTMemoryPublish(cache->counters, tag);
+	}
+	cache->counters->retired = TRUE;
+	cache->counters = NULL;
+	LeaveCriticalSection(&__ctdata.base.memory.lock);
+}
+
+CTCALL	BOOL	CTMemoryReport(PCTMemoryStats statsOut) {
+	if (statsOut == NULL) {
+		CTErrorSetBadObject("CTMemoryReport failed: statsOut was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// ENTER LOCK
+	/// start from shared totals
+	/// add pending counters of every thread
+	/// LEAVE LOCK
+	/// raise peaks to at least the live values (and remember them)
+
+	ZeroMemory(statsOut, sizeof(*statsOut));
+
+	EnterCriticalSection(&__ctdata.base.memory.lock);
+
+	for (UINT32 tag = 0; tag < CT_MEMORY_TAG_COUNT; tag++) {
+		statsOut->tags[tag].liveBytes = __ctdata.base.memory.liveBytes[tag];
+		statsOut->tags[tag].liveCount = __ctdata.base.memory.liveCount[tag];
+		statsOut->tags[tag].peakBytes = __ctdata.base.memory.peakBytes[tag];
+	}
+	statsOut->peakBytes = __ctdata.base.memory.totalPeakBytes;
+
+	P__CTMemoryCounters counters = __ctdata.base.memory.counterList;
+	while (counters != NULL) {
+		for (UINT32 tag = 0; tag < CT_MEMORY_TAG_COUNT; tag++) {
+			statsOut->tags[tag].liveBytes += counters->pendingBytes[tag];
+			statsOut->tags[tag].liveCount += counters->pendingCount[tag];
+		}
+		counters = counters->next;
+	}
+
+	LeaveCriticalSection(&__ctdata.base.memory.lock);
+
+	for (UINT32 tag = 0; tag < CT_MEMORY_TAG_COUNT; tag++) {
+		PCTMemoryTagStats tagStats	= statsOut->tags + tag;
+		tagStats->peakBytes			= max(tagStats->peakBytes, tagStats->liveBytes);
+		statsOut->liveBytes			+= tagStats->liveBytes;
+		statsOut->liveCount			+= tagStats->liveCount;
+		__HCTMemoryRaisePeak(&__ctdata.base.memory.peakBytes[tag], tagStats->peakBytes);
+	}
+	statsOut->peakBytes = max(statsOut->peakBytes, statsOut->liveBytes);
+	__HCTMemoryRaisePeak(&__ctdata.base.memory.totalPeakBytes, statsOut->peakBytes);
+
+	return TRUE;
+}
+
+CTCALL	PCHAR	CTMemoryTagName(UINT32 tag) {
+	if (tag >= CT_MEMORY_TAG_COUNT) {
+		CTErrorSetParamValue("CTMemoryTagName failed: invalid tag");
+		return NULL;
+	}
+
+	return __ctMemoryTagNames[tag];
+}
+
+void	__CTAllocInit(void) {
+	InitializeCriticalSection(&__ctdata.base.slab.lock);
+	InitializeCriticalSection(&__ctdata.base.memory.lock);
+	__ctAllocGenerationCounter++;
+	__ctdata.base.slab.generation = __ctAllocGenerationCounter;
+}
+
+void	__CTAllocCleanup(void) {
+	DeleteCriticalSection(&__ctdata.base.memory.lock);
+	DeleteCriticalSection(&__ctdata.base.slab.lock);
+}
+
+void	__CTMemoryAccount(UINT32 tag, SSIZE_T sizeBytes, SSIZE_T count) {
+	P__CTMemoryCounters counters = __HCTMemoryGetCounters(__HCTAllocGetCache());
+
+	counters->pendingBytes[tag] += sizeBytes;
+	counters->pendingCount[tag] += count;
+
+	if (counters->pendingBytes[tag] >  CT_MEMORY_PUBLISH_BYTES ||
+		counters->pendingBytes[tag] < -CT_MEMORY_PUBLISH_BYTES ||
+		counters->pendingCount[tag] >  CT_MEMORY_PUBLISH_COUNT ||
+		counters->pendingCount[tag] < -CT_MEMORY_PUBLISH_COUNT) {
+		EnterCriticalSection(&__ctdata.base.memory.lock);
+		__HCTMemoryPublish(counters, tag);
+		LeaveCriticalSection(&__ctdata.base.memory.lock);
+	}
 }
\ No newline at end of file
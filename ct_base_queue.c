@@ -0,0 +1,368 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_base_queue.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_base.h"
+
+#include <intrin.h>
+
+#define __CT_QUEUE_OVERFLOW_SEQUENCE	(-1LL)
+
+typedef struct __CTQueueCellHeader {
+	volatile LONG64	sequence;
+} __CTQueueCellHeader, *P__CTQueueCellHeader;
+
+typedef struct __CTQueueSegment {
+	struct __CTQueueSegment*	next;
+	UINT32						readIndex;
+	UINT32						writeIndex;
+} __CTQueueSegment, *P__CTQueueSegment;
+
+static __forceinline P__CTQueueCellHeader __HCTQueueCell(PCTQueue queue, LONG64 position) {
+	return (P__CTQueueCellHeader)(queue->cells + ((SIZE_T)(position & queue->capacityMask) * queue->cellSizeBytes));
+}
+
+static __forceinline PVOID __HCTQueueCellData(P__CTQueueCellHeader cell) {
+	return (PBYTE)cell + CT_QUEUE_CELL_HEADER_SIZE;
+}
+
+static __forceinline P__CTQueueCellHeader __HCTQueueSegmentCell(PCTQueue queue, P__CTQueueSegment segment, UINT32 index) {
+	return (P__CTQueueCellHeader)((PBYTE)(segment + 1) + ((SIZE_T)index * queue->cellSizeBytes));
+}
+
+static P__CTQueueCellHeader __HCTQueueClaim(PCTQueue queue) {
+
+	/// SUMMARY:
+	/// loop:
+	///		read enqueue position and its cell's sequence
+	///		if (sequence == position)
+	///			cell is free, try to claim position with compare-exchange
+	///			if (claim succeeded) return cell
+	///		else if (sequence < position)
+	///			consumer has not freed this cell yet, queue is full
+	///		else
+	///			another producer claimed position first, reload and retry
+
+	LONG64 position = queue->enqueuePos;
+
+	while (TRUE) {
+		P__CTQueueCellHeader	cell		= __HCTQueueCell(queue, position);
+		LONG64					difference	= cell->sequence - position;
+
+		if (difference == 0) {
+			LONG64 observed = InterlockedCompareExchange64(&queue->enqueuePos, position + 1, position);
+			if (observed == position) return cell;
+			position = observed;
+		} else if (difference < 0) {
+			return NULL;
+		} else {
+			position = queue->enqueuePos;
+		}
+	}
+}
+
+static P__CTQueueCellHeader __HCTQueueOverflowClaim(PCTQueue queue) {
+
+	/// SUMMARY:
+	/// enter overflow lock (held until element is released)
+	/// mark overflow active so new producers skip the ring
+	/// if (tail segment is missing or full)
+	///		take spare segment or allocate one and link it behind tail
+	/// claim next cell of tail segment and mark it as an overflow cell
+
+	EnterCriticalSection(&queue->overflowLock);
+	queue->overflowActive = TRUE;
+
+	P__CTQueueSegment segment = queue->overflowTail;
+
+	if (segment == NULL || segment->writeIndex == queue->capacity) {
+		P__CTQueueSegment newSegment = queue->overflowSpare;
+		queue->overflowSpare = NULL;
+
+		if (newSegment == NULL) {
+			newSegment = CTAllocEx(
+				sizeof(__CTQueueSegment) + (queue->cellSizeBytes * queue->capacity),
+				CT_MEMORY_TAG_BASE,
+				FALSE
+			);
+		}
+
+		newSegment->next		= NULL;
+		newSegment->readIndex	= 0;
+		newSegment->writeIndex	= 0;
+
+		if (segment == NULL)	queue->overflowHead	= newSegment;
+		else					segment->next		= newSegment;
+
+		queue->overflowTail	= newSegment;
+		segment				= newSegment;
+	}
+
+	P__CTQueueCellHeader cell = __HCTQueueSegmentCell(queue, segment, segment->writeIndex);
+	cell->sequence = __CT_QUEUE_OVERFLOW_SEQUENCE;
+	segment->writeIndex++;
+
+	return cell;
+}
+
+static P__CTQueueCellHeader __HCTQueueAcquire(PCTQueue queue) {
+	if (queue->overflowActive == FALSE) {
+		P__CTQueueCellHeader cell = __HCTQueueClaim(queue);
+		if (cell != NULL) return cell;
+	}
+
+	return __HCTQueueOverflowClaim(queue);
+}
+
+static void __HCTQueueRelease(PCTQueue queue, P__CTQueueCellHeader cell) {
+	if (cell->sequence == __CT_QUEUE_OVERFLOW_SEQUENCE) {
+		queue->overflowCount++;
+		LeaveCriticalSection(&queue->overflowLock);
+		return;
+	}
+
+	/// publishing the sequence makes the element visible to the consumer
+	InterlockedExchange64(&cell->sequence, cell->sequence + 1);
+}
+
+static void __HCTQueueSegmentRetire(PCTQueue queue, P__CTQueueSegment segment) {
+	if (queue->overflowSpare == NULL)	queue->overflowSpare = segment;
+	else								CTFree(segment);
+}
+
+static UINT32 __HCTQueueOverflowDequeue(PCTQueue queue, PBYTE elementsOut, UINT32 maxCount) {
+
+	/// SUMMARY:
+	/// enter overflow lock
+	/// while (batch is not full and head segment exists):
+	///		if (head segment is fully read)
+	///			unlink it and keep it as spare or free it
+	///		else
+	///			copy next element out of head segment
+	/// if (overflow is empty) let producers use the ring again
+	/// leave overflow lock
+
+	UINT32 count = 0;
+
+	EnterCriticalSection(&queue->overflowLock);
+
+	while (count < maxCount && queue->overflowHead != NULL) {
+		P__CTQueueSegment segment = queue->overflowHead;
+
+		if (segment->readIndex == segment->writeIndex) {
+			if (segment == queue->overflowTail) {
+				queue->overflowHead = NULL;
+				queue->overflowTail = NULL;
+			} else {
+				queue->overflowHead = segment->next;
+			}
+			__HCTQueueSegmentRetire(queue, segment);
+			continue;
+		}
+
+		memcpy(
+			elementsOut + (count * queue->elementSizeBytes),
+			__HCTQueueCellData(__HCTQueueSegmentCell(queue, segment, segment->readIndex)),
+			queue->elementSizeBytes
+		);
+
+		segment->readIndex++;
+		queue->overflowCount--;
+		count++;
+	}
+
+	if (queue->overflowHead != NULL &&
+		queue->overflowHead == queue->overflowTail &&
+		queue->overflowCount == 0) {
+		__HCTQueueSegmentRetire(queue, queue->overflowHead);
+		queue->overflowHead = NULL;
+		queue->overflowTail = NULL;
+	}
+
+	if (queue->overflowHead == NULL)
+		queue->overflowActive = FALSE;
+
+	LeaveCriticalSection(&queue->overflowLock);
+
+	return count;
+}
+
+CTCALL	PCTQueue	CTQueueCreate(SIZE_T elemSize, UINT32 capacity) {
+	if (elemSize == 0) {
+		CTErrorSetParamValue("CTQueueCreate failed: elemSize was 0");
+		return NULL;
+	}
+	if (capacity < 2 || capacity > 0x40000000) {
+		CTErrorSetParamValue("CTQueueCreate failed: capacity was invalid");
+		return NULL;
+	}
+
+	/// SUMMARY:
+	/// round capacity up to power of two
+	/// allocate all cells up front, each cell's sequence starts at its index
+	/// overflow segments are only allocated once the ring fills up
+
+	ULONG highBit;
+	_BitScanReverse(&highBit, capacity - 1);
+	capacity = 1u << (highBit + 1);
+
+	PCTQueue queue			= CTAllocEx(sizeof(*queue), CT_MEMORY_TAG_BASE, TRUE);
+	queue->elementSizeBytes	= elemSize;
+	queue->cellSizeBytes	= CT_QUEUE_CELL_HEADER_SIZE + ((elemSize + 0xF) & ~((SIZE_T)0xF));
+	queue->capacity			= capacity;
+	queue->capacityMask		= capacity - 1;
+	queue->cells			= CTAllocEx(queue->cellSizeBytes * capacity, CT_MEMORY_TAG_BASE, TRUE);
+
+	for (UINT32 cellIndex = 0; cellIndex < capacity; cellIndex++) {
+		__HCTQueueCell(queue, cellIndex)->sequence = cellIndex;
+	}
+
+	InitializeCriticalSection(&queue->overflowLock);
+
+	return queue;
+}
+
+CTCALL	BOOL		CTQueueDestroy(PCTQueue* pQueue) {
+	if (pQueue == NULL) {
+		CTErrorSetBadObject("CTQueueDestroy failed: pQueue was NULL");
+		return FALSE;
+	}
+
+	PCTQueue queue = *pQueue;
+
+	if (queue == NULL) {
+		CTErrorSetBadObject("CTQueueDestroy failed: queue was NULL");
+		return FALSE;
+	}
+
+	P__CTQueueSegment segment = queue->overflowHead;
+	while (segment != NULL) {
+		P__CTQueueSegment next = segment->next;
+		CTFree(segment);
+		segment = next;
+	}
+	if (queue->overflowSpare != NULL)
+		CTFree(queue->overflowSpare);
+
+	DeleteCriticalSection(&queue->overflowLock);
+
+	CTFree(queue->cells);
+	CTFree(queue);
+
+	*pQueue = NULL;
+	return TRUE;
+}
+
+CTCALL	BOOL		CTQueueEnqueue(PCTQueue queue, PVOID element) {
+	if (queue == NULL) {
+		CTErrorSetBadObject("CTQueueEnqueue failed: queue was NULL");
+		return FALSE;
+	}
+	if (element == NULL) {
+		CTErrorSetParamValue("CTQueueEnqueue failed: element was NULL");
+		return FALSE;
+	}
+
+	P__CTQueueCellHeader cell = __HCTQueueAcquire(queue);
+
+	memcpy(__HCTQueueCellData(cell), element, queue->elementSizeBytes);
+
+	__HCTQueueRelease(queue, cell);
+
+	return TRUE;
+}
+
+CTCALL	PVOID		CTQueueEnqueueBegin(PCTQueue queue) {
+	if (queue == NULL) {
+		CTErrorSetBadObject("CTQueueEnqueueBegin failed: queue was NULL");
+		return NULL;
+	}
+
+	return __HCTQueueCellData(__HCTQueueAcquire(queue));
+}
+
+CTCALL	BOOL		CTQueueEnqueueEnd(PCTQueue queue, PVOID element) {
+	if (queue == NULL) {
+		CTErrorSetBadObject("CTQueueEnqueueEnd failed: queue was NULL");
+		return FALSE;
+	}
+	if (element == NULL) {
+		CTErrorSetParamValue("CTQueueEnqueueEnd failed: element was NULL");
+		return FALSE;
+	}
+
+	__HCTQueueRelease(queue, (P__CTQueueCellHeader)((PBYTE)element - CT_QUEUE_CELL_HEADER_SIZE));
+
+	return TRUE;
+}
+
+CTCALL	UINT32		CTQueueDequeueBatch(PCTQueue queue, PVOID elementsOut, UINT32 maxCount) {
+	if (queue == NULL) {
+		CTErrorSetBadObject("CTQueueDequeueBatch failed: queue was NULL");
+		return 0;
+	}
+	if (elementsOut == NULL) {
+		CTErrorSetParamValue("CTQueueDequeueBatch failed: elementsOut was NULL");
+		return 0;
+	}
+
+	/// SUMMARY:
+	/// while (batch is not full):
+	///		if (cell at dequeue position is not published yet)
+	///			break
+	///		copy element out
+	///		hand cell back to producers one lap ahead
+	/// store new dequeue position
+	/// if (batch is not full and ring is empty and overflow is active)
+	///		fill rest of batch from overflow segments
+	/// return amount of elements copied
+
+	LONG64	position	= queue->dequeuePos;
+	UINT32	count		= 0;
+
+	while (count < maxCount) {
+		P__CTQueueCellHeader cell = __HCTQueueCell(queue, position);
+		if (cell->sequence != position + 1) break;
+
+		memcpy(
+			(PBYTE)elementsOut + (count * queue->elementSizeBytes),
+			__HCTQueueCellData(cell),
+			queue->elementSizeBytes
+		);
+
+		InterlockedExchange64(&cell->sequence, position + queue->capacity);
+
+		position++;
+		count++;
+	}
+
+	queue->dequeuePos = position;
+
+	/// overflow elements are newer than everything claimed in the ring
+	/// before overflow became active, so only read them once ring is empty
+	if (count < maxCount &&
+		queue->overflowActive == TRUE &&
+		queue->enqueuePos == position) {
+		count += __HCTQueueOverflowDequeue(
+			queue,
+			(PBYTE)elementsOut + (count * queue->elementSizeBytes),
+			maxCount - count
+		);
+	}
+
+	return count;
+}
+
+CTCALL	UINT32		CTQueueCount(PCTQueue queue) {
+	if (queue == NULL) {
+		CTErrorSetBadObject("CTQueueCount failed: queue was NULL");
+		return 0;
+	}
+
+	/// includes ring cells which are claimed but not yet published
+	return (UINT32)(queue->enqueuePos - queue->dequeuePos) + (UINT32)queue->overflowCount;
+}
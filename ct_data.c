@@ -28,6 +28,8 @@ CTCALL	BOOL	CogThornInit(void) {
 	__ctdata.base.heap				= HeapCreate(0, 0, 0);
 	__ctdata.base.errorCallbackList	= NULL;
 	InitializeCriticalSection(&__ctdata.base.errorLock);
+	__CTAllocInit();
+	__CTEpochInit();
 
 	//////////////////////////////////////////////////////////////////////////////
 	///							  INITIALIZE GRAPHICS
@@ -37,6 +39,28 @@ CTCALL	BOOL	CogThornInit(void) {
 	__ctdata.gfx.gfxHeap	= HeapCreate(0, 0, 0);
 	SetProcessDPIAware();
 
+	__ctdata.gfx.snapshot.lock			= CTLockCreate();
+	__ctdata.gfx.snapshot.wakeSignal	= CreateEventA(
+		NULL,
+		FALSE,
+		FALSE,
+		NULL
+	);
+	__ctdata.gfx.snapshot.killSignal	= CreateEventA(
+		NULL,
+		TRUE,
+		FALSE,
+		NULL
+	);
+	__ctdata.gfx.snapshot.thread		= CreateThread(
+		NULL,
+		NULL,
+		__CTSnapshotThreadProc,
+		NULL,
+		NULL,
+		NULL
+	);
+
 	//////////////////////////////////////////////////////////////////////////////
 	///							  INITIALIZE LOGGING
 	//////////////////////////////////////////////////////////////////////////////
@@ -51,9 +75,9 @@ CTCALL	BOOL	CogThornInit(void) {
 		FALSE,
 		NULL
 	);
-	__ctdata.logging.logWriteQueue	= CTDynListCreate(
+	__ctdata.logging.logWriteQueue	= CTQueueCreate(
 		sizeof(CTLogEntry),
-		CT_LOGGING_QUEUE_NODE_SIZE
+		CT_LOGGING_QUEUE_CAPACITY
 	);
 	__ctdata.logging.logWriteThread	= CreateThread(
 		NULL,
@@ -72,17 +96,34 @@ CTCALL	BOOL	CogThornInit(void) {
 	timeGetDevCaps(&timeCaps, sizeof(TIMECAPS));
 	timeBeginPeriod(timeCaps.wPeriodMin);
 
+	ZeroMemory(&__ctdata.threading, sizeof(__ctdata.threading));
+	__CTFutureInit();
+	__ctdata.threading.pool = CTThreadPoolCreate(0);
+
 	//////////////////////////////////////////////////////////////////////////////
 	///						   INITIALIZE RENDERING SYSTEM
 	//////////////////////////////////////////////////////////////////////////////
 
 	ZeroMemory(&__ctdata.sys.rendering, sizeof(__ctdata.sys.rendering));
 
-	__ctdata.sys.rendering.thread = CTThreadCreate(
+	/// present thread owns the surface list, so it starts first
+	/// and is destroyed after the render thread
+
+	__ctdata.sys.rendering.presentThread = CTThreadCreateEx(
+		__CTPresentThreadProc,
+		NULL,
+		NULL,
+		CT_RTHREAD_SPINTIME_USEC,
+		0,
+		TRUE
+	);
+
+	__ctdata.sys.rendering.thread = CTThreadCreateEx(
 		__CTRenderThreadProc,
 		NULL,
 		NULL,
-		CT_RTHREAD_SPINTIME_MSEC,
+		CT_RTHREAD_SPINTIME_USEC,
+		CT_THREAD_FLAG_PACED,
 		TRUE
 	);
 
@@ -105,6 +146,18 @@ CTCALL	BOOL	CogThornTerminate(void) {
 	CTThreadDestroy(
 		&__ctdata.sys.rendering.thread
 	);
+	CTThreadDestroy(
+		&__ctdata.sys.rendering.presentThread
+	);
+
+	//////////////////////////////////////////////////////////////////////////////
+	///							  CLEANUP THREADDING
+	//////////////////////////////////////////////////////////////////////////////
+
+	CTThreadPoolDestroy(
+		&__ctdata.threading.pool
+	);
+	__CTFutureCleanup();
 
 	//////////////////////////////////////////////////////////////////////////////
 	///							  CLEANUP LOGGING
@@ -113,7 +166,7 @@ CTCALL	BOOL	CogThornTerminate(void) {
 	SetEvent(__ctdata.logging.killSignal);
 	WaitForSingleObject(__ctdata.logging.logWriteThread, INFINITE);
 
-	CTDynListDestroy(&__ctdata.logging.logWriteQueue);
+	CTQueueDestroy(&__ctdata.logging.logWriteQueue);
 	CTLockDestroy(&__ctdata.logging.lock);
 	CloseHandle(__ctdata.logging.killSignal);
 
@@ -121,6 +174,15 @@ CTCALL	BOOL	CogThornTerminate(void) {
 	///							  CLEANUP GRAPHICS
 	//////////////////////////////////////////////////////////////////////////////
 
+	SetEvent(__ctdata.gfx.snapshot.killSignal);
+	SetEvent(__ctdata.gfx.snapshot.wakeSignal);
+	WaitForSingleObject(__ctdata.gfx.snapshot.thread, INFINITE);
+
+	CloseHandle(__ctdata.gfx.snapshot.thread);
+	CloseHandle(__ctdata.gfx.snapshot.wakeSignal);
+	CloseHandle(__ctdata.gfx.snapshot.killSignal);
+	CTLockDestroy(&__ctdata.gfx.snapshot.lock);
+
 	HeapDestroy(__ctdata.gfx.gfxHeap);
 
 	//////////////////////////////////////////////////////////////////////////////
@@ -137,6 +199,8 @@ CTCALL	BOOL	CogThornTerminate(void) {
 	}
 
 	DeleteCriticalSection(&__ctdata.base.errorLock);
+	__CTEpochCleanup();
+	__CTAllocCleanup();
 	HeapDestroy(__ctdata.base.heap);
 
 	ZeroMemory(&__ctdata, sizeof(__ctdata));
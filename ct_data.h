@@ -25,8 +25,30 @@ struct {
 
 	struct {
 		HANDLE					heap;
-		SIZE_T					heapAllocCount;
-		SIZE_T					heapAllocBytes;
+
+		struct {
+			CRITICAL_SECTION	lock;
+			PVOID				freeList	[CT_ALLOC_CLASS_COUNT];
+			UINT32				generation;
+		} slab;
+
+		struct {
+			CRITICAL_SECTION	lock;
+			PVOID				counterList;
+			volatile LONG64		liveBytes	[CT_MEMORY_TAG_COUNT];
+			volatile LONG64		liveCount	[CT_MEMORY_TAG_COUNT];
+			volatile LONG64		peakBytes	[CT_MEMORY_TAG_COUNT];
+			volatile LONG64		totalLiveBytes;
+			volatile LONG64		totalPeakBytes;
+		} memory;
+
+		struct {
+			CRITICAL_SECTION	lock;
+			PVOID				recordList;
+			volatile LONG64		globalEpoch;
+			UINT32				generation;
+		} epoch;
+
 		CRITICAL_SECTION		errorLock;
 		CTErrMsg				lastError;
 		PCTErrMsgCallbackNode	errorCallbackList;
@@ -34,23 +56,46 @@ struct {
 
 	struct {
 		HANDLE		gfxHeap;
+		LONG		largePageState;
+		SIZE_T		largePageSize;
+
+		struct {
+			PCTLock		lock;
+			HANDLE		thread;
+			HANDLE		wakeSignal;
+			HANDLE		killSignal;
+			PVOID		queueHead;
+			PVOID		queueTail;
+			PVOID		stagingPool;
+			UINT32		stagingPoolCount;
+		} snapshot;
+
 	} gfx;
 
 	struct {
 		INT64		startTimeMsecs;
 		PCTLock		lock;
 		HANDLE		logWriteThread;
-		PCTDynList	logWriteQueue;
+		PCTQueue	logWriteQueue;
 		HANDLE		killSignal;
 	} logging;
 
+	struct {
+		PCTThreadPool		pool;
+		CRITICAL_SECTION	futureLock;
+		PVOID				futureFreeList;
+		UINT32				futureFreeCount;
+	} threading;
+
 	struct {
 
 		struct {
 			PCTLock			lock;
 			PCTThread		thread;
+			PCTThread		presentThread;
 			PCTLogStream	logStream;
 			PCTDynList		objList;
+			__CTGObjectStore	objStore;
 			PCTDynList		cameraList;
 			PCTDynList		surfaceList;
 			PCTShader		shader;
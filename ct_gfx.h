@@ -20,7 +20,24 @@
 /// 
 //////////////////////////////////////////////////////////////////////////////
 
+/// bulk allocations are backed directly by pages instead of the gfx heap.
+/// with CT_GFX_ALLOC_FLAG_LARGE_PAGES they ask for large pages, which needs
+/// SeLockMemoryPrivilege. if large pages are unavailable they quietly fall
+/// back to normal pages, CTGFXAllocBacking tells which backing was obtained
+
+#define CT_GFX_BACKING_HEAP				0
+#define CT_GFX_BACKING_PAGES			1
+#define CT_GFX_BACKING_LARGE_PAGES		2
+#define CT_GFX_ALLOC_FLAG_LARGE_PAGES	0x1
+#define CT_GFX_LARGE_PAGES_UNKNOWN		0
+#define CT_GFX_LARGE_PAGES_AVAILABLE	1
+#define CT_GFX_LARGE_PAGES_UNAVAILABLE	2
+
 CTCALL	PVOID		CTGFXAlloc(SIZE_T size);
+CTCALL	PVOID		CTGFXAllocEx(SIZE_T size, UINT32 tag);
+CTCALL	PVOID		CTGFXAllocBulk(SIZE_T size, UINT32 tag, UINT32 flags);
+CTCALL	UINT32		CTGFXAllocBacking(PVOID block);
+CTCALL	BOOL		CTGFXLargePagesAvailable(void);
 CTCALL	BOOL		CTGFXFree(PVOID block);
 
 //////////////////////////////////////////////////////////////////////////////
@@ -39,6 +56,13 @@ CTCALL	CTPoint			CTPointMultiply(CTPoint p, INT32 factor);
 CTCALL	CTPoint			CTPointFromVector(CTVect vect);
 CTCALL	CTVect			CTPointToVector(CTPoint p);
 
+typedef struct CTRect {
+	INT32	x, y;
+	UINT32	width, height;
+} CTRect, * PCTRect;
+
+CTCALL	CTRect			CTRectCreate(INT32 x, INT32 y, UINT32 width, UINT32 height);
+
 //////////////////////////////////////////////////////////////////////////////
 ///
 ///								COLOR
@@ -62,30 +86,316 @@ CTCALL	CTColor			CTColorBlendWeighted(CTColor c1, CTColor c2, FLOAT factor);
 /// 
 //////////////////////////////////////////////////////////////////////////////
 
+/// BGRA8888 framebuffers keep their pixels in color. compact formats leave
+/// color NULL and keep their pixels in packed (one UINT16 or BYTE per pixel,
+/// same row order). alpha is not stored by compact formats. INDEXED8 starts
+/// with a 3-3-2 RGB palette, writes are mapped to the nearest palette entry
+/// through a 15bit RGB lookup table. CTFrameBufferConvert(Row) expands any
+/// format to BGRA, which is what presenting does. with
+/// CT_FRAMEBUFFER_FLAG_LARGE_PAGES the color and depth planes are bulk
+/// allocated on large pages when possible, backing reports what was obtained.
+/// CT_FRAMEBUFFER_FLAG_NO_DEPTH leaves depth NULL for buffers which are only
+/// filled and presented: writes drop their depth, depth tests always pass and
+/// reads return FLT_MAX. pixelOps points at the format's
+/// CTFrameBufferPixelOps, picked at create time so pixel access never
+/// switches on the format. they take the memory index
+/// (x + (height - y - 1) * width), do no checks and leave depth alone;
+/// CTDraw fetches them once per draw and calls them per pixel
+
+#define CT_COLOR_FORMAT_BGRA8888		0
+#define CT_COLOR_FORMAT_RGB565			1
+#define CT_COLOR_FORMAT_INDEXED8		2
+#define CT_COLOR_PALETTE_SIZE			256
+#define CT_COLOR_PALETTE_LOOKUP_SIZE	0x8000
+#define CT_FRAMEBUFFER_FLAG_LARGE_PAGES	0x1
+#define CT_FRAMEBUFFER_FLAG_NO_DEPTH	0x2
 typedef struct CTFrameBuffer {
 	PCTLock		lock;
 	UINT32		width;
 	UINT32		height;
+	UINT32		format;
+	UINT32		backing;
 	PCTColor	color;
+	PVOID		packed;
+	PCTColor	palette;
+	PBYTE		paletteLookup;
 	PFLOAT		depth;
+	PVOID		pixelOps;
 } CTFrameBuffer, *PCTFrameBuffer, CTFB, *PCTFB;
 
+typedef void	(*PCTFUNCFBPIXELWRITE)(PCTFrameBuffer fb, UINT32 index, CTColor col);
+typedef CTColor	(*PCTFUNCFBPIXELREAD)(PCTFrameBuffer fb, UINT32 index);
+
+typedef struct CTFrameBufferPixelOps {
+	PCTFUNCFBPIXELWRITE	set;
+	PCTFUNCFBPIXELWRITE	blend;
+	PCTFUNCFBPIXELREAD	get;
+} CTFrameBufferPixelOps, *PCTFrameBufferPixelOps;
+
 CTCALL	PCTFB	CTFrameBufferCreate(UINT32 width, UINT32 height);
+CTCALL	PCTFB	CTFrameBufferCreateEx(UINT32 width, UINT32 height, UINT32 format, UINT32 flags);
 CTCALL	BOOL	CTFrameBufferDestroy(PCTFrameBuffer* pfb);
+CTCALL	BOOL	CTFrameBufferSetPalette(PCTFrameBuffer fb, PCTColor palette, UINT32 paletteCount);
 CTCALL	BOOL	CTFrameBufferSetEx(PCTFrameBuffer fb, CTPoint pt, CTColor col, FLOAT depth, BOOL safe);
+CTCALL	BOOL	CTFrameBufferBlendEx(PCTFrameBuffer fb, CTPoint pt, CTColor col, FLOAT depth, BOOL safe);
 CTCALL	BOOL	CTFrameBufferDepthTestEx(PCTFrameBuffer fb, CTPoint pt, FLOAT depth, BOOL safe);
 CTCALL	BOOL	CTFrameBufferGetEx(PCTFrameBuffer fb, CTPoint pt, PCTColor pCol, PFLOAT pDepth, BOOL safe);
 CTCALL	BOOL	CTFrameBufferLock(PCTFrameBuffer fb);
 CTCALL	BOOL	CTFrameBufferUnlock(PCTFrameBuffer fb);
 CTCALL	BOOL	CTFrameBufferClear(PCTFrameBuffer fb, BOOL color, BOOL depth);
+CTCALL	BOOL	CTFrameBufferConvertRow(PCTFrameBuffer fb, UINT32 memRow, PCTColor rowOut);
+CTCALL	BOOL	CTFrameBufferConvert(PCTFrameBuffer fb, PCTColor colorOut);
 
 #define CTFrameBufferSet(fb, pt, col, depth)	\
 	CTFrameBufferSetEx(fb, pt, col, depth, TRUE)
+#define CTFrameBufferBlend(fb, pt, col, depth)	\
+	CTFrameBufferBlendEx(fb, pt, col, depth, TRUE)
 #define CTFrameBufferDepthTest(fb, pt, depth)	\
 	CTFrameBufferDepthTestEx(fb, pt, depth, TRUE)
 #define CTFrameBufferGet(fb, pt, pCol, pDepth)	\
 	CTFrameBufferGetEx(fb, pt, pCol, pDepth, TRUE);
 
+//////////////////////////////////////////////////////////////////////////////
+///
+///								SWAP CHAIN
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// the producer (render thread) only ever touches the back buffer and
+/// the presenter only ever touches the front buffer. with 3 buffers the
+/// two sides exchange buffers through readyIndex without any lock, with
+/// 2 buffers the swap is guarded by swapLock for the length of a present
+
+typedef void (*PCTFUNCSWAPCONSUMER)(
+	PVOID	swapChain,
+	PCTFB	frontBuffer,
+	UINT64	frameNumber,
+	PVOID	input
+);
+
+typedef struct CTSwapConsumer {
+	PCTFUNCSWAPCONSUMER	func;
+	PVOID				input;
+} CTSwapConsumer, *PCTSwapConsumer;
+
+#define CT_SWAPCHAIN_BUFFERS_MIN		2
+#define CT_SWAPCHAIN_BUFFERS_MAX		3
+#define CT_SWAPCHAIN_CONSUMERS_MAX		4
+#define CT_SWAPCHAIN_INDEX_MASK			0x0F
+#define CT_SWAPCHAIN_FRESH_BIT			0x10
+typedef struct CTSwapChain {
+	PCTLock			swapLock;
+	PCTLock			consumerLock;
+	UINT32			bufferCount;
+	PCTFB			buffers		[CT_SWAPCHAIN_BUFFERS_MAX];
+	UINT64			bufferFrame	[CT_SWAPCHAIN_BUFFERS_MAX];
+	UINT32			backIndex;
+	volatile LONG	readyIndex;
+	UINT32			frontIndex;
+	UINT64			publishCount;
+	UINT64			presentCount;
+	UINT64			lastPresentedFrame;
+	CTSwapConsumer	consumers	[CT_SWAPCHAIN_CONSUMERS_MAX];
+} CTSwapChain, *PCTSwapChain;
+
+CTCALL	PCTSwapChain	CTSwapChainCreate(UINT32 width, UINT32 height, UINT32 bufferCount);
+CTCALL	PCTSwapChain	CTSwapChainCreateEx(UINT32 width, UINT32 height, UINT32 bufferCount, UINT32 colorFormat, UINT32 fbFlags);
+CTCALL	BOOL			CTSwapChainDestroy(PCTSwapChain* pSwapChain);
+CTCALL	PCTFB			CTSwapChainBackBuffer(PCTSwapChain swapChain);
+CTCALL	BOOL			CTSwapChainPublish(PCTSwapChain swapChain);
+CTCALL	PCTFB			CTSwapChainAcquireFront(PCTSwapChain swapChain, PUINT64 pFrameNumber);
+CTCALL	BOOL			CTSwapChainReleaseFront(PCTSwapChain swapChain);
+CTCALL	BOOL			CTSwapChainPresent(PCTSwapChain swapChain);
+CTCALL	BOOL			CTSwapChainAddConsumer(PCTSwapChain swapChain, PCTFUNCSWAPCONSUMER func, PVOID input);
+CTCALL	BOOL			CTSwapChainRemoveConsumer(PCTSwapChain swapChain, PCTFUNCSWAPCONSUMER func, PVOID input);
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								BLIT
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#define CT_BLIT_FILTER_NEAREST		0
+#define CT_BLIT_FILTER_BILINEAR		1
+#define CT_BLIT_BLEND_NONE			0
+#define CT_BLIT_BLEND_ALPHA			1
+CTCALL	BOOL	CTFrameBufferBlit(
+	PCTFB	dst,
+	PCTRect	dstRect,
+	PCTFB	src,
+	PCTRect	srcRect,
+	UINT32	filter,
+	UINT32	blend
+);
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								IMAGE
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// images are decoded straight into framebuffer color (BGRA, top row first)
+/// supported formats are BMP (24bit, 32bit) and QOI. when caching is on,
+/// the decoded pixels are written next to the source as <path>.ctraw and
+/// later loads copy them back out of a mapped view
+
+#define CT_IMAGE_DIMENSION_MAX		0x4000
+#define CT_IMAGE_CACHE_EXTENSION	".ctraw"
+CTCALL	PCTFB	CTFrameBufferLoad(PCHAR path);
+CTCALL	PCTFB	CTFrameBufferLoadEx(PCHAR path, BOOL useCache);
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								SNAPSHOT
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// a snapshot copies the framebuffer color into a pooled staging buffer
+/// (one memcpy under the framebuffer lock) and hands it to the snapshot
+/// thread, which encodes and writes the file. the caller never waits on disk.
+/// RAW files are width, height (UINT32 each) then BGRA pixels, top row first
+
+#define CT_SNAPSHOT_FORMAT_RAW			0
+#define CT_SNAPSHOT_FORMAT_BMP			1
+#define CT_SNAPSHOT_FORMAT_QOI			2
+#define CT_SNAPSHOT_STATUS_PENDING		0
+#define CT_SNAPSHOT_STATUS_COMPLETE		1
+#define CT_SNAPSHOT_STATUS_FAILED		2
+#define CT_SNAPSHOT_SLEEP_INTERVAL_MSEC	100
+#define CT_SNAPSHOT_POOL_MAX			4
+typedef struct CTSnapshotFence {
+	volatile LONG	status;
+} CTSnapshotFence, *PCTSnapshotFence;
+
+typedef void (*PCTFUNCSNAPSHOTDONE)(
+	PCHAR	path,
+	BOOL	success,
+	PVOID	input
+);
+
+CTCALL	BOOL	CTFrameBufferSnapshotAsync(PCTFB fb, PCHAR path, UINT32 format);
+CTCALL	BOOL	CTFrameBufferSnapshotAsyncEx(
+	PCTFB				fb,
+	PCHAR				path,
+	UINT32				format,
+	PCTSnapshotFence	fence,
+	PCTFUNCSNAPSHOTDONE	callback,
+	PVOID				input
+);
+CTCALL	UINT32	CTSnapshotFenceStatus(PCTSnapshotFence fence);
+CTCALL	UINT32	CTSnapshotFenceWait(PCTSnapshotFence fence, UINT32 timeoutMsec);
+
+DWORD __stdcall __CTSnapshotThreadProc(PVOID input);
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								RECORDER
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// a recorder copies every captured frame into a free slot of its ring and
+/// wakes its writer thread, which converts the frame to YUV 4:2:0 (full range
+/// BT.601) and appends it to the file through a large write buffer. if the
+/// ring is full the frame is dropped and counted, capture never waits.
+/// attach to a swap chain to record every presented frame (this includes
+/// headless surfaces), or call CTRecorderCapture from anywhere
+
+#define CT_RECORDER_FORMAT_RAW			0
+#define CT_RECORDER_FORMAT_Y4M			1
+#define CT_RECORDER_RING_MIN			2
+#define CT_RECORDER_RING_MAX			16
+#define CT_RECORDER_WRITE_BUFFER_SIZE	0x800000
+#define CT_RECORDER_SLOT_FREE			0
+#define CT_RECORDER_SLOT_FILLED			1
+typedef struct CTRecorder {
+	PCTFile			file;
+	PCTLock			captureLock;
+	UINT32			format;
+	UINT32			width;
+	UINT32			height;
+	UINT32			ringSize;
+	PCTColor		ring		[CT_RECORDER_RING_MAX];
+	volatile LONG	ringState	[CT_RECORDER_RING_MAX];
+	UINT32			captureIndex;
+	UINT32			writeIndex;
+	PBYTE			writeBuffer;
+	SIZE_T			writeBufferSize;
+	SIZE_T			writeBufferUsed;
+	UINT64			fileOffset;
+	BOOL			writeFailed;
+	HANDLE			thread;
+	HANDLE			wakeSignal;
+	volatile LONG	killSignal;
+	PCTSwapChain	swapChain;
+	volatile LONG64	framesCaptured;
+	volatile LONG64	framesWritten;
+	volatile LONG64	framesDropped;
+} CTRecorder, *PCTRecorder;
+
+CTCALL	PCTRecorder	CTRecorderCreate(
+	PCHAR	path,
+	UINT32	format,
+	UINT32	width,
+	UINT32	height,
+	UINT32	framesPerSecond,
+	UINT32	ringSize
+);
+CTCALL	BOOL		CTRecorderDestroy(PCTRecorder* pRecorder);
+CTCALL	BOOL		CTRecorderAttach(PCTRecorder recorder, PCTSwapChain swapChain);
+CTCALL	BOOL		CTRecorderDetach(PCTRecorder recorder);
+CTCALL	BOOL		CTRecorderCapture(PCTRecorder recorder, PCTFB fb);
+
+//////////////////////////////////////////////////////////////////////////////
+///
+///								TEXTURE
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// read-only sampling source without a depth plane. texels are stored in
+/// memory rows like a framebuffer (top row first) in one of these formats:
+/// BGRA	4 bytes per texel
+/// PAL8	1 byte palette index per texel, 256 entry palette
+/// RLE		per row runs, op byte n < 0x80 is n + 1 clear texels,
+///			n >= 0x80 is (n & 0x7F) + 1 literal texels which follow
+/// BC1		4x4 blocks of two RGB565 endpoints and 2 bit indices (8 bytes),
+///			1 bit alpha through the 3 color block mode
+/// CTTextureGet does no checks, the caller keeps x and y in bounds
+/// texel data of 2MB or more is bulk allocated, on large pages if possible
+/// RLE textures also keep a run table: every run's start column and data
+/// offset, rows in order, with rowRuns[memRow] the row's first run and
+/// rowRuns[height] the run count. CTTextureGet binary searches the row's
+/// runs for x instead of walking them
+
+#define CT_TEXTURE_FORMAT_BGRA			0
+#define CT_TEXTURE_FORMAT_PAL8			1
+#define CT_TEXTURE_FORMAT_RLE			2
+#define CT_TEXTURE_FORMAT_BC1			3
+#define CT_TEXTURE_PALETTE_SIZE			256
+#define CT_TEXTURE_RLE_RUN_MAX			128
+#define CT_TEXTURE_BC1_BLOCK_SIZE		8
+#define CT_TEXTURE_LARGE_PAGE_THRESHOLD	0x200000
+typedef struct CTTextureRun {
+	UINT32	column;
+	UINT32	offset;
+} CTTextureRun, *PCTTextureRun;
+
+typedef struct CTTexture {
+	UINT32			format;
+	UINT32			width;
+	UINT32			height;
+	SIZE_T			sizeBytes;
+	PBYTE			data;
+	PCTColor		palette;
+	PUINT32			rowOffsets;
+	PUINT32			rowRuns;
+	PCTTextureRun	runs;
+} CTTexture, *PCTTexture;
+
+CTCALL	PCTTexture	CTTextureCreate(PCTFB source, UINT32 format);
+CTCALL	BOOL		CTTextureDestroy(PCTTexture* pTexture);
+CTCALL	CTColor		CTTextureGet(PCTTexture texture, UINT32 x, UINT32 y);
+CTCALL	BOOL		CTTextureGetRow(PCTTexture texture, UINT32 y, PCTColor rowOut);
+
 //////////////////////////////////////////////////////////////////////////////
 ///
 ///								MESH
@@ -97,9 +407,12 @@ typedef struct CTPrimitive {
 	CTVect	UV;
 } CTPrimitive, *PCTPrimitive;
 
+/// boundRadius is the largest distance of any vertex from the mesh origin
+
 typedef struct CTMesh {
 	UINT32			primCount;
 	PCTPrimitive	primList;
+	FLOAT			boundRadius;
 } CTMesh, *PCTMesh;
 
 CTCALL	PCTMesh		CTMeshCreate(PFLOAT verts, PFLOAT uvs, UINT32 primCount);
@@ -185,51 +498,57 @@ CTCALL	BOOL		CTDraw(
 #define CTS_SAMPLE_METHOD_CUTOFF		1
 #define CTS_SAMPLE_METHOD_REPEAT		2
 #define CTS_SAMPLE_EPSILON				0.001f
-CTCALL __forceinline CTColor CTSSample(PCTFB texture, CTVect UV, UINT32 sampleMethod) {
-
-	CTColor retColor = {
-		.r = 0,
-		.g = 0,
-		.b = 0,
-		.a = 0
-	};
-
-	if (texture == NULL)
-		goto __CTSSampleComplete;
+static __forceinline BOOL __HCTSWrapUV(PCTVect pUV, UINT32 sampleMethod) {
 
 	switch (sampleMethod)
 	{
 
 	case CTS_SAMPLE_METHOD_CUTOFF:
 
-		if (UV.x < 0.0f || UV.x > 1.0f || UV.y < 0.0f || UV.y > 1.0f)
-			goto __CTSSampleComplete;
+		if (pUV->x < 0.0f || pUV->x > 1.0f || pUV->y < 0.0f || pUV->y > 1.0f)
+			return FALSE;
 
 	case CTS_SAMPLE_METHOD_CLAMP_TO_EDGE:
 
-		UV.x = min(1.0f, max(UV.x, 0.0f));
-		UV.y = min(1.0f, max(UV.y, 0.0f));
+		pUV->x = min(1.0f, max(pUV->x, 0.0f));
+		pUV->y = min(1.0f, max(pUV->y, 0.0f));
 		
-		break;
+		return TRUE;
 
 	case CTS_SAMPLE_METHOD_REPEAT:
 
-		UV.x = fmodf(UV.x, 1.0f);
-		UV.y = fmodf(UV.y, 1.0f);
+		pUV->x = fmodf(pUV->x, 1.0f);
+		pUV->y = fmodf(pUV->y, 1.0f);
 
-		if (UV.x < 0.0f)
-			UV.x += 1.0f;
+		if (pUV->x < 0.0f)
+			pUV->x += 1.0f;
 
-		if (UV.y < 0.0f)
-			UV.y += 1.0f;
+		if (pUV->y < 0.0f)
+			pUV->y += 1.0f;
 
-		break;
+		return TRUE;
 
 	default:
 
-		goto __CTSSampleComplete;
+		return FALSE;
 
 	}
+}
+
+CTCALL __forceinline CTColor CTSSample(PCTFB texture, CTVect UV, UINT32 sampleMethod) {
+
+	CTColor retColor = {
+		.r = 0,
+		.g = 0,
+		.b = 0,
+		.a = 0
+	};
+
+	if (texture == NULL)
+		goto __CTSSampleComplete;
+
+	if (__HCTSWrapUV(&UV, sampleMethod) == FALSE)
+		goto __CTSSampleComplete;
 
 	UINT32 samplex = (UINT32)(UV.x * ((FLOAT)texture->width  - 1 - CTS_SAMPLE_EPSILON));
 	UINT32 sampley = (UINT32)(UV.y * ((FLOAT)texture->height - 1 - CTS_SAMPLE_EPSILON));
@@ -249,4 +568,28 @@ __CTSSampleComplete:
 	return retColor;
 }
 
+CTCALL __forceinline CTColor CTSSampleTexture(PCTTexture texture, CTVect UV, UINT32 sampleMethod) {
+
+	CTColor retColor = {
+		.r = 0,
+		.g = 0,
+		.b = 0,
+		.a = 0
+	};
+
+	if (texture == NULL)
+		return retColor;
+
+	if (__HCTSWrapUV(&UV, sampleMethod) == FALSE)
+		return retColor;
+
+	UINT32 samplex = (UINT32)(UV.x * ((FLOAT)texture->width  - 1 - CTS_SAMPLE_EPSILON));
+	UINT32 sampley = (UINT32)(UV.y * ((FLOAT)texture->height - 1 - CTS_SAMPLE_EPSILON));
+
+	if (texture->format == CT_TEXTURE_FORMAT_BGRA)
+		return ((PCTColor)texture->data)[samplex + ((texture->height - sampley - 1) * texture->width)];
+
+	return CTTextureGet(texture, samplex, sampley);
+}
+
 #endif
@@ -0,0 +1,422 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_gfx_blit.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_gfx.h"
+
+#include <intrin.h>
+#include <immintrin.h>
+
+typedef struct __CTBlitTap {
+	UINT32	index0;
+	UINT32	index1;
+	UINT32	weight;
+} __CTBlitTap, *P__CTBlitTap;
+
+static __forceinline PCTColor __HCTBlitMemRow(PCTFB fb, INT32 memRow) {
+	return fb->color + ((SIZE_T)memRow * fb->width);
+}
+
+static void __HCTBlitRowCopy(PCTColor dst, PCTColor src, UINT32 count) {
+
+	UINT32 index = 0;
+
+	for (; index + 16 <= count; index += 16) {
+		__m128i v0 = _mm_loadu_si128((__m128i*)(src + index + 0));
+		__m128i v1 = _mm_loadu_si128((__m128i*)(src + index + 4));
+		__m128i v2 = _mm_loadu_si128((__m128i*)(src + index + 8));
+		__m128i v3 = _mm_loadu_si128((__m128i*)(src + index + 12));
+		_mm_storeu_si128((__m128i*)(dst + index + 0),  v0);
+		_mm_storeu_si128((__m128i*)(dst + index + 4),  v1);
+		_mm_storeu_si128((__m128i*)(dst + index + 8),  v2);
+		_mm_storeu_si128((__m128i*)(dst + index + 12), v3);
+	}
+
+	for (; index + 4 <= count; index += 4) {
+		_mm_storeu_si128(
+			(__m128i*)(dst + index),
+			_mm_loadu_si128((__m128i*)(src + index))
+		);
+	}
+
+	for (; index < count; index++) {
+		dst[index] = src[index];
+	}
+}
+
+static void __HCTBlitRowBlend(PCTColor dst, PCTColor src, UINT32 count) {
+
+	/// SUMMARY:
+	/// same result as CTColorBlend, 4 pixels at a time
+	/// blended = (top * a + bottom * (256 - a)) >> 8, which is
+	/// bottom + ((top - bottom) * a) >> 8 without leaving 16 bits
+	/// opaque top pixels are copied, fully transparent ones are skipped
+
+	const __m128i zero		= _mm_setzero_si128();
+	const __m128i alphaMask	= _mm_set1_epi32(0xFF000000);
+	const __m128i c256		= _mm_set1_epi16(256);
+
+	UINT32 index = 0;
+
+	for (; index + 4 <= count; index += 4) {
+
+		__m128i top		= _mm_loadu_si128((__m128i*)(src + index));
+		__m128i bottom	= _mm_loadu_si128((__m128i*)(dst + index));
+
+		__m128i topAlpha	= _mm_and_si128(top, alphaMask);
+		__m128i opaque		= _mm_cmpeq_epi32(topAlpha, alphaMask);
+		__m128i clear		= _mm_cmpeq_epi32(topAlpha, zero);
+
+		if (_mm_movemask_epi8(clear) == 0xFFFF)
+			continue;
+
+		if (_mm_movemask_epi8(opaque) == 0xFFFF) {
+			_mm_storeu_si128((__m128i*)(dst + index), top);
+			continue;
+		}
+
+		__m128i alpha32		= _mm_srli_epi32(top, 24);
+		alpha32				= _mm_or_si128(alpha32, _mm_slli_epi32(alpha32, 16));
+		__m128i alphaLo		= _mm_unpacklo_epi32(alpha32, alpha32);
+		__m128i alphaHi		= _mm_unpackhi_epi32(alpha32, alpha32);
+		__m128i invAlphaLo	= _mm_sub_epi16(c256, alphaLo);
+		__m128i invAlphaHi	= _mm_sub_epi16(c256, alphaHi);
+
+		__m128i blendLo = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(top, zero), alphaLo),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(bottom, zero), invAlphaLo)
+		);
+		__m128i blendHi = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(top, zero), alphaHi),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(bottom, zero), invAlphaHi)
+		);
+
+		__m128i blended = _mm_packus_epi16(
+			_mm_srli_epi16(blendLo, 8),
+			_mm_srli_epi16(blendHi, 8)
+		);
+		blended = _mm_or_si128(blended, alphaMask);
+
+		blended = _mm_or_si128(_mm_and_si128(opaque, top),   _mm_andnot_si128(opaque, blended));
+		blended = _mm_or_si128(_mm_and_si128(clear, bottom), _mm_andnot_si128(clear, blended));
+
+		_mm_storeu_si128((__m128i*)(dst + index), blended);
+	}
+
+	for (; index < count; index++) {
+		dst[index] = CTColorBlend(dst[index], src[index]);
+	}
+}
+
+static void __HCTBlitRowExpand(PCTColor dst, PCTColor src, UINT32 srcCount, UINT32 factor) {
+
+	/// SUMMARY:
+	/// writes every src pixel factor times in a row
+	/// factor 2 is done by interleaving 4 pixels with themselves,
+	/// anything else splats each pixel across as many stores as needed
+
+	UINT32 index = 0;
+
+	if (factor == 2) {
+
+		for (; index + 4 <= srcCount; index += 4) {
+			__m128i pixels = _mm_loadu_si128((__m128i*)(src + index));
+			_mm_storeu_si128((__m128i*)(dst + (index * 2) + 0), _mm_unpacklo_epi32(pixels, pixels));
+			_mm_storeu_si128((__m128i*)(dst + (index * 2) + 4), _mm_unpackhi_epi32(pixels, pixels));
+		}
+
+		for (; index < srcCount; index++) {
+			dst[(index * 2) + 0] = src[index];
+			dst[(index * 2) + 1] = src[index];
+		}
+
+		return;
+	}
+
+	for (; index < srcCount; index++) {
+
+		__m128i		splat	= _mm_set1_epi32(*(PINT32)(src + index));
+		PCTColor	out		= dst + ((SIZE_T)index * factor);
+
+		UINT32 repeat = 0;
+		for (; repeat + 4 <= factor; repeat += 4) {
+			_mm_storeu_si128((__m128i*)(out + repeat), splat);
+		}
+		for (; repeat < factor; repeat++) {
+			out[repeat] = src[index];
+		}
+	}
+}
+
+static __forceinline CTColor __HCTBlitSampleBilinear(
+	PCTColor	row0,
+	PCTColor	row1,
+	P__CTBlitTap tapX,
+	UINT32		weightY
+) {
+
+	/// SUMMARY:
+	/// load left/right texel pairs of both rows as 8 16-bit lanes
+	/// lerp rows vertically, then lerp left half with right half
+
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i top = _mm_unpacklo_epi32(
+		_mm_cvtsi32_si128(*(PINT32)(row0 + tapX->index0)),
+		_mm_cvtsi32_si128(*(PINT32)(row0 + tapX->index1))
+	);
+	__m128i bottom = _mm_unpacklo_epi32(
+		_mm_cvtsi32_si128(*(PINT32)(row1 + tapX->index0)),
+		_mm_cvtsi32_si128(*(PINT32)(row1 + tapX->index1))
+	);
+	top		= _mm_unpacklo_epi8(top, zero);
+	bottom	= _mm_unpacklo_epi8(bottom, zero);
+
+	__m128i vertical = _mm_srli_epi16(
+		_mm_add_epi16(
+			_mm_mullo_epi16(top,	_mm_set1_epi16((SHORT)(256 - weightY))),
+			_mm_mullo_epi16(bottom,	_mm_set1_epi16((SHORT)weightY))
+		),
+		8
+	);
+
+	const SHORT wx		= (SHORT)tapX->weight;
+	const SHORT wxInv	= (SHORT)(256 - tapX->weight);
+	__m128i horizontal	= _mm_mullo_epi16(
+		vertical,
+		_mm_set_epi16(wx, wx, wx, wx, wxInv, wxInv, wxInv, wxInv)
+	);
+	horizontal = _mm_add_epi16(horizontal, _mm_srli_si128(horizontal, 8));
+	horizontal = _mm_srli_epi16(horizontal, 8);
+	horizontal = _mm_packus_epi16(horizontal, horizontal);
+
+	INT32 packed = _mm_cvtsi128_si32(horizontal);
+	return *(PCTColor)&packed;
+}
+
+static __forceinline __CTBlitTap __HCTBlitBilinearTap(UINT32 dstIndex, UINT32 dstSize, UINT32 srcSize) {
+
+	// sample at pixel centers, in 24.8 fixed point
+	INT64 coord = (((INT64)(2 * dstIndex + 1) * srcSize) << 8) / (2 * (INT64)dstSize) - 128;
+	coord = max(0, coord);
+
+	__CTBlitTap tap;
+	tap.index0	= min((UINT32)(coord >> 8), srcSize - 1);
+	tap.index1	= min(tap.index0 + 1, srcSize - 1);
+	tap.weight	= (UINT32)(coord & 0xFF);
+	return tap;
+}
+
+CTCALL	BOOL	CTFrameBufferBlit(
+	PCTFB	dst,
+	PCTRect	dstRect,
+	PCTFB	src,
+	PCTRect	srcRect,
+	UINT32	filter,
+	UINT32	blend
+) {
+
+	if (dst == NULL) {
+		CTErrorSetBadObject("CTFrameBufferBlit failed: dst was NULL");
+		return FALSE;
+	}
+	if (src == NULL) {
+		CTErrorSetBadObject("CTFrameBufferBlit failed: src was NULL");
+		return FALSE;
+	}
+	if (dst == src) {
+		CTErrorSetParamValue("CTFrameBufferBlit failed: dst and src were the same framebuffer");
+		return FALSE;
+	}
+	if (dst->format != CT_COLOR_FORMAT_BGRA8888 || src->format != CT_COLOR_FORMAT_BGRA8888) {
+		CTErrorSetParamValue("CTFrameBufferBlit failed: dst and src must be BGRA8888");
+		return FALSE;
+	}
+	if (filter != CT_BLIT_FILTER_NEAREST && filter != CT_BLIT_FILTER_BILINEAR) {
+		CTErrorSetParamValue("CTFrameBufferBlit failed: invalid filter");
+		return FALSE;
+	}
+	if (blend != CT_BLIT_BLEND_NONE && blend != CT_BLIT_BLEND_ALPHA) {
+		CTErrorSetParamValue("CTFrameBufferBlit failed: invalid blend");
+		return FALSE;
+	}
+
+	CTRect dRect = (dstRect == NULL) ? CTRectCreate(0, 0, dst->width, dst->height) : *dstRect;
+	CTRect sRect = (srcRect == NULL) ? CTRectCreate(0, 0, src->width, src->height) : *srcRect;
+
+	if (dRect.width == 0 || dRect.height == 0 || sRect.width == 0 || sRect.height == 0) {
+		CTErrorSetParamValue("CTFrameBufferBlit failed: rect was empty");
+		return FALSE;
+	}
+	if (sRect.x < 0 || sRect.y < 0 ||
+		sRect.x + sRect.width  > src->width ||
+		sRect.y + sRect.height > src->height) {
+		CTErrorSetParamValue("CTFrameBufferBlit failed: srcRect was out of bounds");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// clip dst rect against dst (src rect mapping stays unclipped)
+	/// convert rects to memory rows (framebuffer y points up, memory rows go down)
+	/// LOCK BOTH FRAMEBUFFERS (in address order)
+	/// if (same size)
+	///		copy or blend rows directly
+	/// else if (nearest, no blend, unclipped integer upscale)
+	///		expand each src row once, copy it to the remaining dst rows
+	/// else
+	///		precompute column taps
+	///		loop (dst rows)
+	///			sample src into row buffer (nearest or bilinear)
+	///			copy or blend row buffer into dst
+	/// UNLOCK BOTH FRAMEBUFFERS
+
+	const INT32 clipLeft	= max(dRect.x, 0);
+	const INT32 clipRight	= min(dRect.x + (INT32)dRect.width,  (INT32)dst->width);
+	const INT32 clipBottom	= max(dRect.y, 0);
+	const INT32 clipTop		= min(dRect.y + (INT32)dRect.height, (INT32)dst->height);
+
+	if (clipLeft >= clipRight || clipBottom >= clipTop)
+		return TRUE;
+
+	const UINT32 drawWidth		= clipRight - clipLeft;
+	const INT32  dstRectMemTop	= (INT32)dst->height - (dRect.y + (INT32)dRect.height);
+	const INT32  srcRectMemTop	= (INT32)src->height - (sRect.y + (INT32)sRect.height);
+	const INT32  dstMemBegin	= (INT32)dst->height - clipTop;
+	const INT32  dstMemEnd		= (INT32)dst->height - clipBottom;
+
+	PCTFB firstLock		= (dst < src) ? dst : src;
+	PCTFB secondLock	= (dst < src) ? src : dst;
+	CTFrameBufferLock(firstLock);
+	CTFrameBufferLock(secondLock);
+
+	BOOL rslt = TRUE;
+
+	if (dRect.width == sRect.width && dRect.height == sRect.height) {
+
+		for (INT32 memRow = dstMemBegin; memRow < dstMemEnd; memRow++) {
+
+			INT32		rectRow	= memRow - dstRectMemTop;
+			PCTColor	dstRow	= __HCTBlitMemRow(dst, memRow) + clipLeft;
+			PCTColor	srcRow	= __HCTBlitMemRow(src, srcRectMemTop + rectRow) +
+				sRect.x + (clipLeft - dRect.x);
+
+			if (blend == CT_BLIT_BLEND_ALPHA)
+				__HCTBlitRowBlend(dstRow, srcRow, drawWidth);
+			else
+				__HCTBlitRowCopy(dstRow, srcRow, drawWidth);
+
+		}
+
+		goto __CTBlitComplete;
+	}
+
+	const UINT32 factorX = dRect.width  / sRect.width;
+	const UINT32 factorY = dRect.height / sRect.height;
+
+	if (filter	== CT_BLIT_FILTER_NEAREST	&&
+		blend	== CT_BLIT_BLEND_NONE		&&
+		factorX >= 1 && factorY >= 1		&&
+		factorX * sRect.width  == dRect.width  &&
+		factorY * sRect.height == dRect.height &&
+		drawWidth == dRect.width &&
+		(UINT32)(dstMemEnd - dstMemBegin) == dRect.height) {
+
+		for (UINT32 srcRectRow = 0; srcRectRow < sRect.height; srcRectRow++) {
+
+			PCTColor srcRow		= __HCTBlitMemRow(src, srcRectMemTop + srcRectRow) + sRect.x;
+			INT32	 memRow		= dstRectMemTop + (srcRectRow * factorY);
+			PCTColor firstRow	= __HCTBlitMemRow(dst, memRow) + dRect.x;
+
+			__HCTBlitRowExpand(firstRow, srcRow, sRect.width, factorX);
+
+			for (UINT32 repeat = 1; repeat < factorY; repeat++) {
+				__HCTBlitRowCopy(
+					__HCTBlitMemRow(dst, memRow + repeat) + dRect.x,
+					firstRow,
+					drawWidth
+				);
+			}
+		}
+
+		goto __CTBlitComplete;
+	}
+
+	P__CTBlitTap	tapsX		= CTGFXAlloc(sizeof(*tapsX) * drawWidth);
+	PCTColor		rowBuffer	= CTGFXAlloc(sizeof(*rowBuffer) * drawWidth);
+
+	if (tapsX == NULL || rowBuffer == NULL) {
+		if (tapsX != NULL)		CTGFXFree(tapsX);
+		if (rowBuffer != NULL)	CTGFXFree(rowBuffer);
+		rslt = FALSE;
+		goto __CTBlitComplete;
+	}
+
+	for (UINT32 column = 0; column < drawWidth; column++) {
+
+		UINT32 rectColumn = (clipLeft - dRect.x) + column;
+
+		if (filter == CT_BLIT_FILTER_BILINEAR) {
+			tapsX[column] = __HCTBlitBilinearTap(rectColumn, dRect.width, sRect.width);
+		} else {
+			tapsX[column].index0 = (UINT32)(((UINT64)(2 * rectColumn + 1) * sRect.width) / (2 * (UINT64)dRect.width));
+			tapsX[column].index1 = tapsX[column].index0;
+			tapsX[column].weight = 0;
+		}
+
+		tapsX[column].index0 += sRect.x;
+		tapsX[column].index1 += sRect.x;
+	}
+
+	for (INT32 memRow = dstMemBegin; memRow < dstMemEnd; memRow++) {
+
+		UINT32 rectRow = memRow - dstRectMemTop;
+
+		if (filter == CT_BLIT_FILTER_BILINEAR) {
+
+			__CTBlitTap tapY	= __HCTBlitBilinearTap(rectRow, dRect.height, sRect.height);
+			PCTColor	row0	= __HCTBlitMemRow(src, srcRectMemTop + tapY.index0);
+			PCTColor	row1	= __HCTBlitMemRow(src, srcRectMemTop + tapY.index1);
+
+			for (UINT32 column = 0; column < drawWidth; column++) {
+				rowBuffer[column] = __HCTBlitSampleBilinear(
+					row0,
+					row1,
+					tapsX + column,
+					tapY.weight
+				);
+			}
+
+		} else {
+
+			UINT32 srcRectRow = (UINT32)(((UINT64)(2 * rectRow + 1) * sRect.height) / (2 * (UINT64)dRect.height));
+			PCTColor srcRow = __HCTBlitMemRow(src, srcRectMemTop + srcRectRow);
+
+			for (UINT32 column = 0; column < drawWidth; column++) {
+				rowBuffer[column] = srcRow[tapsX[column].index0];
+			}
+
+		}
+
+		PCTColor dstRow = __HCTBlitMemRow(dst, memRow) + clipLeft;
+
+		if (blend == CT_BLIT_BLEND_ALPHA)
+			__HCTBlitRowBlend(dstRow, rowBuffer, drawWidth);
+		else
+			__HCTBlitRowCopy(dstRow, rowBuffer, drawWidth);
+
+	}
+
+	CTGFXFree(tapsX);
+	CTGFXFree(rowBuffer);
+
+__CTBlitComplete:
+
+	CTFrameBufferUnlock(secondLock);
+	CTFrameBufferUnlock(firstLock);
+
+	return rslt;
+}
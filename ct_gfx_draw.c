@@ -13,13 +13,25 @@
 #include <stdio.h>
 
 typedef struct __CTDrawInfo {
-	UINT32		drawMethod;
-	PCTFB		frameBuffer;
-	PCTShader	shader;
-	PVOID		shaderInput;
-	FLOAT		depth;
+	UINT32					drawMethod;
+	PCTFB					frameBuffer;
+	PCTFrameBufferPixelOps	pixelOps;
+	PCTShader				shader;
+	PVOID					shaderInput;
+	FLOAT					depth;
 } __CTDrawInfo, *P__CTDrawInfo;
 
+static PVOID __HCTDrawScratchAlloc(PCTArena arena, SIZE_T sizeBytes) {
+	if (arena != NULL)
+		return CTArenaAlloc(arena, sizeBytes);
+	return CTGFXAlloc(sizeBytes);
+}
+
+static void __HCTDrawScratchFree(PCTArena arena, PVOID block) {
+	if (arena == NULL)
+		CTGFXFree(block);
+}
+
 static FLOAT __HCTFloatRcp(FLOAT flt) {
 	_mm_store_ss(&flt, _mm_rcp_ss(_mm_set_ss(flt)));
 	return flt;
@@ -54,9 +66,8 @@ static inline void __HCTProcessAndDrawPixel(
 	///		if (depth test failed again)
 	///			return
 	/// 
-	/// get below color
-	/// generate blended color
-	/// set frameBuffer pixel to blended color
+	/// write depth and blend pixel into frameBuffer through the pixelOps
+	/// fetched for this draw (no format switch per pixel)
 	 
 	if (CTFrameBufferDepthTestEx(drawInfo->frameBuffer, screenCoord, drawInfo->depth, FALSE) == FALSE &&
 		drawInfo->shader->depthTest == TRUE) return;
@@ -73,15 +84,6 @@ static inline void __HCTProcessAndDrawPixel(
 		.color			= { 0, 0, 0, 0 }
 	};
 	
-	CTColor belowColor;
-	CTFrameBufferGetEx(
-		drawInfo->frameBuffer, 
-		screenCoord, 
-		&belowColor, 
-		NULL,
-		FALSE
-	);
-
 	BOOL keepPixel = drawInfo->shader->pixelShader(
 		pixCtx,
 		&pixel,
@@ -101,14 +103,13 @@ static inline void __HCTProcessAndDrawPixel(
 
 	}
 
-	CTColor newColor = CTColorBlend(belowColor, pixel.color);
-	CTFrameBufferSetEx(
-		drawInfo->frameBuffer,
-		pixel.screenCoord,
-		newColor,
-		drawInfo->depth,
-		FALSE
-	);
+	PCTFB	fb		= drawInfo->frameBuffer;
+	UINT32	index	= pixel.screenCoord.x + ((fb->height - pixel.screenCoord.y - 1) * fb->width);
+
+	if (fb->depth != NULL)
+		fb->depth[index] = drawInfo->depth;
+
+	drawInfo->pixelOps->blend(fb, index, pixel.color);
 
 }
 
@@ -626,8 +627,8 @@ CTCALL	BOOL		CTDraw(
 	}
 
 	/// SUMMARY:
-	/// create copy of shader input
-	/// create copy of mesh primitives
+	/// create copy of shader input (from frame arena if thread has one)
+	/// create copy of mesh primitives (from frame arena if thread has one)
 	/// 
 	/// loop(all primitives in copy)
 	///		if (primitive shader != NULL)
@@ -653,14 +654,16 @@ CTCALL	BOOL		CTDraw(
 	/// 
 	/// return TRUE
 
-	PVOID shaderInputCopy = CTGFXAlloc(shader->shaderInputSizeBytes);
+	PCTArena scratchArena = CTArenaFrameGet();
+
+	PVOID shaderInputCopy = __HCTDrawScratchAlloc(scratchArena, shader->shaderInputSizeBytes);
 	__movsb(
 		shaderInputCopy, 
 		shaderInput, 
 		shader->shaderInputSizeBytes
 	);
 
-	PCTPrimitive processedPrimList = CTGFXAlloc(sizeof(CTPrimitive) * mesh->primCount);
+	PCTPrimitive processedPrimList = __HCTDrawScratchAlloc(scratchArena, sizeof(CTPrimitive) * mesh->primCount);
 	__movsb(
 		processedPrimList, 
 		mesh->primList, 
@@ -695,6 +698,7 @@ CTCALL	BOOL		CTDraw(
 		.drawMethod		= drawMethod,
 		.depth			= depth,
 		.frameBuffer	= frameBuffer,
+		.pixelOps		= frameBuffer->pixelOps,
 		.shader			= shader,
 		.shaderInput	= shaderInputCopy
 	};
@@ -780,13 +784,13 @@ CTCALL	BOOL		CTDraw(
 
 DrawFuncSucess:
 
-	CTGFXFree(shaderInputCopy);
-	CTGFXFree(processedPrimList);
+	__HCTDrawScratchFree(scratchArena, shaderInputCopy);
+	__HCTDrawScratchFree(scratchArena, processedPrimList);
 	return TRUE;
 
 DrawFuncFailure:
 
-	CTGFXFree(shaderInputCopy);
-	CTGFXFree(processedPrimList);
+	__HCTDrawScratchFree(scratchArena, shaderInputCopy);
+	__HCTDrawScratchFree(scratchArena, processedPrimList);
 	return FALSE;
 }
@@ -8,21 +8,163 @@
 
 #include "ct_gfx.h"
 #include <intrin.h>
+#include <immintrin.h>
 #include <float.h>
 
+static __forceinline UINT16 __HCTPackRGB565(CTColor col) {
+	return (UINT16)(((col.r >> 3) << 11) | ((col.g >> 2) << 5) | (col.b >> 3));
+}
+
+static __forceinline CTColor __HCTUnpackRGB565(UINT16 packed) {
+	UINT32 r = (packed >> 11) & 0x1F;
+	UINT32 g = (packed >> 5)  & 0x3F;
+	UINT32 b = packed & 0x1F;
+
+	CTColor col = {
+		.r = (BYTE)((r << 3) | (r >> 2)),
+		.g = (BYTE)((g << 2) | (g >> 4)),
+		.b = (BYTE)((b << 3) | (b >> 2)),
+		.a = 255
+	};
+	return col;
+}
+
+static __forceinline UINT32 __HCTPaletteLookupKey(CTColor col) {
+	return ((col.r >> 3) << 10) | ((col.g >> 3) << 5) | (col.b >> 3);
+}
+
+static __forceinline BYTE __HCTPaletteIndex(PCTFrameBuffer fb, CTColor col) {
+	return fb->paletteLookup[__HCTPaletteLookupKey(col)];
+}
+
+static void __HCTFrameBufferSetBGRA8888(PCTFrameBuffer fb, UINT32 index, CTColor col) {
+	fb->color[index] = col;
+}
+
+static void __HCTFrameBufferSetRGB565(PCTFrameBuffer fb, UINT32 index, CTColor col) {
+	((PUINT16)fb->packed)[index] = __HCTPackRGB565(col);
+}
+
+static void __HCTFrameBufferSetIndexed8(PCTFrameBuffer fb, UINT32 index, CTColor col) {
+	((PBYTE)fb->packed)[index] = __HCTPaletteIndex(fb, col);
+}
+
+static void __HCTFrameBufferBlendBGRA8888(PCTFrameBuffer fb, UINT32 index, CTColor col) {
+	fb->color[index] = CTColorBlend(fb->color[index], col);
+}
+
+static void __HCTFrameBufferBlendRGB565(PCTFrameBuffer fb, UINT32 index, CTColor col) {
+	PUINT16 packed = (PUINT16)fb->packed + index;
+	if (col.a != 255)
+		col = CTColorBlend(__HCTUnpackRGB565(*packed), col);
+	*packed = __HCTPackRGB565(col);
+}
+
+static void __HCTFrameBufferBlendIndexed8(PCTFrameBuffer fb, UINT32 index, CTColor col) {
+	PBYTE packed = (PBYTE)fb->packed + index;
+	if (col.a != 255)
+		col = CTColorBlend(fb->palette[*packed], col);
+	*packed = __HCTPaletteIndex(fb, col);
+}
+
+static CTColor __HCTFrameBufferGetBGRA8888(PCTFrameBuffer fb, UINT32 index) {
+	return fb->color[index];
+}
+
+static CTColor __HCTFrameBufferGetRGB565(PCTFrameBuffer fb, UINT32 index) {
+	return __HCTUnpackRGB565(((PUINT16)fb->packed)[index]);
+}
+
+static CTColor __HCTFrameBufferGetIndexed8(PCTFrameBuffer fb, UINT32 index) {
+	return fb->palette[((PBYTE)fb->packed)[index]];
+}
+
+/// indexed by color format
+
+static CTFrameBufferPixelOps __ctFrameBufferPixelOps[] = {
+	{ __HCTFrameBufferSetBGRA8888,	__HCTFrameBufferBlendBGRA8888,	__HCTFrameBufferGetBGRA8888	},
+	{ __HCTFrameBufferSetRGB565,	__HCTFrameBufferBlendRGB565,	__HCTFrameBufferGetRGB565	},
+	{ __HCTFrameBufferSetIndexed8,	__HCTFrameBufferBlendIndexed8,	__HCTFrameBufferGetIndexed8	},
+};
+
+static void __HCTFrameBufferDefaultPalette(PCTFrameBuffer fb) {
+
+	/// SUMMARY:
+	/// palette index bits are RRRGGGBB
+	/// lookup key bits are 0RRRRRGGGGGBBBBB, so the index is just the
+	/// top bits of each key channel
+
+	for (UINT32 index = 0; index < CT_COLOR_PALETTE_SIZE; index++) {
+		UINT32 r = (index >> 5) & 0x07;
+		UINT32 g = (index >> 2) & 0x07;
+		UINT32 b = index & 0x03;
+		fb->palette[index].r = (BYTE)((r * 255) / 7);
+		fb->palette[index].g = (BYTE)((g * 255) / 7);
+		fb->palette[index].b = (BYTE)((b * 255) / 3);
+		fb->palette[index].a = 255;
+	}
+
+	for (UINT32 key = 0; key < CT_COLOR_PALETTE_LOOKUP_SIZE; key++) {
+		UINT32 r = (key >> 10) & 0x1F;
+		UINT32 g = (key >> 5)  & 0x1F;
+		UINT32 b = key & 0x1F;
+		fb->paletteLookup[key] = (BYTE)(((r >> 2) << 5) | ((g >> 2) << 2) | (b >> 3));
+	}
+}
+
 CTCALL	PCTFB	CTFrameBufferCreate(UINT32 width, UINT32 height) {
+	return CTFrameBufferCreateEx(width, height, CT_COLOR_FORMAT_BGRA8888, 0);
+}
+
+static PVOID __HCTFrameBufferAllocPlane(SIZE_T sizeBytes, UINT32 flags) {
+	if ((flags & CT_FRAMEBUFFER_FLAG_LARGE_PAGES) == 0)
+		return CTGFXAllocEx(sizeBytes, CT_MEMORY_TAG_FRAMEBUFFER);
+	return CTGFXAllocBulk(sizeBytes, CT_MEMORY_TAG_FRAMEBUFFER, CT_GFX_ALLOC_FLAG_LARGE_PAGES);
+}
+
+CTCALL	PCTFB	CTFrameBufferCreateEx(UINT32 width, UINT32 height, UINT32 format, UINT32 flags) {
 	if (width == 0 || height == 0) {
 		CTErrorSetParamValue("CTFrameBufferCreate failed: width/height was invalid");
 		return NULL;
 	}
+	if (format > CT_COLOR_FORMAT_INDEXED8) {
+		CTErrorSetParamValue("CTFrameBufferCreate failed: invalid format");
+		return NULL;
+	}
+
+	PCTFrameBuffer rfb = CTGFXAllocEx(sizeof(*rfb), CT_MEMORY_TAG_FRAMEBUFFER);
 
-	PCTFrameBuffer rfb = CTGFXAlloc(sizeof(*rfb));
+	rfb->width		= width;
+	rfb->height		= height;
+	rfb->format		= format;
+	rfb->pixelOps	= __ctFrameBufferPixelOps + format;
+	rfb->lock		= CTLockCreate();
 
-	rfb->width	= width;
-	rfb->height	= height;
-	rfb->color	= CTGFXAlloc(sizeof(*rfb->color) * width * height);
-	rfb->depth	= CTGFXAlloc(sizeof(*rfb->depth) * width * height);
-	rfb->lock	= CTLockCreate();
+	if ((flags & CT_FRAMEBUFFER_FLAG_NO_DEPTH) == 0)
+		rfb->depth	= __HCTFrameBufferAllocPlane(sizeof(*rfb->depth) * width * height, flags);
+
+	switch (format)
+	{
+
+	case CT_COLOR_FORMAT_BGRA8888:
+		rfb->color		= __HCTFrameBufferAllocPlane(sizeof(*rfb->color) * width * height, flags);
+		rfb->backing	= CTGFXAllocBacking(rfb->color);
+		break;
+
+	case CT_COLOR_FORMAT_RGB565:
+		rfb->packed		= __HCTFrameBufferAllocPlane(sizeof(UINT16) * width * height, flags);
+		rfb->backing	= CTGFXAllocBacking(rfb->packed);
+		break;
+
+	case CT_COLOR_FORMAT_INDEXED8:
+		rfb->packed			= __HCTFrameBufferAllocPlane(sizeof(BYTE) * width * height, flags);
+		rfb->backing		= CTGFXAllocBacking(rfb->packed);
+		rfb->palette		= CTGFXAllocEx(sizeof(CTColor) * CT_COLOR_PALETTE_SIZE, CT_MEMORY_TAG_FRAMEBUFFER);
+		rfb->paletteLookup	= CTGFXAllocEx(CT_COLOR_PALETTE_LOOKUP_SIZE, CT_MEMORY_TAG_FRAMEBUFFER);
+		__HCTFrameBufferDefaultPalette(rfb);
+		break;
+
+	}
 
 	CTFrameBufferClear(rfb, TRUE, TRUE);
 
@@ -43,8 +185,16 @@ CTCALL	BOOL	CTFrameBufferDestroy(PCTFrameBuffer* pfb) {
 	}
 
 	CTLockEnter(fb->lock);
-	CTGFXFree(fb->color);
-	CTGFXFree(fb->depth);
+	if (fb->color != NULL)
+		CTGFXFree(fb->color);
+	if (fb->packed != NULL)
+		CTGFXFree(fb->packed);
+	if (fb->palette != NULL)
+		CTGFXFree(fb->palette);
+	if (fb->paletteLookup != NULL)
+		CTGFXFree(fb->paletteLookup);
+	if (fb->depth != NULL)
+		CTGFXFree(fb->depth);
 	CTLockDestroy(&fb->lock);
 	CTGFXFree(fb);
 
@@ -52,6 +202,64 @@ CTCALL	BOOL	CTFrameBufferDestroy(PCTFrameBuffer* pfb) {
 	return TRUE;
 }
 
+CTCALL	BOOL	CTFrameBufferSetPalette(PCTFrameBuffer fb, PCTColor palette, UINT32 paletteCount) {
+	if (fb == NULL) {
+		CTErrorSetBadObject("CTFrameBufferSetPalette failed: fb was NULL");
+		return FALSE;
+	}
+	if (fb->format != CT_COLOR_FORMAT_INDEXED8) {
+		CTErrorSetFunction("CTFrameBufferSetPalette failed: fb was not indexed");
+		return FALSE;
+	}
+	if (palette == NULL) {
+		CTErrorSetBadObject("CTFrameBufferSetPalette failed: palette was NULL");
+		return FALSE;
+	}
+	if (paletteCount == 0 || paletteCount > CT_COLOR_PALETTE_SIZE) {
+		CTErrorSetParamValue("CTFrameBufferSetPalette failed: paletteCount was invalid");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// LOCK FRAMEBUFFER
+	/// copy palette (unused entries become black)
+	/// loop (all lookup keys)
+	///		store index of nearest palette entry to key color
+	/// UNLOCK FRAMEBUFFER
+
+	CTLockEnter(fb->lock);
+
+	__stosd((PDWORD)fb->palette, 0, CT_COLOR_PALETTE_SIZE);
+	memcpy(fb->palette, palette, sizeof(CTColor) * paletteCount);
+
+	for (UINT32 key = 0; key < CT_COLOR_PALETTE_LOOKUP_SIZE; key++) {
+
+		INT32 r = ((key >> 10) & 0x1F) << 3;
+		INT32 g = ((key >> 5)  & 0x1F) << 3;
+		INT32 b = (key & 0x1F) << 3;
+
+		INT32	bestDistance	= MAXINT32;
+		BYTE	bestIndex		= 0;
+
+		for (UINT32 index = 0; index < paletteCount; index++) {
+			INT32 dr = r - palette[index].r;
+			INT32 dg = g - palette[index].g;
+			INT32 db = b - palette[index].b;
+			INT32 distance = dr * dr + dg * dg + db * db;
+			if (distance < bestDistance) {
+				bestDistance	= distance;
+				bestIndex		= (BYTE)index;
+			}
+		}
+
+		fb->paletteLookup[key] = bestIndex;
+	}
+
+	CTLockLeave(fb->lock);
+
+	return TRUE;
+}
+
 CTCALL	BOOL	CTFrameBufferSetEx(PCTFrameBuffer fb, CTPoint pt, CTColor col, FLOAT depth, BOOL safe) {
 	
 	if (safe == TRUE) {
@@ -69,9 +277,44 @@ CTCALL	BOOL	CTFrameBufferSetEx(PCTFrameBuffer fb, CTPoint pt, CTColor col, FLOAT
 	}
 		
 
-	UINT32 index		= pt.x + ((fb->height - pt.y - 1) * fb->width);
-	fb->color[index]	= col;
-	fb->depth[index]	= depth;
+	UINT32 index = pt.x + ((fb->height - pt.y - 1) * fb->width);
+	if (fb->depth != NULL)
+		fb->depth[index] = depth;
+
+	((PCTFrameBufferPixelOps)fb->pixelOps)->set(fb, index, col);
+
+	if (safe == TRUE)
+		CTLockLeave(fb->lock);
+
+	return TRUE;
+}
+
+CTCALL	BOOL	CTFrameBufferBlendEx(PCTFrameBuffer fb, CTPoint pt, CTColor col, FLOAT depth, BOOL safe) {
+
+	if (safe == TRUE) {
+
+		if (fb == NULL) {
+			CTErrorSetBadObject("CTFrameBufferBlend failed: fb was NULL");
+			return FALSE;
+		}
+		if (pt.x > fb->width - 1 || pt.y > fb->height - 1) {
+			CTErrorSetParamValue("CTFrameBufferBlend failed: pt was out of bounds");
+			return FALSE;
+		}
+
+		CTLockEnter(fb->lock);
+	}
+
+	/// SUMMARY:
+	/// opaque colors are written without reading the pixel below
+	/// otherwise the pixel below is unpacked, blended and packed again
+	/// (format picked through pixelOps, depth written if there is a plane)
+
+	UINT32 index = pt.x + ((fb->height - pt.y - 1) * fb->width);
+	if (fb->depth != NULL)
+		fb->depth[index] = depth;
+
+	((PCTFrameBufferPixelOps)fb->pixelOps)->blend(fb, index, col);
 
 	if (safe == TRUE)
 		CTLockLeave(fb->lock);
@@ -97,7 +340,7 @@ CTCALL	BOOL	CTFrameBufferDepthTestEx(PCTFrameBuffer fb, CTPoint pt, FLOAT depth,
 	
 
 	UINT32 index = pt.x + ((fb->height - pt.y - 1) * fb->width);
-	BOOL depthTest = fb->depth[index] > depth;
+	BOOL depthTest = (fb->depth == NULL) || (fb->depth[index] > depth);
 
 	if (safe == TRUE)
 		CTLockLeave(fb->lock);
@@ -125,9 +368,9 @@ CTCALL	BOOL	CTFrameBufferGetEx(PCTFrameBuffer fb, CTPoint pt, PCTColor pCol, PFL
 	UINT32 index = pt.x + ((fb->height - pt.y - 1) * fb->width);
 
 	if (pCol != NULL)
-		*pCol = fb->color[index];
+		*pCol = ((PCTFrameBufferPixelOps)fb->pixelOps)->get(fb, index);
 	if (pDepth != NULL)
-		*pDepth = fb->depth[index];
+		*pDepth = (fb->depth != NULL) ? fb->depth[index] : FLT_MAX;
 
 	if (safe == TRUE)
 		CTLockLeave(fb->lock);
@@ -163,12 +406,139 @@ CTCALL	BOOL	CTFrameBufferClear(PCTFrameBuffer fb, BOOL color, BOOL depth) {
 
 	const FLOAT		CLEAR_DEPTH_VALUE	= FLT_MAX;
 	const UINT32	FB_ELEMENT_COUNT	= fb->width * fb->height;
-	if (color == TRUE)
-		__stosd(fb->color, 0, FB_ELEMENT_COUNT);
-	if (depth == TRUE)
+	if (color == TRUE) {
+		switch (fb->format)
+		{
+
+		case CT_COLOR_FORMAT_BGRA8888:
+			__stosd(fb->color, 0, FB_ELEMENT_COUNT);
+			break;
+
+		case CT_COLOR_FORMAT_RGB565:
+			__stosw(fb->packed, 0, FB_ELEMENT_COUNT);
+			break;
+
+		case CT_COLOR_FORMAT_INDEXED8:
+			__stosb(fb->packed, __HCTPaletteIndex(fb, (CTColor){ 0 }), FB_ELEMENT_COUNT);
+			break;
+
+		}
+	}
+	if (depth == TRUE && fb->depth != NULL)
 		__stosd(fb->depth, *(PDWORD)&CLEAR_DEPTH_VALUE, FB_ELEMENT_COUNT);
 
 	CTLockLeave(fb->lock);
 
 	return TRUE;
 }
+
+CTCALL	BOOL	CTFrameBufferConvertRow(PCTFrameBuffer fb, UINT32 memRow, PCTColor rowOut) {
+	if (fb == NULL) {
+		CTErrorSetBadObject("CTFrameBufferConvertRow failed: fb was NULL");
+		return FALSE;
+	}
+	if (rowOut == NULL) {
+		CTErrorSetBadObject("CTFrameBufferConvertRow failed: rowOut was NULL");
+		return FALSE;
+	}
+	if (memRow >= fb->height) {
+		CTErrorSetParamValue("CTFrameBufferConvertRow failed: memRow was out of bounds");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// (caller holds the framebuffer lock)
+	/// BGRA8888:	copy row
+	/// RGB565:		widen 8 pixels at a time with SSE2
+	/// INDEXED8:	palette lookup (8 pixels per gather in AVX2 builds)
+
+	UINT32	width		= fb->width;
+	SIZE_T	rowStart	= (SIZE_T)memRow * width;
+	UINT32	column		= 0;
+
+	switch (fb->format)
+	{
+
+	case CT_COLOR_FORMAT_BGRA8888:
+
+		memcpy(rowOut, fb->color + rowStart, sizeof(CTColor) * width);
+		break;
+
+	case CT_COLOR_FORMAT_RGB565: {
+
+		PUINT16			packed		= (PUINT16)fb->packed + rowStart;
+		const __m128i	mask5		= _mm_set1_epi16(0x1F);
+		const __m128i	mask6		= _mm_set1_epi16(0x3F);
+		const __m128i	alphaHigh	= _mm_set1_epi16((SHORT)0xFF00);
+
+		for (; column + 8 <= width; column += 8) {
+
+			__m128i pixels = _mm_loadu_si128((__m128i*)(packed + column));
+
+			__m128i r = _mm_srli_epi16(pixels, 11);
+			__m128i g = _mm_and_si128(_mm_srli_epi16(pixels, 5), mask6);
+			__m128i b = _mm_and_si128(pixels, mask5);
+
+			r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+			g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+			b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+			__m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+			__m128i ra = _mm_or_si128(r, alphaHigh);
+
+			_mm_storeu_si128((__m128i*)(rowOut + column),     _mm_unpacklo_epi16(bg, ra));
+			_mm_storeu_si128((__m128i*)(rowOut + column + 4), _mm_unpackhi_epi16(bg, ra));
+		}
+
+		for (; column < width; column++)
+			rowOut[column] = __HCTUnpackRGB565(packed[column]);
+
+		break;
+	}
+
+	case CT_COLOR_FORMAT_INDEXED8: {
+
+		PBYTE packed = (PBYTE)fb->packed + rowStart;
+
+#ifdef __AVX2__
+		for (; column + 8 <= width; column += 8) {
+			__m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(packed + column)));
+			_mm256_storeu_si256(
+				(__m256i*)(rowOut + column),
+				_mm256_i32gather_epi32((const int*)fb->palette, lanes, 4)
+			);
+		}
+#endif
+
+		for (; column < width; column++)
+			rowOut[column] = fb->palette[packed[column]];
+
+		break;
+	}
+
+	}
+
+	return TRUE;
+}
+
+CTCALL	BOOL	CTFrameBufferConvert(PCTFrameBuffer fb, PCTColor colorOut) {
+	if (fb == NULL) {
+		CTErrorSetBadObject("CTFrameBufferConvert failed: fb was NULL");
+		return FALSE;
+	}
+	if (colorOut == NULL) {
+		CTErrorSetBadObject("CTFrameBufferConvert failed: colorOut was NULL");
+		return FALSE;
+	}
+
+	if (fb->format == CT_COLOR_FORMAT_BGRA8888) {
+		memcpy(colorOut, fb->color, sizeof(CTColor) * fb->width * fb->height);
+		return TRUE;
+	}
+
+	for (UINT32 memRow = 0; memRow < fb->height; memRow++) {
+		CTFrameBufferConvertRow(fb, memRow, colorOut + ((SIZE_T)memRow * fb->width));
+	}
+
+	return TRUE;
+}
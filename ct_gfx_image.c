@@ -0,0 +1,445 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_gfx_image.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_gfx.h"
+
+#include <stdio.h>
+#include <intrin.h>
+#include <immintrin.h>
+
+#define CT_IMAGE_CACHE_MAGIC		0x57525443	// "CTRW"
+#define CT_IMAGE_CACHE_VERSION		1
+#define CT_IMAGE_BMP_MAGIC			0x4D42		// "BM"
+#define CT_IMAGE_QOI_MAGIC			0x66696F71	// "qoif"
+#define CT_IMAGE_QOI_HEADER_SIZE	14
+#define CT_IMAGE_QOI_PADDING_SIZE	8
+
+typedef struct __CTImageCacheHeader {
+	UINT32	magic;
+	UINT32	version;
+	UINT32	width;
+	UINT32	height;
+	UINT64	sourceSize;
+	UINT64	sourceWriteTime;
+} __CTImageCacheHeader, *P__CTImageCacheHeader;
+
+static void __HCTImageConvertRow32(PCTColor dst, PBYTE src, UINT32 count, BOOL swapRB, BOOL forceOpaque) {
+
+	/// SUMMARY:
+	/// 4 pixels at a time
+	/// if (swapRB) swap bytes 0 and 2 of every pixel (RGBA -> BGRA)
+	/// if (forceOpaque) set every alpha to 255
+
+	const __m128i alphaMask = _mm_set1_epi32(forceOpaque ? 0xFF000000 : 0);
+	const __m128i gaMask	= _mm_set1_epi32(0xFF00FF00);
+	const __m128i rbMask	= _mm_set1_epi32(0x00FF00FF);
+
+	UINT32 index = 0;
+
+	for (; index + 4 <= count; index += 4) {
+
+		__m128i pixels = _mm_loadu_si128((__m128i*)(src + (index * 4)));
+
+		if (swapRB) {
+			__m128i ga = _mm_and_si128(pixels, gaMask);
+			__m128i rb = _mm_and_si128(pixels, rbMask);
+			rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+			pixels = _mm_or_si128(ga, rb);
+		}
+
+		_mm_storeu_si128((__m128i*)(dst + index), _mm_or_si128(pixels, alphaMask));
+	}
+
+	for (; index < count; index++) {
+		PBYTE texel = src + (index * 4);
+		dst[index].b = swapRB ? texel[2] : texel[0];
+		dst[index].g = texel[1];
+		dst[index].r = swapRB ? texel[0] : texel[2];
+		dst[index].a = forceOpaque ? 0xFF : texel[3];
+	}
+}
+
+static void __HCTImageConvertRow24(PCTColor dst, PBYTE src, UINT32 count) {
+
+	UINT32 index = 0;
+
+#ifdef __AVX2__
+	/// spread 4 packed BGR texels into 4 BGRA slots, 16 bytes are loaded
+	/// so stop while at least 16 bytes of the row are left
+	const __m128i spread	= _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alphaMask	= _mm_set1_epi32(0xFF000000);
+
+	for (; index + 6 <= count; index += 4) {
+		__m128i texels = _mm_loadu_si128((__m128i*)(src + (index * 3)));
+		texels = _mm_or_si128(_mm_shuffle_epi8(texels, spread), alphaMask);
+		_mm_storeu_si128((__m128i*)(dst + index), texels);
+	}
+#endif
+
+	for (; index < count; index++) {
+		PBYTE texel = src + (index * 3);
+		dst[index].b = texel[0];
+		dst[index].g = texel[1];
+		dst[index].r = texel[2];
+		dst[index].a = 0xFF;
+	}
+}
+
+static PCTFB __HCTImageDecodeBMP(PBYTE data, SIZE_T dataSize) {
+
+	/// SUMMARY:
+	/// validate file header and info header
+	/// work out which channel layout the pixels are in
+	/// create framebuffer
+	/// loop (file rows)
+	///		convert row into matching framebuffer row
+	///		(positive height means file rows are stored bottom first)
+
+	if (dataSize < sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER)) {
+		CTErrorSetParamValue("CTFrameBufferLoad failed: BMP was truncated");
+		return NULL;
+	}
+
+	PBITMAPFILEHEADER fileHeader = (PBITMAPFILEHEADER)data;
+	PBITMAPINFOHEADER infoHeader = (PBITMAPINFOHEADER)(data + sizeof(BITMAPFILEHEADER));
+
+	if (infoHeader->biSize < sizeof(BITMAPINFOHEADER)) {
+		CTErrorSetParamValue("CTFrameBufferLoad failed: BMP header is unsupported");
+		return NULL;
+	}
+	if (infoHeader->biSize > dataSize - sizeof(BITMAPFILEHEADER)) {
+		CTErrorSetParamValue("CTFrameBufferLoad failed: BMP was truncated");
+		return NULL;
+	}
+
+	BOOL	topDown		= infoHeader->biHeight < 0;
+	UINT32	width		= (UINT32)infoHeader->biWidth;
+	UINT32	height		= (UINT32)(topDown ? -infoHeader->biHeight : infoHeader->biHeight);
+	UINT32	bitCount	= infoHeader->biBitCount;
+
+	if (infoHeader->biWidth <= 0 || height == 0 ||
+		width > CT_IMAGE_DIMENSION_MAX || height > CT_IMAGE_DIMENSION_MAX) {
+		CTErrorSetParamValue("CTFrameBufferLoad failed: BMP dimensions were invalid");
+		return NULL;
+	}
+
+	BOOL swapRB			= FALSE;
+	BOOL forceOpaque	= TRUE;
+
+	if (bitCount == 24 && infoHeader->biCompression == BI_RGB) {
+
+		// plain BGR
+
+	} else if (bitCount == 32 && infoHeader->biCompression == BI_RGB) {
+
+		// BGRX, alpha byte is unused
+
+	} else if (bitCount == 32 && infoHeader->biCompression == BI_BITFIELDS) {
+
+		/// masks follow the 40 byte info header, alpha mask only
+		/// exists in the larger (V3+) headers
+		/// bounds check every mask that will be read before reading any
+
+		PUINT32 masks		= (PUINT32)((PBYTE)infoHeader + sizeof(BITMAPINFOHEADER));
+		BOOL	hasAlpha	= infoHeader->biSize >= sizeof(BITMAPINFOHEADER) + 16;
+
+		if ((PBYTE)(masks + (hasAlpha ? 4 : 3)) > data + dataSize) {
+			CTErrorSetParamValue("CTFrameBufferLoad failed: BMP was truncated");
+			return NULL;
+		}
+
+		UINT32 alphaMask = hasAlpha ? masks[3] : 0;
+
+		if (masks[0] == 0x00FF0000 && masks[1] == 0x0000FF00 && masks[2] == 0x000000FF) {
+			swapRB = FALSE;
+		} else if (masks[0] == 0x000000FF && masks[1] == 0x0000FF00 && masks[2] == 0x00FF0000) {
+			swapRB = TRUE;
+		} else {
+			CTErrorSetParamValue("CTFrameBufferLoad failed: BMP channel masks are unsupported");
+			return NULL;
+		}
+
+		forceOpaque = (alphaMask != 0xFF000000);
+
+	} else {
+		CTErrorSetParamValue("CTFrameBufferLoad failed: BMP pixel format is unsupported");
+		return NULL;
+	}
+
+	SIZE_T rowStride = (((SIZE_T)bitCount * width + 31) / 32) * 4;
+	if (fileHeader->bfOffBits > dataSize ||
+		rowStride * height > dataSize - fileHeader->bfOffBits) {
+		CTErrorSetParamValue("CTFrameBufferLoad failed: BMP was truncated");
+		return NULL;
+	}
+
+	PCTFB	fb		= CTFrameBufferCreate(width, height);
+	PBYTE	pixels	= data + fileHeader->bfOffBits;
+
+	for (UINT32 fileRow = 0; fileRow < height; fileRow++) {
+
+		UINT32		memRow	= topDown ? fileRow : (height - fileRow - 1);
+		PCTColor	dstRow	= fb->color + ((SIZE_T)memRow * width);
+		PBYTE		srcRow	= pixels + (rowStride * fileRow);
+
+		if (bitCount == 24)
+			__HCTImageConvertRow24(dstRow, srcRow, width);
+		else
+			__HCTImageConvertRow32(dstRow, srcRow, width, swapRB, forceOpaque);
+
+	}
+
+	return fb;
+}
+
+static __forceinline UINT32 __HCTImageReadBE32(PBYTE data) {
+	return ((UINT32)data[0] << 24) | ((UINT32)data[1] << 16) |
+		   ((UINT32)data[2] << 8)  |  (UINT32)data[3];
+}
+
+static PCTFB __HCTImageDecodeQOI(PBYTE data, SIZE_T dataSize) {
+
+	/// SUMMARY:
+	/// validate header
+	/// create framebuffer
+	/// loop (all pixels, top row first)
+	///		if (in a run) repeat previous pixel
+	///		else decode next op (RGB, RGBA, INDEX, DIFF, LUMA, RUN)
+	///		remember pixel in hash index
+	///		write pixel straight out as BGRA
+
+	if (dataSize < CT_IMAGE_QOI_HEADER_SIZE + CT_IMAGE_QOI_PADDING_SIZE) {
+		CTErrorSetParamValue("CTFrameBufferLoad failed: QOI was truncated");
+		return NULL;
+	}
+
+	UINT32 width	= __HCTImageReadBE32(data + 4);
+	UINT32 height	= __HCTImageReadBE32(data + 8);
+
+	if (width == 0 || height == 0 ||
+		width > CT_IMAGE_DIMENSION_MAX || height > CT_IMAGE_DIMENSION_MAX) {
+		CTErrorSetParamValue("CTFrameBufferLoad failed: QOI dimensions were invalid");
+		return NULL;
+	}
+
+	PCTFB		fb			= CTFrameBufferCreate(width, height);
+	PCTColor	out			= fb->color;
+	SIZE_T		pixelCount	= (SIZE_T)width * height;
+	SIZE_T		readPos		= CT_IMAGE_QOI_HEADER_SIZE;
+	SIZE_T		readEnd		= dataSize - CT_IMAGE_QOI_PADDING_SIZE;
+	CTColor		seen[64]	= { 0 };
+	CTColor		pixel		= { 0 };
+	UINT32		run			= 0;
+
+	pixel.a = 0xFF;
+
+	for (SIZE_T pixelIndex = 0; pixelIndex < pixelCount; pixelIndex++) {
+
+		if (run > 0) {
+			run--;
+		} else if (readPos < readEnd) {
+
+			BYTE op = data[readPos++];
+
+			if (op == 0xFE) {
+				pixel.r = data[readPos + 0];
+				pixel.g = data[readPos + 1];
+				pixel.b = data[readPos + 2];
+				readPos += 3;
+			} else if (op == 0xFF) {
+				pixel.r = data[readPos + 0];
+				pixel.g = data[readPos + 1];
+				pixel.b = data[readPos + 2];
+				pixel.a = data[readPos + 3];
+				readPos += 4;
+			} else if ((op & 0xC0) == 0x00) {
+				pixel = seen[op];
+			} else if ((op & 0xC0) == 0x40) {
+				pixel.r += ((op >> 4) & 0x03) - 2;
+				pixel.g += ((op >> 2) & 0x03) - 2;
+				pixel.b += ( op		  & 0x03) - 2;
+			} else if ((op & 0xC0) == 0x80) {
+				BYTE	second	= data[readPos++];
+				INT		diffG	= (op & 0x3F) - 32;
+				pixel.r += diffG - 8 + ((second >> 4) & 0x0F);
+				pixel.g += diffG;
+				pixel.b += diffG - 8 + (second & 0x0F);
+			} else {
+				run = op & 0x3F;
+			}
+
+			seen[(pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) & 0x3F] = pixel;
+		}
+
+		out[pixelIndex] = pixel;
+	}
+
+	return fb;
+}
+
+static BOOL __HCTImageSourceStamp(PCTFile file, PUINT64 pSize, PUINT64 pWriteTime) {
+
+	FILETIME writeTime = { 0 };
+	if (GetFileTime(file->hFile, NULL, NULL, &writeTime) == FALSE)
+		return FALSE;
+
+	*pSize		= CTFileSize(file);
+	*pWriteTime	= ((UINT64)writeTime.dwHighDateTime << 32) | writeTime.dwLowDateTime;
+	return TRUE;
+}
+
+static PCTFB __HCTImageCacheRead(PCHAR cachePath, UINT64 sourceSize, UINT64 sourceWriteTime) {
+
+	/// SUMMARY:
+	/// if (no cache file) return nothing
+	/// map cache file
+	/// if (header matches source and sizes add up)
+	///		copy pixels straight into new framebuffer
+
+	if (CTFileExists(cachePath) == FALSE)
+		return NULL;
+
+	PCTFile cacheFile = CTFileOpen(cachePath);
+	if (cacheFile == NULL)
+		return NULL;
+
+	PCTFB	fb		= NULL;
+	PBYTE	view	= CTFileMap(cacheFile);
+
+	if (view != NULL && cacheFile->mapSize >= sizeof(__CTImageCacheHeader)) {
+
+		P__CTImageCacheHeader header = (P__CTImageCacheHeader)view;
+
+		if (header->magic			== CT_IMAGE_CACHE_MAGIC		&&
+			header->version			== CT_IMAGE_CACHE_VERSION	&&
+			header->sourceSize		== sourceSize				&&
+			header->sourceWriteTime	== sourceWriteTime			&&
+			header->width  != 0 && header->width  <= CT_IMAGE_DIMENSION_MAX &&
+			header->height != 0 && header->height <= CT_IMAGE_DIMENSION_MAX &&
+			cacheFile->mapSize == sizeof(*header) + sizeof(CTColor) * header->width * header->height) {
+
+			fb = CTFrameBufferCreate(header->width, header->height);
+			memcpy(
+				fb->color,
+				view + sizeof(*header),
+				sizeof(CTColor) * header->width * header->height
+			);
+
+		}
+	}
+
+	CTFileClose(&cacheFile);
+	return fb;
+}
+
+static void __HCTImageCacheWrite(PCHAR cachePath, PCTFB fb, UINT64 sourceSize, UINT64 sourceWriteTime) {
+
+	/// SUMMARY:
+	/// write pixels first and header last, so a partially written
+	/// cache never has a valid header
+
+	PCTFile cacheFile = CTFileCreate(cachePath);
+	if (cacheFile == NULL)
+		return;
+
+	__CTImageCacheHeader header = { 0 };
+	header.magic			= CT_IMAGE_CACHE_MAGIC;
+	header.version			= CT_IMAGE_CACHE_VERSION;
+	header.width			= fb->width;
+	header.height			= fb->height;
+	header.sourceSize		= sourceSize;
+	header.sourceWriteTime	= sourceWriteTime;
+
+	BOOL written = CTFileWrite(
+		cacheFile,
+		fb->color,
+		sizeof(header),
+		sizeof(CTColor) * fb->width * fb->height
+	);
+
+	if (written)
+		CTFileWrite(cacheFile, &header, 0, sizeof(header));
+
+	CTFileClose(&cacheFile);
+}
+
+CTCALL	PCTFB	CTFrameBufferLoad(PCHAR path) {
+	return CTFrameBufferLoadEx(path, FALSE);
+}
+
+CTCALL	PCTFB	CTFrameBufferLoadEx(PCHAR path, BOOL useCache) {
+	if (path == NULL) {
+		CTErrorSetBadObject("CTFrameBufferLoadEx failed: path was NULL");
+		return NULL;
+	}
+
+	/// SUMMARY:
+	/// open source file
+	/// if (using cache and cache is valid for source)
+	///		return cached framebuffer
+	/// map source file
+	/// decode by magic number
+	/// if (using cache) write cache for next time
+
+	CHAR cachePath[CT_FILENAME_MAX_LENGTH] = { 0 };
+	if (useCache) {
+		if (strlen(path) + sizeof(CT_IMAGE_CACHE_EXTENSION) > sizeof(cachePath)) {
+			CTErrorSetParamValue("CTFrameBufferLoadEx failed: path was too long");
+			return NULL;
+		}
+		sprintf_s(
+			cachePath,
+			sizeof(cachePath),
+			"%s%s",
+			path,
+			CT_IMAGE_CACHE_EXTENSION
+		);
+	}
+
+	PCTFile sourceFile = CTFileOpen(path);
+	if (sourceFile == NULL)
+		return NULL;
+
+	UINT64 sourceSize		= 0;
+	UINT64 sourceWriteTime	= 0;
+	if (useCache) {
+		useCache = __HCTImageSourceStamp(sourceFile, &sourceSize, &sourceWriteTime);
+	}
+
+	if (useCache) {
+		PCTFB cached = __HCTImageCacheRead(cachePath, sourceSize, sourceWriteTime);
+		if (cached != NULL) {
+			CTFileClose(&sourceFile);
+			return cached;
+		}
+	}
+
+	PBYTE data = CTFileMap(sourceFile);
+	if (data == NULL) {
+		CTFileClose(&sourceFile);
+		return NULL;
+	}
+
+	PCTFB	fb			= NULL;
+	SIZE_T	dataSize	= sourceFile->mapSize;
+
+	if (dataSize >= 4 && *(PUINT32)data == CT_IMAGE_QOI_MAGIC) {
+		fb = __HCTImageDecodeQOI(data, dataSize);
+	} else if (dataSize >= 2 && *(PUINT16)data == CT_IMAGE_BMP_MAGIC) {
+		fb = __HCTImageDecodeBMP(data, dataSize);
+	} else {
+		CTErrorSetParamValue("CTFrameBufferLoadEx failed: unknown image format");
+	}
+
+	CTFileClose(&sourceFile);
+
+	if (fb != NULL && useCache)
+		__HCTImageCacheWrite(cachePath, fb, sourceSize, sourceWriteTime);
+
+	return fb;
+}
@@ -11,23 +11,161 @@
 
 #include <intrin.h>
 
+typedef struct __CTGFXAllocHeader {
+	UINT64	sizeBytes;
+	UINT32	tag;
+	UINT32	backing;
+} __CTGFXAllocHeader, *P__CTGFXAllocHeader;
+
+static BOOL __HCTGFXEnableLargePages(void) {
+
+	/// SUMMARY:
+	/// if (system has no large page support)
+	///		return FALSE
+	/// enable SeLockMemoryPrivilege on process token
+	/// (AdjustTokenPrivileges succeeds even when nothing was assigned,
+	///  so last error has to be checked as well)
+
+	SIZE_T largePageSize = GetLargePageMinimum();
+	if (largePageSize == 0)
+		return FALSE;
+
+	HANDLE token = NULL;
+	if (OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token) == FALSE)
+		return FALSE;
+
+	TOKEN_PRIVILEGES privileges = { 0 };
+	privileges.PrivilegeCount				= 1;
+	privileges.Privileges[0].Attributes		= SE_PRIVILEGE_ENABLED;
+
+	BOOL enabled = LookupPrivilegeValueA(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+		AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL) &&
+		GetLastError() == ERROR_SUCCESS;
+
+	CloseHandle(token);
+
+	if (enabled == TRUE)
+		__ctdata.gfx.largePageSize = largePageSize;
+
+	return enabled;
+}
+
+static P__CTGFXAllocHeader __HCTGFXAllocPages(SIZE_T sizeBytes, BOOL largePages) {
+
+	/// SUMMARY:
+	/// if (large pages were requested and are available)
+	///		try to allocate size rounded up to large pages
+	/// if (no large page allocation)
+	///		allocate normal pages
+	/// (pages come zeroed from the system)
+
+	P__CTGFXAllocHeader header = NULL;
+
+	if (largePages == TRUE && CTGFXLargePagesAvailable() == TRUE) {
+		SIZE_T largeSize = (sizeBytes + __ctdata.gfx.largePageSize - 1) & ~(__ctdata.gfx.largePageSize - 1);
+		header = VirtualAlloc(NULL, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (header != NULL) {
+			header->backing = CT_GFX_BACKING_LARGE_PAGES;
+			return header;
+		}
+	}
+
+	header = VirtualAlloc(NULL, sizeBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if (header != NULL)
+		header->backing = CT_GFX_BACKING_PAGES;
+
+	return header;
+}
+
 CTCALL	PVOID		CTGFXAlloc(SIZE_T size) {
-	PVOID ptr = HeapAlloc(__ctdata.gfx.gfxHeap, 0, size);
+	return CTGFXAllocEx(size, CT_MEMORY_TAG_GFX);
+}
+
+CTCALL	PVOID		CTGFXAllocEx(SIZE_T size, UINT32 tag) {
+	if (tag >= CT_MEMORY_TAG_COUNT) {
+		CTErrorSetParamValue("CTGFXAlloc failed: invalid tag");
+		return NULL;
+	}
+
+	P__CTGFXAllocHeader header = HeapAlloc(__ctdata.gfx.gfxHeap, 0, sizeof(*header) + size);
 
-	if (ptr == NULL) {
+	if (header == NULL) {
 		CTErrorSetFunction("CTGFXAlloc failed: heap error");
 		return NULL;
 	}
+
+	header->sizeBytes	= size;
+	header->tag			= tag;
+	header->backing		= CT_GFX_BACKING_HEAP;
+	__CTMemoryAccount(tag, size, 1);
+
+	PVOID ptr = header + 1;
 	__stosb(ptr, 0, size);
 	return ptr;
 }
 
+CTCALL	PVOID		CTGFXAllocBulk(SIZE_T size, UINT32 tag, UINT32 flags) {
+	if (tag >= CT_MEMORY_TAG_COUNT) {
+		CTErrorSetParamValue("CTGFXAllocBulk failed: invalid tag");
+		return NULL;
+	}
+
+	P__CTGFXAllocHeader header = __HCTGFXAllocPages(
+		sizeof(*header) + size,
+		(flags & CT_GFX_ALLOC_FLAG_LARGE_PAGES) != 0
+	);
+
+	if (header == NULL) {
+		CTErrorSetFunction("CTGFXAllocBulk failed: could not allocate pages");
+		return NULL;
+	}
+
+	header->sizeBytes	= size;
+	header->tag			= tag;
+	__CTMemoryAccount(tag, size, 1);
+
+	return header + 1;
+}
+
+CTCALL	UINT32		CTGFXAllocBacking(PVOID block) {
+	if (block == NULL) {
+		CTErrorSetParamValue("CTGFXAllocBacking failed: block was NULL");
+		return CT_GFX_BACKING_HEAP;
+	}
+
+	return ((P__CTGFXAllocHeader)block - 1)->backing;
+}
+
+CTCALL	BOOL		CTGFXLargePagesAvailable(void) {
+
+	/// SUMMARY:
+	/// if (availability is not known yet)
+	///		try to enable large pages and remember the outcome
+	///		(racing threads may both try, which is harmless)
+
+	LONG state = __ctdata.gfx.largePageState;
+
+	if (state == CT_GFX_LARGE_PAGES_UNKNOWN) {
+		state = __HCTGFXEnableLargePages() ? CT_GFX_LARGE_PAGES_AVAILABLE : CT_GFX_LARGE_PAGES_UNAVAILABLE;
+		InterlockedExchange(&__ctdata.gfx.largePageState, state);
+	}
+
+	return state == CT_GFX_LARGE_PAGES_AVAILABLE;
+}
+
 CTCALL	BOOL		CTGFXFree(PVOID block) {
 	if (block == NULL) {
 		CTErrorSetParamValue("CTGFXFree failed: block was NULL");
 		return FALSE;
 	}
 
-	HeapFree(__ctdata.gfx.gfxHeap, 0, block);
+	P__CTGFXAllocHeader header = (P__CTGFXAllocHeader)block - 1;
+	__CTMemoryAccount(header->tag, -(SSIZE_T)header->sizeBytes, -1);
+
+	if (header->backing == CT_GFX_BACKING_HEAP)
+		HeapFree(__ctdata.gfx.gfxHeap, 0, header);
+	else
+		VirtualFree(header, 0, MEM_RELEASE);
+
 	return TRUE;
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include "ct_gfx.h"
 #include <intrin.h>
+#include <math.h>
 
 CTCALL	PCTMesh		CTMeshCreate(PFLOAT verts, PFLOAT uvs, UINT32 primCount) {
 	if (verts == NULL) {
@@ -23,9 +24,10 @@ CTCALL	PCTMesh		CTMeshCreate(PFLOAT verts, PFLOAT uvs, UINT32 primCount) {
 		return NULL;
 	}
 
-	PCTMesh rMesh		= CTGFXAlloc(sizeof(*rMesh));
-	rMesh->primList		= CTGFXAlloc(sizeof(*rMesh->primList) * primCount);
+	PCTMesh rMesh		= CTGFXAllocEx(sizeof(*rMesh), CT_MEMORY_TAG_MESH);
+	rMesh->primList		= CTGFXAllocEx(sizeof(*rMesh->primList) * primCount, CT_MEMORY_TAG_MESH);
 	rMesh->primCount	= primCount;
+	rMesh->boundRadius	= 0.0f;
 
 	for (UINT32 primID = 0; primID < primCount; primID++) {
 
@@ -37,6 +39,12 @@ CTCALL	PCTMesh		CTMeshCreate(PFLOAT verts, PFLOAT uvs, UINT32 primCount) {
 		rMesh->primList[primID].UV.x		= uvs[compXIndex];
 		rMesh->primList[primID].UV.y		= uvs[compYIndex];
 
+		FLOAT vertDist = sqrtf(
+			(verts[compXIndex] * verts[compXIndex]) +
+			(verts[compYIndex] * verts[compYIndex])
+		);
+		rMesh->boundRadius = max(rMesh->boundRadius, vertDist);
+
 	}
 
 	return rMesh;
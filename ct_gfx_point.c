@@ -47,3 +47,13 @@ CTCALL	CTVect			CTPointToVector(CTPoint p) {
 	};
 	return rv;
 }
+
+CTCALL	CTRect			CTRectCreate(INT32 x, INT32 y, UINT32 width, UINT32 height) {
+	CTRect rr = {
+		.x		= x,
+		.y		= y,
+		.width	= width,
+		.height	= height
+	};
+	return rr;
+}
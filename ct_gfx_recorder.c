@@ -0,0 +1,467 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_gfx_recorder.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_gfx.h"
+
+#include <stdio.h>
+#include <intrin.h>
+#include <immintrin.h>
+
+/// full range BT.601 weights in BGRA lane order, 8 bit fixed point
+#define CT_RECORDER_WEIGHTS_Y		29,  150,  77, 0
+#define CT_RECORDER_WEIGHTS_U		128, -85, -43, 0
+#define CT_RECORDER_WEIGHTS_V		-21, -107, 128, 0
+#define CT_RECORDER_Y4M_FRAME_TAG	"FRAME\n"
+
+static __forceinline __m128i __HCTRecorderDot(__m128i lanesLo, __m128i lanesHi, __m128i weights) {
+
+	/// SUMMARY:
+	/// lanesLo/lanesHi hold 2 BGRA pixels each as 16-bit lanes
+	/// madd gives (b*wb + g*wg), (r*wr + a*wa) per pixel, sum the pairs
+	/// to get one 32-bit dot product per pixel (4 total)
+
+	__m128 lo = _mm_castsi128_ps(_mm_madd_epi16(lanesLo, weights));
+	__m128 hi = _mm_castsi128_ps(_mm_madd_epi16(lanesHi, weights));
+
+	return _mm_add_epi32(
+		_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))),
+		_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)))
+	);
+}
+
+static void __HCTRecorderConvertLuma(PBYTE dstY, PCTColor src, UINT32 count) {
+
+	const __m128i zero		= _mm_setzero_si128();
+	const __m128i weights	= _mm_setr_epi16(CT_RECORDER_WEIGHTS_Y, CT_RECORDER_WEIGHTS_Y);
+	const __m128i round		= _mm_set1_epi32(128);
+
+	UINT32 index = 0;
+
+	for (; index + 8 <= count; index += 8) {
+
+		__m128i pixels0 = _mm_loadu_si128((__m128i*)(src + index));
+		__m128i pixels1 = _mm_loadu_si128((__m128i*)(src + index + 4));
+
+		__m128i luma0 = __HCTRecorderDot(
+			_mm_unpacklo_epi8(pixels0, zero),
+			_mm_unpackhi_epi8(pixels0, zero),
+			weights
+		);
+		__m128i luma1 = __HCTRecorderDot(
+			_mm_unpacklo_epi8(pixels1, zero),
+			_mm_unpackhi_epi8(pixels1, zero),
+			weights
+		);
+
+		luma0 = _mm_srai_epi32(_mm_add_epi32(luma0, round), 8);
+		luma1 = _mm_srai_epi32(_mm_add_epi32(luma1, round), 8);
+
+		__m128i luma16 = _mm_packs_epi32(luma0, luma1);
+		_mm_storel_epi64((__m128i*)(dstY + index), _mm_packus_epi16(luma16, luma16));
+	}
+
+	for (; index < count; index++) {
+		CTColor pixel = src[index];
+		dstY[index] = (BYTE)((29 * pixel.b + 150 * pixel.g + 77 * pixel.r + 128) >> 8);
+	}
+}
+
+static void __HCTRecorderConvertChroma(PBYTE dstU, PBYTE dstV, PCTColor row0, PCTColor row1, UINT32 count) {
+
+	/// SUMMARY:
+	/// sum each 2x2 block of pixels (16-bit lanes, at most 4 * 255)
+	/// dot block sums with U and V weights, divide by 4 * 256 with rounding
+	/// 8 pixels (4 chroma samples) per iteration
+
+	const __m128i zero		= _mm_setzero_si128();
+	const __m128i weightsU	= _mm_setr_epi16(CT_RECORDER_WEIGHTS_U, CT_RECORDER_WEIGHTS_U);
+	const __m128i weightsV	= _mm_setr_epi16(CT_RECORDER_WEIGHTS_V, CT_RECORDER_WEIGHTS_V);
+	const __m128i bias		= _mm_set1_epi32((128 << 10) + 512);
+
+	UINT32 index = 0;
+
+	for (; index + 8 <= count; index += 8) {
+
+		__m128i top0	= _mm_loadu_si128((__m128i*)(row0 + index));
+		__m128i top1	= _mm_loadu_si128((__m128i*)(row0 + index + 4));
+		__m128i bottom0	= _mm_loadu_si128((__m128i*)(row1 + index));
+		__m128i bottom1	= _mm_loadu_si128((__m128i*)(row1 + index + 4));
+
+		__m128i column0 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+		__m128i column1 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+		__m128i column2 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+		__m128i column3 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+		__m128i blocks01 = _mm_add_epi16(
+			_mm_unpacklo_epi64(column0, column1),
+			_mm_unpackhi_epi64(column0, column1)
+		);
+		__m128i blocks23 = _mm_add_epi16(
+			_mm_unpacklo_epi64(column2, column3),
+			_mm_unpackhi_epi64(column2, column3)
+		);
+
+		__m128i chromaU = _mm_srai_epi32(_mm_add_epi32(__HCTRecorderDot(blocks01, blocks23, weightsU), bias), 10);
+		__m128i chromaV = _mm_srai_epi32(_mm_add_epi32(__HCTRecorderDot(blocks01, blocks23, weightsV), bias), 10);
+
+		chromaU = _mm_packs_epi32(chromaU, chromaU);
+		chromaV = _mm_packs_epi32(chromaV, chromaV);
+
+		*(PUINT32)(dstU + (index / 2)) = _mm_cvtsi128_si32(_mm_packus_epi16(chromaU, chromaU));
+		*(PUINT32)(dstV + (index / 2)) = _mm_cvtsi128_si32(_mm_packus_epi16(chromaV, chromaV));
+	}
+
+	for (; index + 2 <= count; index += 2) {
+
+		INT32 sumB = row0[index].b + row0[index + 1].b + row1[index].b + row1[index + 1].b;
+		INT32 sumG = row0[index].g + row0[index + 1].g + row1[index].g + row1[index + 1].g;
+		INT32 sumR = row0[index].r + row0[index + 1].r + row1[index].r + row1[index + 1].r;
+
+		INT32 chromaU = (128 * sumB - 85 * sumG - 43 * sumR + (128 << 10) + 512) >> 10;
+		INT32 chromaV = (-21 * sumB - 107 * sumG + 128 * sumR + (128 << 10) + 512) >> 10;
+
+		dstU[index / 2] = (BYTE)min(255, chromaU);
+		dstV[index / 2] = (BYTE)min(255, chromaV);
+	}
+}
+
+static SIZE_T __HCTRecorderFrameBytes(PCTRecorder recorder) {
+	SIZE_T lumaBytes	= (SIZE_T)recorder->width * recorder->height;
+	SIZE_T frameBytes	= lumaBytes + (lumaBytes / 2);
+
+	if (recorder->format == CT_RECORDER_FORMAT_Y4M)
+		frameBytes += sizeof(CT_RECORDER_Y4M_FRAME_TAG) - 1;
+
+	return frameBytes;
+}
+
+static void __HCTRecorderFlush(PCTRecorder recorder) {
+	if (recorder->writeBufferUsed == 0)
+		return;
+
+	if (recorder->writeFailed == FALSE) {
+		recorder->writeFailed = !CTFileWrite(
+			recorder->file,
+			recorder->writeBuffer,
+			recorder->fileOffset,
+			recorder->writeBufferUsed
+		);
+	}
+
+	recorder->fileOffset		+= recorder->writeBufferUsed;
+	recorder->writeBufferUsed	= 0;
+}
+
+static void __HCTRecorderWriteFrame(PCTRecorder recorder, PCTColor frame) {
+
+	/// SUMMARY:
+	/// if (frame does not fit in write buffer) flush write buffer
+	/// (Y4M) write frame tag
+	/// convert frame into Y, U and V planes straight in the write buffer
+
+	SIZE_T frameBytes = __HCTRecorderFrameBytes(recorder);
+
+	if (recorder->writeBufferUsed + frameBytes > recorder->writeBufferSize)
+		__HCTRecorderFlush(recorder);
+
+	PBYTE out = recorder->writeBuffer + recorder->writeBufferUsed;
+
+	if (recorder->format == CT_RECORDER_FORMAT_Y4M) {
+		memcpy(out, CT_RECORDER_Y4M_FRAME_TAG, sizeof(CT_RECORDER_Y4M_FRAME_TAG) - 1);
+		out += sizeof(CT_RECORDER_Y4M_FRAME_TAG) - 1;
+	}
+
+	UINT32	width		= recorder->width;
+	UINT32	height		= recorder->height;
+	PBYTE	planeY		= out;
+	PBYTE	planeU		= planeY + ((SIZE_T)width * height);
+	PBYTE	planeV		= planeU + ((SIZE_T)(width / 2) * (height / 2));
+
+	for (UINT32 row = 0; row < height; row += 2) {
+
+		PCTColor row0 = frame + ((SIZE_T)row * width);
+		PCTColor row1 = row0 + width;
+
+		__HCTRecorderConvertLuma(planeY + ((SIZE_T)row * width), row0, width);
+		__HCTRecorderConvertLuma(planeY + ((SIZE_T)(row + 1) * width), row1, width);
+		__HCTRecorderConvertChroma(
+			planeU + ((SIZE_T)(row / 2) * (width / 2)),
+			planeV + ((SIZE_T)(row / 2) * (width / 2)),
+			row0,
+			row1,
+			width
+		);
+	}
+
+	recorder->writeBufferUsed += frameBytes;
+}
+
+static DWORD __stdcall __HCTRecorderThreadProc(PCTRecorder recorder) {
+
+	/// SUMMARY:
+	/// loop (forever)
+	///		wait for wake signal
+	///		remember if kill signal was set
+	///		loop (while slot at write index is filled)
+	///			convert and buffer frame
+	///			free slot, advance write index
+	///		if (kill signal was set)
+	///			flush write buffer, exit
+
+	while (TRUE) {
+
+		WaitForSingleObject(recorder->wakeSignal, INFINITE);
+
+		LONG exiting = InterlockedCompareExchange(&recorder->killSignal, 0, 0);
+
+		while (InterlockedCompareExchange(&recorder->ringState[recorder->writeIndex], 0, 0) ==
+			CT_RECORDER_SLOT_FILLED) {
+
+			__HCTRecorderWriteFrame(recorder, recorder->ring[recorder->writeIndex]);
+
+			InterlockedExchange(&recorder->ringState[recorder->writeIndex], CT_RECORDER_SLOT_FREE);
+			InterlockedIncrement64(&recorder->framesWritten);
+
+			recorder->writeIndex = (recorder->writeIndex + 1) % recorder->ringSize;
+		}
+
+		if (exiting) {
+			__HCTRecorderFlush(recorder);
+			CTAllocThreadCacheFlush();
+			return ERROR_SUCCESS;
+		}
+
+	}
+
+}
+
+static BOOL __HCTRecorderCaptureFrame(PCTRecorder recorder, PCTFB fb) {
+
+	/// SUMMARY:
+	/// (called under capture lock)
+	/// if (frame size differs or slot at capture index is still filled)
+	///		count drop, return
+	/// copy frame into slot
+	/// mark slot filled, advance capture index
+	/// wake writer thread
+
+	if (fb->width != recorder->width || fb->height != recorder->height) {
+		InterlockedIncrement64(&recorder->framesDropped);
+		return FALSE;
+	}
+
+	UINT32 slot = recorder->captureIndex;
+
+	if (InterlockedCompareExchange(&recorder->ringState[slot], 0, 0) != CT_RECORDER_SLOT_FREE) {
+		InterlockedIncrement64(&recorder->framesDropped);
+		return FALSE;
+	}
+
+	CTFrameBufferConvert(fb, recorder->ring[slot]);
+
+	InterlockedExchange(&recorder->ringState[slot], CT_RECORDER_SLOT_FILLED);
+	InterlockedIncrement64(&recorder->framesCaptured);
+	recorder->captureIndex = (slot + 1) % recorder->ringSize;
+
+	SetEvent(recorder->wakeSignal);
+
+	return TRUE;
+}
+
+static void __HCTRecorderConsume(PVOID swapChain, PCTFB frontBuffer, UINT64 frameNumber, PVOID input) {
+
+	// front buffer is owned by the presenter for the length of this call
+	PCTRecorder recorder = input;
+
+	CTLockEnter(recorder->captureLock);
+	__HCTRecorderCaptureFrame(recorder, frontBuffer);
+	CTLockLeave(recorder->captureLock);
+}
+
+CTCALL	PCTRecorder	CTRecorderCreate(
+	PCHAR	path,
+	UINT32	format,
+	UINT32	width,
+	UINT32	height,
+	UINT32	framesPerSecond,
+	UINT32	ringSize
+) {
+	if (path == NULL) {
+		CTErrorSetBadObject("CTRecorderCreate failed: path was NULL");
+		return NULL;
+	}
+	if (format != CT_RECORDER_FORMAT_RAW && format != CT_RECORDER_FORMAT_Y4M) {
+		CTErrorSetParamValue("CTRecorderCreate failed: invalid format");
+		return NULL;
+	}
+	if (width == 0 || height == 0 || (width % 2) != 0 || (height % 2) != 0) {
+		CTErrorSetParamValue("CTRecorderCreate failed: width/height must be even and non-zero");
+		return NULL;
+	}
+	if (framesPerSecond == 0) {
+		CTErrorSetParamValue("CTRecorderCreate failed: framesPerSecond was 0");
+		return NULL;
+	}
+	if (ringSize < CT_RECORDER_RING_MIN || ringSize > CT_RECORDER_RING_MAX) {
+		CTErrorSetParamValue("CTRecorderCreate failed: ringSize was invalid");
+		return NULL;
+	}
+
+	/// SUMMARY:
+	/// create output file
+	/// allocate ring slots and write buffer up front
+	/// (Y4M) put stream header at start of write buffer
+	/// start writer thread
+
+	PCTFile file = CTFileCreate(path);
+	if (file == NULL)
+		return NULL;
+
+	PCTRecorder recorder	= CTGFXAlloc(sizeof(*recorder));
+	recorder->file			= file;
+	recorder->captureLock	= CTLockCreate();
+	recorder->format		= format;
+	recorder->width			= width;
+	recorder->height		= height;
+	recorder->ringSize		= ringSize;
+
+	for (UINT32 slot = 0; slot < ringSize; slot++) {
+		recorder->ring[slot]		= CTGFXAlloc(sizeof(CTColor) * width * height);
+		recorder->ringState[slot]	= CT_RECORDER_SLOT_FREE;
+	}
+
+	recorder->writeBufferSize	= max(CT_RECORDER_WRITE_BUFFER_SIZE, __HCTRecorderFrameBytes(recorder));
+	recorder->writeBuffer		= CTGFXAlloc(recorder->writeBufferSize);
+
+	if (format == CT_RECORDER_FORMAT_Y4M) {
+		recorder->writeBufferUsed = sprintf_s(
+			recorder->writeBuffer,
+			recorder->writeBufferSize,
+			"YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n",
+			width,
+			height,
+			framesPerSecond
+		);
+	}
+
+	recorder->wakeSignal = CreateEventA(
+		NULL,
+		FALSE,
+		FALSE,
+		NULL
+	);
+	recorder->thread = CreateThread(
+		NULL,
+		NULL,
+		__HCTRecorderThreadProc,
+		recorder,
+		NULL,
+		NULL
+	);
+
+	return recorder;
+}
+
+CTCALL	BOOL		CTRecorderDestroy(PCTRecorder* pRecorder) {
+	if (pRecorder == NULL) {
+		CTErrorSetBadObject("CTRecorderDestroy failed: pRecorder was NULL");
+		return FALSE;
+	}
+
+	PCTRecorder recorder = *pRecorder;
+
+	if (recorder == NULL) {
+		CTErrorSetBadObject("CTRecorderDestroy failed: recorder was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// detach from swap chain (no capture can be in flight after this)
+	/// signal writer thread to drain ring, flush and exit
+	/// free everything
+
+	if (recorder->swapChain != NULL)
+		CTRecorderDetach(recorder);
+
+	InterlockedExchange(&recorder->killSignal, TRUE);
+	SetEvent(recorder->wakeSignal);
+	WaitForSingleObject(recorder->thread, INFINITE);
+
+	CloseHandle(recorder->thread);
+	CloseHandle(recorder->wakeSignal);
+	CTFileClose(&recorder->file);
+
+	for (UINT32 slot = 0; slot < recorder->ringSize; slot++) {
+		CTGFXFree(recorder->ring[slot]);
+	}
+
+	CTGFXFree(recorder->writeBuffer);
+	CTLockDestroy(&recorder->captureLock);
+	CTGFXFree(recorder);
+
+	*pRecorder = NULL;
+	return TRUE;
+}
+
+CTCALL	BOOL		CTRecorderAttach(PCTRecorder recorder, PCTSwapChain swapChain) {
+	if (recorder == NULL) {
+		CTErrorSetBadObject("CTRecorderAttach failed: recorder was NULL");
+		return FALSE;
+	}
+	if (swapChain == NULL) {
+		CTErrorSetBadObject("CTRecorderAttach failed: swapChain was NULL");
+		return FALSE;
+	}
+	if (recorder->swapChain != NULL) {
+		CTErrorSetFunction("CTRecorderAttach failed: recorder was already attached");
+		return FALSE;
+	}
+
+	if (CTSwapChainAddConsumer(swapChain, __HCTRecorderConsume, recorder) == FALSE)
+		return FALSE;
+
+	recorder->swapChain = swapChain;
+	return TRUE;
+}
+
+CTCALL	BOOL		CTRecorderDetach(PCTRecorder recorder) {
+	if (recorder == NULL) {
+		CTErrorSetBadObject("CTRecorderDetach failed: recorder was NULL");
+		return FALSE;
+	}
+	if (recorder->swapChain == NULL) {
+		CTErrorSetFunction("CTRecorderDetach failed: recorder was not attached");
+		return FALSE;
+	}
+
+	CTSwapChainRemoveConsumer(recorder->swapChain, __HCTRecorderConsume, recorder);
+	recorder->swapChain = NULL;
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTRecorderCapture(PCTRecorder recorder, PCTFB fb) {
+	if (recorder == NULL) {
+		CTErrorSetBadObject("CTRecorderCapture failed: recorder was NULL");
+		return FALSE;
+	}
+	if (fb == NULL) {
+		CTErrorSetBadObject("CTRecorderCapture failed: fb was NULL");
+		return FALSE;
+	}
+
+	CTLockEnter(recorder->captureLock);
+	CTFrameBufferLock(fb);
+
+	BOOL captured = __HCTRecorderCaptureFrame(recorder, fb);
+
+	CTFrameBufferUnlock(fb);
+	CTLockLeave(recorder->captureLock);
+
+	return captured;
+}
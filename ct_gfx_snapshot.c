@@ -0,0 +1,468 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_gfx_snapshot.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_data.h"
+#include "ct_gfx.h"
+
+typedef struct __CTSnapshotJob {
+	struct __CTSnapshotJob*	next;
+	SIZE_T					capacity;
+	UINT32					width;
+	UINT32					height;
+	UINT32					format;
+	PCTSnapshotFence		fence;
+	PCTFUNCSNAPSHOTDONE		callback;
+	PVOID					input;
+	CHAR					path [CT_FILENAME_MAX_LENGTH];
+	PCTColor				pixels;
+} __CTSnapshotJob, *P__CTSnapshotJob;
+
+typedef struct __CTSnapshotEncoder {
+	PBYTE	buffer;
+	SIZE_T	capacity;
+} __CTSnapshotEncoder, *P__CTSnapshotEncoder;
+
+static P__CTSnapshotJob __HCTSnapshotJobAcquire(SIZE_T pixelCount) {
+
+	/// SUMMARY:
+	/// ENTER LOCK
+	/// take first pooled job which is big enough
+	/// LEAVE LOCK
+	/// if (none found)
+	///		allocate new job with pixels right after it
+
+	P__CTSnapshotJob job = NULL;
+
+	CTLockEnter(__ctdata.gfx.snapshot.lock);
+
+	P__CTSnapshotJob* pLink = (P__CTSnapshotJob*)&__ctdata.gfx.snapshot.stagingPool;
+	while (*pLink != NULL) {
+		if ((*pLink)->capacity >= pixelCount) {
+			job		= *pLink;
+			*pLink	= job->next;
+			__ctdata.gfx.snapshot.stagingPoolCount--;
+			break;
+		}
+		pLink = &(*pLink)->next;
+	}
+
+	CTLockLeave(__ctdata.gfx.snapshot.lock);
+
+	if (job == NULL) {
+		job = CTGFXAlloc(sizeof(*job) + (sizeof(CTColor) * pixelCount));
+		if (job == NULL)
+			return NULL;
+
+		job->capacity	= pixelCount;
+		job->pixels		= (PCTColor)(job + 1);
+	}
+
+	job->next = NULL;
+	return job;
+}
+
+static void __HCTSnapshotJobRelease(P__CTSnapshotJob job) {
+
+	CTLockEnter(__ctdata.gfx.snapshot.lock);
+
+	if (__ctdata.gfx.snapshot.stagingPoolCount < CT_SNAPSHOT_POOL_MAX) {
+		job->next = __ctdata.gfx.snapshot.stagingPool;
+		__ctdata.gfx.snapshot.stagingPool = job;
+		__ctdata.gfx.snapshot.stagingPoolCount++;
+		job = NULL;
+	}
+
+	CTLockLeave(__ctdata.gfx.snapshot.lock);
+
+	if (job != NULL)
+		CTGFXFree(job);
+}
+
+static PBYTE __HCTSnapshotEncoderReserve(P__CTSnapshotEncoder encoder, SIZE_T sizeBytes) {
+	if (encoder->capacity >= sizeBytes)
+		return encoder->buffer;
+
+	if (encoder->buffer != NULL)
+		CTGFXFree(encoder->buffer);
+
+	encoder->buffer		= CTGFXAlloc(sizeBytes);
+	encoder->capacity	= (encoder->buffer == NULL) ? 0 : sizeBytes;
+	return encoder->buffer;
+}
+
+static __forceinline void __HCTSnapshotWriteBE32(PBYTE out, UINT32 value) {
+	out[0] = (BYTE)(value >> 24);
+	out[1] = (BYTE)(value >> 16);
+	out[2] = (BYTE)(value >> 8);
+	out[3] = (BYTE)(value);
+}
+
+static SIZE_T __HCTSnapshotEncodeQOI(P__CTSnapshotJob job, PBYTE out) {
+
+	/// SUMMARY:
+	/// write header
+	/// loop (all pixels, top row first)
+	///		extend run while pixel repeats
+	///		else emit INDEX, DIFF, LUMA, RGB or RGBA (smallest that fits)
+	/// write end marker
+
+	SIZE_T	writePos	= 0;
+	SIZE_T	pixelCount	= (SIZE_T)job->width * job->height;
+	CTColor	seen[64]	= { 0 };
+	CTColor	prev		= { 0 };
+	UINT32	run			= 0;
+
+	prev.a = 0xFF;
+
+	out[writePos++] = 'q';
+	out[writePos++] = 'o';
+	out[writePos++] = 'i';
+	out[writePos++] = 'f';
+	__HCTSnapshotWriteBE32(out + writePos, job->width);
+	__HCTSnapshotWriteBE32(out + writePos + 4, job->height);
+	writePos += 8;
+	out[writePos++] = 4;	// channels
+	out[writePos++] = 0;	// colorspace (sRGB)
+
+	for (SIZE_T pixelIndex = 0; pixelIndex < pixelCount; pixelIndex++) {
+
+		CTColor pixel = job->pixels[pixelIndex];
+
+		if (*(PUINT32)&pixel == *(PUINT32)&prev) {
+			run++;
+			if (run == 62 || pixelIndex == pixelCount - 1) {
+				out[writePos++] = (BYTE)(0xC0 | (run - 1));
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run > 0) {
+			out[writePos++] = (BYTE)(0xC0 | (run - 1));
+			run = 0;
+		}
+
+		UINT32 hash = (pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) & 0x3F;
+
+		if (*(PUINT32)&seen[hash] == *(PUINT32)&pixel) {
+			out[writePos++] = (BYTE)hash;
+			prev = pixel;
+			continue;
+		}
+
+		seen[hash] = pixel;
+
+		if (pixel.a == prev.a) {
+
+			INT8 diffR	= (INT8)(pixel.r - prev.r);
+			INT8 diffG	= (INT8)(pixel.g - prev.g);
+			INT8 diffB	= (INT8)(pixel.b - prev.b);
+			INT8 diffGR	= diffR - diffG;
+			INT8 diffGB	= diffB - diffG;
+
+			if (diffR > -3 && diffR < 2 &&
+				diffG > -3 && diffG < 2 &&
+				diffB > -3 && diffB < 2) {
+				out[writePos++] = (BYTE)(0x40 | ((diffR + 2) << 4) | ((diffG + 2) << 2) | (diffB + 2));
+			} else if (diffGR > -9 && diffGR < 8 &&
+					   diffG > -33 && diffG < 32 &&
+					   diffGB > -9 && diffGB < 8) {
+				out[writePos++] = (BYTE)(0x80 | (diffG + 32));
+				out[writePos++] = (BYTE)(((diffGR + 8) << 4) | (diffGB + 8));
+			} else {
+				out[writePos++] = 0xFE;
+				out[writePos++] = pixel.r;
+				out[writePos++] = pixel.g;
+				out[writePos++] = pixel.b;
+			}
+
+		} else {
+			out[writePos++] = 0xFF;
+			out[writePos++] = pixel.r;
+			out[writePos++] = pixel.g;
+			out[writePos++] = pixel.b;
+			out[writePos++] = pixel.a;
+		}
+
+		prev = pixel;
+	}
+
+	for (UINT32 padIndex = 0; padIndex < 7; padIndex++)
+		out[writePos++] = 0x00;
+	out[writePos++] = 0x01;
+
+	return writePos;
+}
+
+static BOOL __HCTSnapshotWrite(P__CTSnapshotJob job, P__CTSnapshotEncoder encoder) {
+
+	/// SUMMARY:
+	/// create file
+	/// RAW:	write size header, then pixels as they are
+	/// BMP:	write 32bit top-down header, then pixels as they are
+	/// QOI:	encode into reusable encoder buffer, write it in one go
+	/// close file
+
+	PCTFile file = CTFileCreate(job->path);
+	if (file == NULL)
+		return FALSE;
+
+	BOOL	rslt		= FALSE;
+	SIZE_T	pixelBytes	= sizeof(CTColor) * job->width * job->height;
+
+	switch (job->format)
+	{
+
+	case CT_SNAPSHOT_FORMAT_RAW: {
+
+		UINT32 header[2] = { job->width, job->height };
+		rslt = CTFileWrite(file, header, 0, sizeof(header)) &&
+			   CTFileWrite(file, job->pixels, sizeof(header), pixelBytes);
+		break;
+
+	}
+
+	case CT_SNAPSHOT_FORMAT_BMP: {
+
+		struct {
+			BITMAPFILEHEADER fileHeader;
+			BITMAPINFOHEADER infoHeader;
+		} header = { 0 };
+
+		header.fileHeader.bfType		= 0x4D42;
+		header.fileHeader.bfOffBits		= sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+		header.fileHeader.bfSize		= header.fileHeader.bfOffBits + (DWORD)pixelBytes;
+		header.infoHeader.biSize		= sizeof(BITMAPINFOHEADER);
+		header.infoHeader.biWidth		= job->width;
+		header.infoHeader.biHeight		= -(LONG)job->height;
+		header.infoHeader.biPlanes		= 1;
+		header.infoHeader.biBitCount	= 32;
+		header.infoHeader.biCompression	= BI_RGB;
+		header.infoHeader.biSizeImage	= (DWORD)pixelBytes;
+
+		rslt = CTFileWrite(file, &header.fileHeader, 0, sizeof(BITMAPFILEHEADER)) &&
+			   CTFileWrite(file, &header.infoHeader, sizeof(BITMAPFILEHEADER), sizeof(BITMAPINFOHEADER)) &&
+			   CTFileWrite(file, job->pixels, header.fileHeader.bfOffBits, pixelBytes);
+		break;
+
+	}
+
+	case CT_SNAPSHOT_FORMAT_QOI: {
+
+		// worst case every pixel is a 5 byte RGBA op
+		PBYTE out = __HCTSnapshotEncoderReserve(
+			encoder,
+			14 + 8 + ((SIZE_T)job->width * job->height * 5)
+		);
+		if (out == NULL)
+			break;
+
+		SIZE_T encodedBytes = __HCTSnapshotEncodeQOI(job, out);
+		rslt = CTFileWrite(file, out, 0, encodedBytes);
+		break;
+
+	}
+
+	default:
+		break;
+
+	}
+
+	CTFileClose(&file);
+	return rslt;
+}
+
+DWORD __stdcall __CTSnapshotThreadProc(PVOID input) {
+
+	/// SUMMARY:
+	/// loop (forever)
+	///		wait for wake signal (or sleep interval)
+	///		ENTER LOCK
+	///		take whole queue
+	///		LEAVE LOCK
+	///		for (all taken jobs)
+	///			encode and write file
+	///			signal fence, call callback
+	///			return staging buffer to pool
+	///		if (recieved kill signal and queue is empty)
+	///			free pool and encoder, terminate thread
+
+	__CTSnapshotEncoder encoder = { 0 };
+
+	while (TRUE) {
+
+		WaitForSingleObject(
+			__ctdata.gfx.snapshot.wakeSignal,
+			CT_SNAPSHOT_SLEEP_INTERVAL_MSEC
+		);
+
+		CTLockEnter(__ctdata.gfx.snapshot.lock);
+		P__CTSnapshotJob job = __ctdata.gfx.snapshot.queueHead;
+		__ctdata.gfx.snapshot.queueHead = NULL;
+		__ctdata.gfx.snapshot.queueTail = NULL;
+		CTLockLeave(__ctdata.gfx.snapshot.lock);
+
+		while (job != NULL) {
+
+			P__CTSnapshotJob nextJob = job->next;
+
+			BOOL success = __HCTSnapshotWrite(job, &encoder);
+
+			if (job->fence != NULL) {
+				InterlockedExchange(
+					&job->fence->status,
+					success ? CT_SNAPSHOT_STATUS_COMPLETE : CT_SNAPSHOT_STATUS_FAILED
+				);
+			}
+
+			if (job->callback != NULL)
+				job->callback(job->path, success, job->input);
+
+			__HCTSnapshotJobRelease(job);
+			job = nextJob;
+		}
+
+		DWORD killSignalResult = WaitForSingleObject(
+			__ctdata.gfx.snapshot.killSignal,
+			0
+		);
+
+		if (killSignalResult == WAIT_OBJECT_0 &&
+			__ctdata.gfx.snapshot.queueHead == NULL) {
+
+			CTLockEnter(__ctdata.gfx.snapshot.lock);
+			P__CTSnapshotJob pooled = __ctdata.gfx.snapshot.stagingPool;
+			while (pooled != NULL) {
+				P__CTSnapshotJob nextPooled = pooled->next;
+				CTGFXFree(pooled);
+				pooled = nextPooled;
+			}
+			__ctdata.gfx.snapshot.stagingPool		= NULL;
+			__ctdata.gfx.snapshot.stagingPoolCount	= 0;
+			CTLockLeave(__ctdata.gfx.snapshot.lock);
+
+			if (encoder.buffer != NULL)
+				CTGFXFree(encoder.buffer);
+
+			CTAllocThreadCacheFlush();
+			ExitThread(ERROR_SUCCESS);
+		}
+
+	}
+
+}
+
+CTCALL	BOOL	CTFrameBufferSnapshotAsync(PCTFB fb, PCHAR path, UINT32 format) {
+	return CTFrameBufferSnapshotAsyncEx(fb, path, format, NULL, NULL, NULL);
+}
+
+CTCALL	BOOL	CTFrameBufferSnapshotAsyncEx(
+	PCTFB				fb,
+	PCHAR				path,
+	UINT32				format,
+	PCTSnapshotFence	fence,
+	PCTFUNCSNAPSHOTDONE	callback,
+	PVOID				input
+) {
+	if (fb == NULL) {
+		CTErrorSetBadObject("CTFrameBufferSnapshotAsyncEx failed: fb was NULL");
+		return FALSE;
+	}
+	if (path == NULL) {
+		CTErrorSetBadObject("CTFrameBufferSnapshotAsyncEx failed: path was NULL");
+		return FALSE;
+	}
+	if (strlen(path) >= CT_FILENAME_MAX_LENGTH) {
+		CTErrorSetParamValue("CTFrameBufferSnapshotAsyncEx failed: path was too long");
+		return FALSE;
+	}
+	if (format != CT_SNAPSHOT_FORMAT_RAW &&
+		format != CT_SNAPSHOT_FORMAT_BMP &&
+		format != CT_SNAPSHOT_FORMAT_QOI) {
+		CTErrorSetParamValue("CTFrameBufferSnapshotAsyncEx failed: invalid format");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// take staging buffer from pool
+	/// LOCK FRAMEBUFFER
+	/// copy color into staging buffer (expanded to BGRA)
+	/// UNLOCK FRAMEBUFFER
+	/// ENTER LOCK
+	/// append job to queue
+	/// LEAVE LOCK
+	/// wake snapshot thread
+
+	P__CTSnapshotJob job = __HCTSnapshotJobAcquire((SIZE_T)fb->width * fb->height);
+	if (job == NULL) {
+		CTErrorSetFunction("CTFrameBufferSnapshotAsyncEx failed: could not allocate staging buffer");
+		return FALSE;
+	}
+
+	job->format		= format;
+	job->fence		= fence;
+	job->callback	= callback;
+	job->input		= input;
+	strcpy_s(job->path, CT_FILENAME_MAX_LENGTH, path);
+
+	if (fence != NULL)
+		InterlockedExchange(&fence->status, CT_SNAPSHOT_STATUS_PENDING);
+
+	CTFrameBufferLock(fb);
+	job->width	= fb->width;
+	job->height	= fb->height;
+	CTFrameBufferConvert(fb, job->pixels);
+	CTFrameBufferUnlock(fb);
+
+	CTLockEnter(__ctdata.gfx.snapshot.lock);
+	if (__ctdata.gfx.snapshot.queueTail == NULL) {
+		__ctdata.gfx.snapshot.queueHead = job;
+	} else {
+		((P__CTSnapshotJob)__ctdata.gfx.snapshot.queueTail)->next = job;
+	}
+	__ctdata.gfx.snapshot.queueTail = job;
+	CTLockLeave(__ctdata.gfx.snapshot.lock);
+
+	SetEvent(__ctdata.gfx.snapshot.wakeSignal);
+
+	return TRUE;
+}
+
+CTCALL	UINT32	CTSnapshotFenceStatus(PCTSnapshotFence fence) {
+	if (fence == NULL) {
+		CTErrorSetBadObject("CTSnapshotFenceStatus failed: fence was NULL");
+		return CT_SNAPSHOT_STATUS_FAILED;
+	}
+
+	return InterlockedCompareExchange(&fence->status, 0, 0);
+}
+
+CTCALL	UINT32	CTSnapshotFenceWait(PCTSnapshotFence fence, UINT32 timeoutMsec) {
+	if (fence == NULL) {
+		CTErrorSetBadObject("CTSnapshotFenceWait failed: fence was NULL");
+		return CT_SNAPSHOT_STATUS_FAILED;
+	}
+
+	/// SUMMARY:
+	/// poll fence until it leaves pending or timeout passes
+	/// (INFINITE waits forever)
+
+	UINT64 waitStart = GetTickCount64();
+
+	while (TRUE) {
+		UINT32 status = InterlockedCompareExchange(&fence->status, 0, 0);
+		if (status != CT_SNAPSHOT_STATUS_PENDING)
+			return status;
+
+		if (timeoutMsec != INFINITE &&
+			GetTickCount64() - waitStart >= timeoutMsec)
+			return CT_SNAPSHOT_STATUS_PENDING;
+
+		Sleep(1);
+	}
+}
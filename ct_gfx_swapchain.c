@@ -0,0 +1,269 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_gfx_swapchain.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_gfx.h"
+
+CTCALL	PCTSwapChain	CTSwapChainCreate(UINT32 width, UINT32 height, UINT32 bufferCount) {
+	return CTSwapChainCreateEx(width, height, bufferCount, CT_COLOR_FORMAT_BGRA8888, 0);
+}
+
+CTCALL	PCTSwapChain	CTSwapChainCreateEx(UINT32 width, UINT32 height, UINT32 bufferCount, UINT32 colorFormat, UINT32 fbFlags) {
+	if (width == 0 || height == 0) {
+		CTErrorSetParamValue("CTSwapChainCreate failed: width/height was invalid");
+		return NULL;
+	}
+	if (bufferCount < CT_SWAPCHAIN_BUFFERS_MIN || bufferCount > CT_SWAPCHAIN_BUFFERS_MAX) {
+		CTErrorSetParamValue("CTSwapChainCreate failed: bufferCount was invalid");
+		return NULL;
+	}
+	if (colorFormat > CT_COLOR_FORMAT_INDEXED8) {
+		CTErrorSetParamValue("CTSwapChainCreate failed: colorFormat was invalid");
+		return NULL;
+	}
+
+	/// SUMMARY:
+	/// create all buffers
+	/// buffer 0 starts as the back buffer and the last buffer as the front
+	/// buffer. with 3 buffers, buffer 1 starts in the ready slot (not fresh)
+
+	PCTSwapChain chain	= CTGFXAlloc(sizeof(*chain));
+	chain->swapLock		= CTLockCreate();
+	chain->consumerLock	= CTLockCreate();
+	chain->bufferCount	= bufferCount;
+
+	for (UINT32 bufferIndex = 0; bufferIndex < bufferCount; bufferIndex++) {
+		chain->buffers[bufferIndex] = CTFrameBufferCreateEx(width, height, colorFormat, fbFlags);
+	}
+
+	chain->backIndex	= 0;
+	chain->readyIndex	= 1;
+	chain->frontIndex	= bufferCount - 1;
+
+	return chain;
+}
+
+CTCALL	BOOL			CTSwapChainDestroy(PCTSwapChain* pSwapChain) {
+	if (pSwapChain == NULL) {
+		CTErrorSetBadObject("CTSwapChainDestroy failed: pSwapChain was NULL");
+		return FALSE;
+	}
+
+	PCTSwapChain chain = *pSwapChain;
+
+	if (chain == NULL) {
+		CTErrorSetBadObject("CTSwapChainDestroy failed: swapChain was NULL");
+		return FALSE;
+	}
+
+	CTLockEnter(chain->consumerLock);
+	CTLockEnter(chain->swapLock);
+
+	for (UINT32 bufferIndex = 0; bufferIndex < chain->bufferCount; bufferIndex++) {
+		CTFrameBufferDestroy(&chain->buffers[bufferIndex]);
+	}
+
+	CTLockDestroy(&chain->swapLock);
+	CTLockDestroy(&chain->consumerLock);
+	CTGFXFree(chain);
+
+	*pSwapChain = NULL;
+	return TRUE;
+}
+
+CTCALL	PCTFB			CTSwapChainBackBuffer(PCTSwapChain swapChain) {
+	if (swapChain == NULL) {
+		CTErrorSetBadObject("CTSwapChainBackBuffer failed: swapChain was NULL");
+		return NULL;
+	}
+
+	return swapChain->buffers[swapChain->backIndex];
+}
+
+CTCALL	BOOL			CTSwapChainPublish(PCTSwapChain swapChain) {
+	if (swapChain == NULL) {
+		CTErrorSetBadObject("CTSwapChainPublish failed: swapChain was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// stamp back buffer with the next frame number
+	/// if (triple buffered)
+	///		exchange back buffer with ready slot and mark it fresh
+	///		(the interlocked exchange publishes all writes to the buffer)
+	///		the buffer which was in the ready slot becomes the back buffer
+	/// else
+	///		swap back and front under the swap lock
+
+	swapChain->publishCount++;
+	swapChain->bufferFrame[swapChain->backIndex] = swapChain->publishCount;
+
+	if (swapChain->bufferCount == CT_SWAPCHAIN_BUFFERS_MAX) {
+
+		LONG prevReady = InterlockedExchange(
+			&swapChain->readyIndex,
+			swapChain->backIndex | CT_SWAPCHAIN_FRESH_BIT
+		);
+		swapChain->backIndex = prevReady & CT_SWAPCHAIN_INDEX_MASK;
+
+	} else {
+
+		CTLockEnter(swapChain->swapLock);
+
+		UINT32 tempIndex		= swapChain->frontIndex;
+		swapChain->frontIndex	= swapChain->backIndex;
+		swapChain->backIndex	= tempIndex;
+
+		CTLockLeave(swapChain->swapLock);
+
+	}
+
+	return TRUE;
+}
+
+CTCALL	PCTFB			CTSwapChainAcquireFront(PCTSwapChain swapChain, PUINT64 pFrameNumber) {
+	if (swapChain == NULL) {
+		CTErrorSetBadObject("CTSwapChainAcquireFront failed: swapChain was NULL");
+		return NULL;
+	}
+
+	/// SUMMARY:
+	/// if (triple buffered)
+	///		if (ready slot holds a fresh buffer)
+	///			exchange front buffer with ready slot
+	/// else
+	///		hold swap lock until CTSwapChainReleaseFront
+	/// output frame number of front buffer (0 if nothing was published yet)
+
+	if (swapChain->bufferCount == CT_SWAPCHAIN_BUFFERS_MAX) {
+
+		if ((swapChain->readyIndex & CT_SWAPCHAIN_FRESH_BIT) != 0) {
+			LONG prevReady = InterlockedExchange(
+				&swapChain->readyIndex,
+				swapChain->frontIndex
+			);
+			swapChain->frontIndex = prevReady & CT_SWAPCHAIN_INDEX_MASK;
+		}
+
+	} else {
+
+		CTLockEnter(swapChain->swapLock);
+
+	}
+
+	if (pFrameNumber != NULL)
+		*pFrameNumber = swapChain->bufferFrame[swapChain->frontIndex];
+
+	return swapChain->buffers[swapChain->frontIndex];
+}
+
+CTCALL	BOOL			CTSwapChainReleaseFront(PCTSwapChain swapChain) {
+	if (swapChain == NULL) {
+		CTErrorSetBadObject("CTSwapChainReleaseFront failed: swapChain was NULL");
+		return FALSE;
+	}
+
+	if (swapChain->bufferCount != CT_SWAPCHAIN_BUFFERS_MAX)
+		CTLockLeave(swapChain->swapLock);
+
+	return TRUE;
+}
+
+CTCALL	BOOL			CTSwapChainPresent(PCTSwapChain swapChain) {
+	if (swapChain == NULL) {
+		CTErrorSetBadObject("CTSwapChainPresent failed: swapChain was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// acquire front buffer
+	/// if (front buffer is a frame which has not been presented yet)
+	///		call all consumers with front buffer
+	/// release front buffer
+
+	UINT64	frameNumber = 0;
+	PCTFB	frontBuffer = CTSwapChainAcquireFront(swapChain, &frameNumber);
+
+	if (frameNumber != 0 && frameNumber != swapChain->lastPresentedFrame) {
+
+		swapChain->lastPresentedFrame = frameNumber;
+		swapChain->presentCount++;
+
+		CTLockEnter(swapChain->consumerLock);
+
+		for (UINT32 consumerIndex = 0; consumerIndex < CT_SWAPCHAIN_CONSUMERS_MAX; consumerIndex++) {
+			PCTSwapConsumer consumer = swapChain->consumers + consumerIndex;
+			if (consumer->func == NULL) continue;
+
+			consumer->func(
+				swapChain,
+				frontBuffer,
+				frameNumber,
+				consumer->input
+			);
+		}
+
+		CTLockLeave(swapChain->consumerLock);
+
+	}
+
+	CTSwapChainReleaseFront(swapChain);
+
+	return TRUE;
+}
+
+CTCALL	BOOL			CTSwapChainAddConsumer(PCTSwapChain swapChain, PCTFUNCSWAPCONSUMER func, PVOID input) {
+	if (swapChain == NULL) {
+		CTErrorSetBadObject("CTSwapChainAddConsumer failed: swapChain was NULL");
+		return FALSE;
+	}
+	if (func == NULL) {
+		CTErrorSetParamValue("CTSwapChainAddConsumer failed: func was NULL");
+		return FALSE;
+	}
+
+	CTLockEnter(swapChain->consumerLock);
+
+	for (UINT32 consumerIndex = 0; consumerIndex < CT_SWAPCHAIN_CONSUMERS_MAX; consumerIndex++) {
+		PCTSwapConsumer consumer = swapChain->consumers + consumerIndex;
+		if (consumer->func != NULL) continue;
+
+		consumer->func	= func;
+		consumer->input	= input;
+
+		CTLockLeave(swapChain->consumerLock);
+		return TRUE;
+	}
+
+	CTLockLeave(swapChain->consumerLock);
+	CTErrorSetFunction("CTSwapChainAddConsumer failed: too many consumers");
+	return FALSE;
+}
+
+CTCALL	BOOL			CTSwapChainRemoveConsumer(PCTSwapChain swapChain, PCTFUNCSWAPCONSUMER func, PVOID input) {
+	if (swapChain == NULL) {
+		CTErrorSetBadObject("CTSwapChainRemoveConsumer failed: swapChain was NULL");
+		return FALSE;
+	}
+
+	CTLockEnter(swapChain->consumerLock);
+
+	for (UINT32 consumerIndex = 0; consumerIndex < CT_SWAPCHAIN_CONSUMERS_MAX; consumerIndex++) {
+		PCTSwapConsumer consumer = swapChain->consumers + consumerIndex;
+		if (consumer->func != func || consumer->input != input) continue;
+
+		consumer->func	= NULL;
+		consumer->input	= NULL;
+
+		CTLockLeave(swapChain->consumerLock);
+		return TRUE;
+	}
+
+	CTLockLeave(swapChain->consumerLock);
+	CTErrorSetFunction("CTSwapChainRemoveConsumer failed: consumer was not found");
+	return FALSE;
+}
@@ -0,0 +1,587 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_gfx_texture.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_gfx.h"
+
+#include <intrin.h>
+#include <immintrin.h>
+
+#define CT_TEXTURE_PAL8_HASH_SIZE	1024
+#define CT_TEXTURE_RLE_LITERAL_BIT	0x80
+#define CT_TEXTURE_BC1_ALPHA_CUTOFF	128
+
+static __forceinline CTColor __HCTTextureFrom565(UINT16 packed) {
+	CTColor color;
+	UINT32 r = (packed >> 11) & 0x1F;
+	UINT32 g = (packed >> 5)  & 0x3F;
+	UINT32 b = packed & 0x1F;
+	color.r = (BYTE)((r << 3) | (r >> 2));
+	color.g = (BYTE)((g << 2) | (g >> 4));
+	color.b = (BYTE)((b << 3) | (b >> 2));
+	color.a = 0xFF;
+	return color;
+}
+
+static __forceinline UINT16 __HCTTextureTo565(CTColor color) {
+	return (UINT16)(((color.r >> 3) << 11) | ((color.g >> 2) << 5) | (color.b >> 3));
+}
+
+static __forceinline void __HCTTextureBC1Palette(PBYTE block, PCTColor palette) {
+
+	/// SUMMARY:
+	/// endpoint 0 > endpoint 1:	4 colors, 2 interpolated at thirds
+	/// otherwise:					3 colors, midpoint and clear
+
+	UINT16 packed0 = *(PUINT16)(block + 0);
+	UINT16 packed1 = *(PUINT16)(block + 2);
+
+	palette[0] = __HCTTextureFrom565(packed0);
+	palette[1] = __HCTTextureFrom565(packed1);
+
+	if (packed0 > packed1) {
+		palette[2].r = (BYTE)((2 * palette[0].r + palette[1].r) / 3);
+		palette[2].g = (BYTE)((2 * palette[0].g + palette[1].g) / 3);
+		palette[2].b = (BYTE)((2 * palette[0].b + palette[1].b) / 3);
+		palette[2].a = 0xFF;
+		palette[3].r = (BYTE)((palette[0].r + 2 * palette[1].r) / 3);
+		palette[3].g = (BYTE)((palette[0].g + 2 * palette[1].g) / 3);
+		palette[3].b = (BYTE)((palette[0].b + 2 * palette[1].b) / 3);
+		palette[3].a = 0xFF;
+	} else {
+		palette[2].r = (BYTE)((palette[0].r + palette[1].r) / 2);
+		palette[2].g = (BYTE)((palette[0].g + palette[1].g) / 2);
+		palette[2].b = (BYTE)((palette[0].b + palette[1].b) / 2);
+		palette[2].a = 0xFF;
+		*(PUINT32)&palette[3] = 0;
+	}
+}
+
+static __forceinline PBYTE __HCTTextureBC1Block(PCTTexture texture, UINT32 x, UINT32 memRow) {
+	UINT32 blocksX = (texture->width + 3) / 4;
+	return texture->data + ((SIZE_T)(memRow / 4) * blocksX + (x / 4)) * CT_TEXTURE_BC1_BLOCK_SIZE;
+}
+
+static BOOL __HCTTextureEncodePAL8(PCTTexture texture, PCTColor pixels, SIZE_T pixelCount) {
+
+	/// SUMMARY:
+	/// loop (all pixels)
+	///		look color up in hash table
+	///		if (not found)
+	///			if (palette is full) fail
+	///			add color to palette and hash table
+	///		write palette index
+
+	UINT32	hashKeys	[CT_TEXTURE_PAL8_HASH_SIZE];
+	INT16	hashValues	[CT_TEXTURE_PAL8_HASH_SIZE];
+	UINT32	paletteUsed	= 0;
+
+	for (UINT32 slot = 0; slot < CT_TEXTURE_PAL8_HASH_SIZE; slot++)
+		hashValues[slot] = -1;
+
+	for (SIZE_T pixelIndex = 0; pixelIndex < pixelCount; pixelIndex++) {
+
+		UINT32 key	= *(PUINT32)&pixels[pixelIndex];
+		UINT32 slot	= (key * 2654435761u) >> 22;
+
+		while (hashValues[slot] != -1 && hashKeys[slot] != key)
+			slot = (slot + 1) & (CT_TEXTURE_PAL8_HASH_SIZE - 1);
+
+		if (hashValues[slot] == -1) {
+
+			if (paletteUsed == CT_TEXTURE_PALETTE_SIZE)
+				return FALSE;
+
+			hashKeys[slot]		= key;
+			hashValues[slot]	= (INT16)paletteUsed;
+			texture->palette[paletteUsed++] = pixels[pixelIndex];
+		}
+
+		texture->data[pixelIndex] = (BYTE)hashValues[slot];
+	}
+
+	return TRUE;
+}
+
+static SIZE_T __HCTTextureEncodeRLERow(PCTColor row, UINT32 width, PBYTE out, PCTTextureRun runsOut, PUINT32 runCount) {
+
+	/// SUMMARY:
+	/// loop (row)
+	///		if (texel is clear)
+	///			emit clear run (no texel data)
+	///		else
+	///			emit literal run followed by its texels
+	///		note run start column and offset in run table
+	/// if out is NULL only count bytes and runs
+	/// out and run offsets are relative to the row start
+
+	SIZE_T	writePos	= 0;
+	UINT32	column		= 0;
+
+	while (column < width) {
+
+		BOOL	clear	= (row[column].a == 0);
+		UINT32	runEnd	= column + 1;
+
+		while (runEnd < width &&
+			   runEnd - column < CT_TEXTURE_RLE_RUN_MAX &&
+			   (row[runEnd].a == 0) == clear)
+			runEnd++;
+
+		UINT32 runLength = runEnd - column;
+
+		if (out != NULL) {
+			runsOut[*runCount].column = column;
+			runsOut[*runCount].offset = (UINT32)writePos;
+		}
+		*runCount += 1;
+
+		if (clear) {
+			if (out != NULL)
+				out[writePos] = (BYTE)(runLength - 1);
+			writePos += 1;
+		} else {
+			if (out != NULL) {
+				out[writePos] = (BYTE)(CT_TEXTURE_RLE_LITERAL_BIT | (runLength - 1));
+				memcpy(out + writePos + 1, row + column, sizeof(CTColor) * runLength);
+			}
+			writePos += 1 + (sizeof(CTColor) * runLength);
+		}
+
+		column = runEnd;
+	}
+
+	return writePos;
+}
+
+static void __HCTTextureEncodeBC1Block(PCTColor texels, PBYTE out) {
+
+	/// SUMMARY:
+	/// take bounding box of opaque texels as endpoints
+	/// if (any texel is clear or endpoints are equal)
+	///		use 3 color mode (endpoint 0 <= endpoint 1), index 3 is clear
+	/// else
+	///		use 4 color mode (endpoint 0 > endpoint 1)
+	/// pick closest palette entry for every texel
+
+	CTColor minColor	= { 0xFF, 0xFF, 0xFF, 0xFF };
+	CTColor maxColor	= { 0, 0, 0, 0xFF };
+	BOOL	anyClear	= FALSE;
+	BOOL	anyOpaque	= FALSE;
+
+	for (UINT32 texel = 0; texel < 16; texel++) {
+		if (texels[texel].a < CT_TEXTURE_BC1_ALPHA_CUTOFF) {
+			anyClear = TRUE;
+			continue;
+		}
+		anyOpaque  = TRUE;
+		minColor.r = min(minColor.r, texels[texel].r);
+		minColor.g = min(minColor.g, texels[texel].g);
+		minColor.b = min(minColor.b, texels[texel].b);
+		maxColor.r = max(maxColor.r, texels[texel].r);
+		maxColor.g = max(maxColor.g, texels[texel].g);
+		maxColor.b = max(maxColor.b, texels[texel].b);
+	}
+
+	if (anyOpaque == FALSE) {
+		*(PUINT16)(out + 0) = 0;
+		*(PUINT16)(out + 2) = 0;
+		*(PUINT32)(out + 4) = 0xFFFFFFFF;
+		return;
+	}
+
+	UINT16 packedMax = __HCTTextureTo565(maxColor);
+	UINT16 packedMin = __HCTTextureTo565(minColor);
+
+	UINT16 packed0, packed1;
+	if (anyClear || packedMax == packedMin) {
+		packed0 = min(packedMax, packedMin);
+		packed1 = max(packedMax, packedMin);
+	} else {
+		packed0 = max(packedMax, packedMin);
+		packed1 = min(packedMax, packedMin);
+	}
+
+	*(PUINT16)(out + 0) = packed0;
+	*(PUINT16)(out + 2) = packed1;
+
+	CTColor palette[4];
+	__HCTTextureBC1Palette(out, palette);
+
+	UINT32 paletteUsable	= (packed0 > packed1) ? 4 : 3;
+	UINT32 indices			= 0;
+
+	for (UINT32 texel = 0; texel < 16; texel++) {
+
+		UINT32 bestIndex = 3;
+
+		if (texels[texel].a >= CT_TEXTURE_BC1_ALPHA_CUTOFF) {
+
+			INT32 bestDistance = MAXINT32;
+
+			for (UINT32 entry = 0; entry < paletteUsable; entry++) {
+				INT32 dr = (INT32)texels[texel].r - palette[entry].r;
+				INT32 dg = (INT32)texels[texel].g - palette[entry].g;
+				INT32 db = (INT32)texels[texel].b - palette[entry].b;
+				INT32 distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance) {
+					bestDistance	= distance;
+					bestIndex		= entry;
+				}
+			}
+		}
+
+		indices |= bestIndex << (texel * 2);
+	}
+
+	*(PUINT32)(out + 4) = indices;
+}
+
+static PVOID __HCTTextureAllocData(SIZE_T sizeBytes) {
+	if (sizeBytes < CT_TEXTURE_LARGE_PAGE_THRESHOLD)
+		return CTGFXAllocEx(sizeBytes, CT_MEMORY_TAG_TEXTURE);
+	return CTGFXAllocBulk(sizeBytes, CT_MEMORY_TAG_TEXTURE, CT_GFX_ALLOC_FLAG_LARGE_PAGES);
+}
+
+static BOOL __HCTTextureEncode(PCTTexture texture, PCTColor pixels) {
+
+	UINT32		width		= texture->width;
+	UINT32		height		= texture->height;
+	SIZE_T		pixelCount	= (SIZE_T)width * height;
+
+	switch (texture->format)
+	{
+
+	case CT_TEXTURE_FORMAT_BGRA:
+
+		texture->sizeBytes	= sizeof(CTColor) * pixelCount;
+		texture->data		= __HCTTextureAllocData(texture->sizeBytes);
+		memcpy(texture->data, pixels, texture->sizeBytes);
+		return TRUE;
+
+	case CT_TEXTURE_FORMAT_PAL8:
+
+		texture->sizeBytes	= pixelCount + (sizeof(CTColor) * CT_TEXTURE_PALETTE_SIZE);
+		texture->data		= __HCTTextureAllocData(pixelCount);
+		texture->palette	= CTGFXAllocEx(sizeof(CTColor) * CT_TEXTURE_PALETTE_SIZE, CT_MEMORY_TAG_TEXTURE);
+		return __HCTTextureEncodePAL8(texture, pixels, pixelCount);
+
+	case CT_TEXTURE_FORMAT_RLE: {
+
+		/// SUMMARY:
+		/// measure every row and count its runs, allocate once
+		/// encode every row, filling the run table as it goes
+		/// make run offsets absolute
+
+		texture->rowOffsets	= CTGFXAllocEx(sizeof(UINT32) * height, CT_MEMORY_TAG_TEXTURE);
+		texture->rowRuns	= CTGFXAllocEx(sizeof(UINT32) * (height + 1), CT_MEMORY_TAG_TEXTURE);
+
+		SIZE_T dataSize = 0;
+		UINT32 runCount = 0;
+		for (UINT32 memRow = 0; memRow < height; memRow++) {
+			texture->rowOffsets[memRow]	= (UINT32)dataSize;
+			texture->rowRuns[memRow]	= runCount;
+			dataSize += __HCTTextureEncodeRLERow(pixels + ((SIZE_T)memRow * width), width, NULL, NULL, &runCount);
+		}
+		texture->rowRuns[height] = runCount;
+
+		texture->sizeBytes	= dataSize + (sizeof(UINT32) * height) + (sizeof(UINT32) * (height + 1)) +
+							  (sizeof(CTTextureRun) * runCount);
+		texture->data		= __HCTTextureAllocData(dataSize);
+		texture->runs		= CTGFXAllocEx(sizeof(CTTextureRun) * max(1, runCount), CT_MEMORY_TAG_TEXTURE);
+
+		runCount = 0;
+		for (UINT32 memRow = 0; memRow < height; memRow++) {
+			__HCTTextureEncodeRLERow(
+				pixels + ((SIZE_T)memRow * width),
+				width,
+				texture->data + texture->rowOffsets[memRow],
+				texture->runs,
+				&runCount
+			);
+			for (UINT32 runIndex = texture->rowRuns[memRow]; runIndex < runCount; runIndex++)
+				texture->runs[runIndex].offset += texture->rowOffsets[memRow];
+		}
+
+		return TRUE;
+	}
+
+	case CT_TEXTURE_FORMAT_BC1: {
+
+		/// SUMMARY:
+		/// loop (all 4x4 blocks)
+		///		gather block texels (edge blocks repeat the last row/column)
+		///		encode block
+
+		UINT32 blocksX = (width + 3) / 4;
+		UINT32 blocksY = (height + 3) / 4;
+
+		texture->sizeBytes	= (SIZE_T)blocksX * blocksY * CT_TEXTURE_BC1_BLOCK_SIZE;
+		texture->data		= __HCTTextureAllocData(texture->sizeBytes);
+
+		for (UINT32 blockY = 0; blockY < blocksY; blockY++) {
+			for (UINT32 blockX = 0; blockX < blocksX; blockX++) {
+
+				CTColor texels[16];
+				for (UINT32 texel = 0; texel < 16; texel++) {
+					UINT32 column	= min(blockX * 4 + (texel % 4), width - 1);
+					UINT32 memRow	= min(blockY * 4 + (texel / 4), height - 1);
+					texels[texel]	= pixels[column + ((SIZE_T)memRow * width)];
+				}
+
+				__HCTTextureEncodeBC1Block(
+					texels,
+					texture->data + ((SIZE_T)blockY * blocksX + blockX) * CT_TEXTURE_BC1_BLOCK_SIZE
+				);
+			}
+		}
+
+		return TRUE;
+	}
+
+	default:
+		return FALSE;
+
+	}
+}
+
+CTCALL	PCTTexture	CTTextureCreate(PCTFB source, UINT32 format) {
+	if (source == NULL) {
+		CTErrorSetBadObject("CTTextureCreate failed: source was NULL");
+		return NULL;
+	}
+	if (format > CT_TEXTURE_FORMAT_BC1) {
+		CTErrorSetParamValue("CTTextureCreate failed: invalid format");
+		return NULL;
+	}
+
+	/// SUMMARY:
+	/// LOCK SOURCE
+	/// if (source is not BGRA)
+	///		expand source into temporary BGRA buffer
+	/// encode source color into format (source depth is ignored)
+	/// UNLOCK SOURCE
+
+	PCTTexture texture	= CTGFXAllocEx(sizeof(*texture), CT_MEMORY_TAG_TEXTURE);
+	texture->format		= format;
+	texture->width		= source->width;
+	texture->height		= source->height;
+
+	CTFrameBufferLock(source);
+
+	PCTColor pixels = source->color;
+	if (source->format != CT_COLOR_FORMAT_BGRA8888) {
+		pixels = CTGFXAllocEx(sizeof(CTColor) * source->width * source->height, CT_MEMORY_TAG_TEXTURE);
+		CTFrameBufferConvert(source, pixels);
+	}
+
+	BOOL encoded = __HCTTextureEncode(texture, pixels);
+
+	if (pixels != source->color)
+		CTGFXFree(pixels);
+
+	CTFrameBufferUnlock(source);
+
+	if (encoded == FALSE) {
+		CTTextureDestroy(&texture);
+		CTErrorSetParamValue("CTTextureCreate failed: source has more colors than the palette can hold");
+		return NULL;
+	}
+
+	return texture;
+}
+
+CTCALL	BOOL		CTTextureDestroy(PCTTexture* pTexture) {
+	if (pTexture == NULL) {
+		CTErrorSetBadObject("CTTextureDestroy failed: pTexture was NULL");
+		return FALSE;
+	}
+
+	PCTTexture texture = *pTexture;
+
+	if (texture == NULL) {
+		CTErrorSetBadObject("CTTextureDestroy failed: texture was NULL");
+		return FALSE;
+	}
+
+	if (texture->data != NULL)
+		CTGFXFree(texture->data);
+	if (texture->palette != NULL)
+		CTGFXFree(texture->palette);
+	if (texture->rowOffsets != NULL)
+		CTGFXFree(texture->rowOffsets);
+	if (texture->rowRuns != NULL)
+		CTGFXFree(texture->rowRuns);
+	if (texture->runs != NULL)
+		CTGFXFree(texture->runs);
+
+	CTGFXFree(texture);
+
+	*pTexture = NULL;
+	return TRUE;
+}
+
+CTCALL	CTColor		CTTextureGet(PCTTexture texture, UINT32 x, UINT32 y) {
+
+	UINT32 memRow = texture->height - y - 1;
+
+	switch (texture->format)
+	{
+
+	case CT_TEXTURE_FORMAT_BGRA:
+
+		return ((PCTColor)texture->data)[x + ((SIZE_T)memRow * texture->width)];
+
+	case CT_TEXTURE_FORMAT_PAL8:
+
+		return texture->palette[texture->data[x + ((SIZE_T)memRow * texture->width)]];
+
+	case CT_TEXTURE_FORMAT_RLE: {
+
+		/// SUMMARY:
+		/// binary search row's runs for the last run starting at or before x
+		/// literal run:	texel follows the op byte
+		/// clear run:		texel is clear
+
+		PCTTextureRun	run			= texture->runs + texture->rowRuns[memRow];
+		UINT32			runCount	= texture->rowRuns[memRow + 1] - texture->rowRuns[memRow];
+
+		while (runCount > 1) {
+			UINT32 half	= runCount / 2;
+			run			= (run[half].column <= x) ? run + half : run;
+			runCount	-= half;
+		}
+
+		PBYTE op = texture->data + run->offset;
+		if (op[0] & CT_TEXTURE_RLE_LITERAL_BIT)
+			return ((PCTColor)(op + 1))[x - run->column];
+
+		CTColor clear = { 0 };
+		return clear;
+	}
+
+	case CT_TEXTURE_FORMAT_BC1: {
+
+		PBYTE	block	= __HCTTextureBC1Block(texture, x, memRow);
+		UINT32	shift	= (((memRow % 4) * 4) + (x % 4)) * 2;
+		UINT32	index	= (*(PUINT32)(block + 4) >> shift) & 0x03;
+
+		CTColor palette[4];
+		__HCTTextureBC1Palette(block, palette);
+		return palette[index];
+	}
+
+	default: {
+		CTColor clear = { 0 };
+		return clear;
+	}
+
+	}
+}
+
+CTCALL	BOOL		CTTextureGetRow(PCTTexture texture, UINT32 y, PCTColor rowOut) {
+	if (texture == NULL) {
+		CTErrorSetBadObject("CTTextureGetRow failed: texture was NULL");
+		return FALSE;
+	}
+	if (rowOut == NULL) {
+		CTErrorSetBadObject("CTTextureGetRow failed: rowOut was NULL");
+		return FALSE;
+	}
+	if (y >= texture->height) {
+		CTErrorSetParamValue("CTTextureGetRow failed: y was out of bounds");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// decode a whole row in one pass
+	/// PAL8:	palette lookup (8 texels per gather in AVX2 builds)
+	/// RLE:	walk runs once, fill clear runs and copy literal runs
+	/// BC1:	build each block palette once per 4 texels
+
+	UINT32	width	= texture->width;
+	UINT32	memRow	= texture->height - y - 1;
+
+	switch (texture->format)
+	{
+
+	case CT_TEXTURE_FORMAT_BGRA:
+
+		memcpy(rowOut, texture->data + (sizeof(CTColor) * memRow * width), sizeof(CTColor) * width);
+		break;
+
+	case CT_TEXTURE_FORMAT_PAL8: {
+
+		PBYTE	indices = texture->data + ((SIZE_T)memRow * width);
+		UINT32	column	= 0;
+
+#ifdef __AVX2__
+		for (; column + 8 <= width; column += 8) {
+			__m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(indices + column)));
+			_mm256_storeu_si256(
+				(__m256i*)(rowOut + column),
+				_mm256_i32gather_epi32((const int*)texture->palette, lanes, 4)
+			);
+		}
+#endif
+
+		for (; column < width; column++)
+			rowOut[column] = texture->palette[indices[column]];
+
+		break;
+	}
+
+	case CT_TEXTURE_FORMAT_RLE: {
+
+		PBYTE	run		= texture->data + texture->rowOffsets[memRow];
+		UINT32	column	= 0;
+
+		while (column < width) {
+			BYTE	op			= run[0];
+			UINT32	runLength	= (op & ~CT_TEXTURE_RLE_LITERAL_BIT) + 1;
+
+			if (op & CT_TEXTURE_RLE_LITERAL_BIT) {
+				memcpy(rowOut + column, run + 1, sizeof(CTColor) * runLength);
+				run += 1 + (sizeof(CTColor) * runLength);
+			} else {
+				__stosd((PDWORD)(rowOut + column), 0, runLength);
+				run += 1;
+			}
+
+			column += runLength;
+		}
+
+		break;
+	}
+
+	case CT_TEXTURE_FORMAT_BC1: {
+
+		UINT32 shiftBase = (memRow % 4) * 8;
+
+		for (UINT32 column = 0; column < width; column += 4) {
+
+			PBYTE	block	= __HCTTextureBC1Block(texture, column, memRow);
+			UINT32	bits	= *(PUINT32)(block + 4) >> shiftBase;
+
+			CTColor palette[4];
+			__HCTTextureBC1Palette(block, palette);
+
+			UINT32 blockTexels = min(4, width - column);
+			for (UINT32 texel = 0; texel < blockTexels; texel++)
+				rowOut[column + texel] = palette[(bits >> (texel * 2)) & 0x03];
+		}
+
+		break;
+	}
+
+	default:
+		break;
+
+	}
+
+	return TRUE;
+}
@@ -21,16 +21,9 @@ DWORD __stdcall __CTLoggingThreadProc(PVOID input) {
 	/// 
 	///		record spin start time
 	///		
-	///		ENTER LOCK
-	///		
-	///		for (all queued log entries)
-	///			copy to write list
-	/// 
-	///		CLEAR QUEUE
-	///		
-	///		LEAVE LOCK
-	/// 
-	///		for (all in write list)
+	///		while (queue has entries and budget of one queue's worth is left)
+	///			dequeue batch of log entries into write buffer
+	///		for (all in write buffer)
 	///			if (file is NULL)
 	///				open specified file
 	///			if (file has changed)
@@ -53,120 +46,114 @@ DWORD __stdcall __CTLoggingThreadProc(PVOID input) {
 	INT64 SPIN_TIME_START		= 0;
 	INT64 SPIN_TIME_END			= CT_LOGGING_SLEEP_INTERVAL_MSECS;
 	PCTLogEntry LOG_ENTRY		= NULL;
-	PCTDynList logWriteBuffer	= CTDynListCreate(sizeof(CTLogEntry), CT_LOGGING_QUEUE_NODE_SIZE);
+	PCTLogEntry logWriteBuffer	= CTAllocEx(sizeof(CTLogEntry) * CT_LOGGING_WRITE_BATCH_SIZE, CT_MEMORY_TAG_LOGGING, FALSE);
 
 	while (TRUE) {
 
 		INT64 SPIN_TIME_TOTAL = SPIN_TIME_END - SPIN_TIME_START;
 
-		if (__ctdata.logging.logWriteQueue->elementsUsedCount == 0) {
+		if (CTQueueCount(__ctdata.logging.logWriteQueue) == 0) {
 			Sleep(max(0, CT_LOGGING_SLEEP_INTERVAL_MSECS - SPIN_TIME_TOTAL));
 		}
 
 		SPIN_TIME_START = GetTickCount64();
 
-		CTLockEnter(__ctdata.logging.lock);
+		PCTFile		logFile			= NULL;
+		UINT32		entryBudget		= CT_LOGGING_QUEUE_CAPACITY;
+		UINT32		entryCount		= 0;
+
+		while (entryBudget > 0 &&
+			(entryCount = CTQueueDequeueBatch(__ctdata.logging.logWriteQueue, logWriteBuffer, CT_LOGGING_WRITE_BATCH_SIZE)) > 0) {
 
-		PCTIterator logQueueIter = CTIteratorCreate(__ctdata.logging.logWriteQueue);
-		while ((LOG_ENTRY = CTIteratorIterate(logQueueIter)) != NULL) {
-			PCTLogEntry entry = CTDynListAdd(logWriteBuffer);
-			*entry = *LOG_ENTRY;
-		}
-		CTIteratorDestroy(&logQueueIter);
-		CTDynListClear(__ctdata.logging.logWriteQueue);
+			entryBudget -= min(entryBudget, entryCount);
 
-		CTLockLeave(__ctdata.logging.lock);
+			for (UINT32 entryIndex = 0; entryIndex < entryCount; entryIndex++) {
 
-		PCTIterator writeBufferIter = CTIteratorCreate(logWriteBuffer);
-		PCTFile		logFile			= NULL;
-		while ( (LOG_ENTRY = CTIteratorIterate(writeBufferIter)) != NULL) {
+				LOG_ENTRY = logWriteBuffer + entryIndex;
 
-			if (logFile == NULL) {
-				logFile = CTFileOpen(LOG_ENTRY->logStream->streamName);
 				if (logFile == NULL) {
-					CTErrorSetFunction("__CTLoggingThreadProc encountered fatal error: could not open file");
-					continue;
+					logFile = CTFileOpen(LOG_ENTRY->logStream->streamName);
+					if (logFile == NULL) {
+						CTErrorSetFunction("__CTLoggingThreadProc encountered fatal error: could not open file");
+						continue;
+					}
 				}
-			}
 
-			if (strcmp(logFile->fileName, LOG_ENTRY->logStream->streamName) != 0) {
-				CTFileClose(&logFile);
-				logFile = CTFileOpen(LOG_ENTRY->logStream->streamName);
-			}
+				if (strcmp(logFile->fileName, LOG_ENTRY->logStream->streamName) != 0) {
+					CTFileClose(&logFile);
+					logFile = CTFileOpen(LOG_ENTRY->logStream->streamName);
+				}
 
-			if (LOG_ENTRY->logStream->logHook != NULL) {
-				LOG_ENTRY->logStream->logHook(
-					LOG_ENTRY,
-					LOG_ENTRY->logStream->hookInput
-				);
-			}
+				if (LOG_ENTRY->logStream->logHook != NULL) {
+					LOG_ENTRY->logStream->logHook(
+						LOG_ENTRY,
+						LOG_ENTRY->logStream->hookInput
+					);
+				}
 
-			PCHAR	logFmtBuffer	= CTAlloc(CT_LOGGING_MAX_WRITE_SIZE);
-			PCHAR	logTypeString	= "Unknown";
-			switch (LOG_ENTRY->logType)
-			{
+				PCHAR	logFmtBuffer	= CTAllocEx(CT_LOGGING_MAX_WRITE_SIZE, CT_MEMORY_TAG_LOGGING, FALSE);
+				PCHAR	logTypeString	= "Unknown";
+				switch (LOG_ENTRY->logType)
+				{
 
-			case CT_LOG_ENTRY_TYPE_INFO:
-				logTypeString = "Info";
-				break;
+				case CT_LOG_ENTRY_TYPE_INFO:
+					logTypeString = "Info";
+					break;
 
-			case CT_LOG_ENTRY_TYPE_INFO_IMPORTANT:
-				logTypeString = "Imporant Info";
-				break;
+				case CT_LOG_ENTRY_TYPE_INFO_IMPORTANT:
+					logTypeString = "Imporant Info";
+					break;
+
+				case CT_LOG_ENTRY_TYPE_WARNING:
+					logTypeString = "Warning";
+					break;
+
+				case CT_LOG_ENTRY_TYPE_FAILURE:
+					logTypeString = "Failure";
+					break;
+
+				default:
+					break;
+
+				}
 
-			case CT_LOG_ENTRY_TYPE_WARNING:
-				logTypeString = "Warning";
-				break;
+				INT64 totalTimeSecs = LOG_ENTRY->logTimeMsecs / 1000;
+				INT32 timeHours		= totalTimeSecs  / 3600;
+				INT32 timeMins		= (totalTimeSecs / 60) % 60;
+				INT32 timeSecs		= (totalTimeSecs) % 60;
+				INT32 timeMsecs		= LOG_ENTRY->logTimeMsecs % 1000;
+
+				sprintf_s(
+					logFmtBuffer,
+					CT_LOGGING_MAX_WRITE_SIZE - 1,
+					"\n<%08d> ( %02dh : %02dm : %02ds : %03dms ) [ THREAD ID: %X ] [ %s ] \n%s\n",
+					(INT32)LOG_ENTRY->logNumber,
+					timeHours,
+					timeMins,
+					timeSecs,
+					timeMsecs,
+					LOG_ENTRY->logThreadID,
+					logTypeString,
+					LOG_ENTRY->message
+				);
 
-			case CT_LOG_ENTRY_TYPE_FAILURE:
-				logTypeString = "Failure";
-				break;
+				CTFileWrite(
+					logFile,
+					logFmtBuffer,
+					CTFileSize(logFile),
+					strnlen_s(logFmtBuffer, CT_LOGGING_MAX_WRITE_SIZE)
+				);
 
-			default:
-				break;
+				CTFree(logFmtBuffer);
 
+				InterlockedDecrement64(&LOG_ENTRY->logStream->logsOutstanding);
 			}
 
-			INT64 totalTimeSecs = LOG_ENTRY->logTimeMsecs / 1000;
-			INT32 timeHours		= totalTimeSecs  / 3600;
-			INT32 timeMins		= (totalTimeSecs / 60) % 60;
-			INT32 timeSecs		= (totalTimeSecs) % 60;
-			INT32 timeMsecs		= LOG_ENTRY->logTimeMsecs % 1000;
-
-			sprintf_s(
-				logFmtBuffer,
-				CT_LOGGING_MAX_WRITE_SIZE - 1,
-				"\n<%08d> ( %02dh : %02dm : %02ds : %03dms ) [ THREAD ID: %X ] [ %s ] \n%s\n",
-				(INT32)LOG_ENTRY->logNumber,
-				timeHours,
-				timeMins,
-				timeSecs,
-				timeMsecs,
-				LOG_ENTRY->logThreadID,
-				logTypeString,
-				LOG_ENTRY->message
-			);
-
-			CTFileWrite(
-				logFile,
-				logFmtBuffer,
-				CTFileSize(logFile),
-				strnlen_s(logFmtBuffer, CT_LOGGING_MAX_WRITE_SIZE)
-			);
-
-			CTFree(logFmtBuffer);
-
-			CTLockEnter(__ctdata.logging.lock);
-			LOG_ENTRY->logStream->logsOutstanding--;
-			CTLockLeave(__ctdata.logging.lock);
 		}
 
 		if (logFile != NULL)
 			CTFileClose(&logFile);
 
-		CTIteratorDestroy(&writeBufferIter);
-		CTDynListClear(logWriteBuffer);
-
 		SPIN_TIME_END = GetTickCount64();
 
 		DWORD killSignalResult = WaitForSingleObject(
@@ -175,8 +162,9 @@ DWORD __stdcall __CTLoggingThreadProc(PVOID input) {
 		);
 
 		if (killSignalResult == WAIT_OBJECT_0 && 
-			__ctdata.logging.logWriteQueue->elementsUsedCount == 0) {
-			CTDynListDestroy(&logWriteBuffer);
+			CTQueueCount(__ctdata.logging.logWriteQueue) == 0) {
+			CTFree(logWriteBuffer);
+			CTAllocThreadCacheFlush();
 			ExitThread(ERROR_SUCCESS);
 		}
 		
@@ -197,7 +185,7 @@ CTCALL	PCTLogStream		CTLogStreamCreate(PCHAR streamName, PCTFUNCLOGHOOK logHook,
 		return NULL;
 	}
 
-	PCTLogStream ls		= CTAlloc(sizeof(*ls));
+	PCTLogStream ls		= CTAllocEx(sizeof(*ls), CT_MEMORY_TAG_LOGGING, TRUE);
 	ls->logCount		= 0;
 	ls->logsOutstanding	= 0;
 	ls->logHook			= logHook;
@@ -212,7 +200,7 @@ CTCALL	PCTLogStream		CTLogStreamCreate(PCHAR streamName, PCTFUNCLOGHOOK logHook,
 	SYSTEMTIME streamInitTime;
 	GetLocalTime(&streamInitTime);
 
-	PCHAR fileHeaderFmtBuffer = CTAlloc(CT_LOGGING_MAX_WRITE_SIZE);
+	PCHAR fileHeaderFmtBuffer = CTAllocEx(CT_LOGGING_MAX_WRITE_SIZE, CT_MEMORY_TAG_LOGGING, FALSE);
 	sprintf_s(
 		fileHeaderFmtBuffer,
 		CT_LOGGING_MAX_WRITE_SIZE - 1,
@@ -287,55 +275,49 @@ CTCALL	BOOL				CTLogStreamDestroy(PCTLogStream* pStream) {
 
 CTCALL	BOOL				CTLog(PCTLogStream stream, UINT32 logType, PCHAR message) {
 
-	CTLockEnter(__ctdata.logging.lock);
-
 	if (stream == NULL) {
-
 		CTErrorSetBadObject("CTLog failed: stream was NULL");
-		CTLockLeave(__ctdata.logging.lock);
-
 		return FALSE;
-
 	}
 
 	if (message == NULL) {
-
 		CTErrorSetBadObject("CTLog failed: message was NULL");
-		CTLockLeave(__ctdata.logging.lock);
-
 		return FALSE;
-
 	}
 
+	/// SUMMARY:
+	/// count log as outstanding, then check destroy signal
+	/// (CTLogStreamDestroy waits for outstanding logs after signalling)
+	/// claim queue cell, yielding while the queue is full
+	/// fill in log entry and publish cell
+
+	InterlockedIncrement64(&stream->logsOutstanding);
+
 	if (stream->destroySignal == TRUE) {
 
-		CTErrorSetBadObject("CTLogStreamDestroy failed: stream is being destroyed");
-		CTLockLeave(__ctdata.logging.lock);
+		InterlockedDecrement64(&stream->logsOutstanding);
+		CTErrorSetBadObject("CTLog failed: stream is being destroyed");
 
 		return FALSE;
 
 	}
 
-	CTDynListLock(__ctdata.logging.logWriteQueue);
+	/// never waits on the logging thread, which may itself be logging
+	PCTLogEntry pentry = CTQueueEnqueueBegin(__ctdata.logging.logWriteQueue);
 
-	PCTLogEntry pentry		= CTDynListAdd(__ctdata.logging.logWriteQueue);
 	pentry->logStream		= stream;
-	pentry->logThreadID		= GetThreadId(GetCurrentThread());
+	pentry->logThreadID		= GetCurrentThreadId();
 	pentry->logType			= logType;
-	pentry->logNumber		= stream->logCount++;
+	pentry->logNumber		= InterlockedIncrement64(&stream->logCount) - 1;
 	pentry->logTimeMsecs	= GetTickCount64() - __ctdata.logging.startTimeMsecs;
 
-	stream->logsOutstanding++;
-
 	strcpy_s(
 		pentry->message,
 		CT_LOG_MESSAGE_SIZE - 1,
 		message
 	);
 
-	CTDynListUnlock(__ctdata.logging.logWriteQueue);
-
-	CTLockLeave(__ctdata.logging.lock);
+	CTQueueEnqueueEnd(__ctdata.logging.logWriteQueue, pentry);
 
 	return TRUE;
 
@@ -12,7 +12,8 @@
 #include "ct_base.h"
 #include <varargs.h>
 
-#define CT_LOGGING_QUEUE_NODE_SIZE 1024
+#define CT_LOGGING_QUEUE_CAPACITY 0x1000
+#define CT_LOGGING_WRITE_BATCH_SIZE 0x40
 
 //////////////////////////////////////////////////////////////////////////////
 ///
@@ -39,8 +40,8 @@ typedef struct CTLogStream {
 	PCTFUNCLOGHOOK	logHook;
 	PVOID			hookInput;
 	CHAR			streamName [CT_LOGSTREAM_NAME_SIZE];
-	UINT64			logCount;
-	UINT64			logsOutstanding;
+	volatile LONG64	logCount;
+	volatile LONG64	logsOutstanding;
 } CTLogStream, *PCTLogStream;
 
 #define CT_LOG_ENTRY_TYPE_INFO				0
@@ -18,29 +18,240 @@ typedef struct __CTThreadInput {
 typedef struct __CTThreadTaskData {
 	PCTFUNCTHREADTASK	taskFunc;
 	PVOID				userInput;
-	HANDLE				taskCompleteMsg;
+	PCTFuture			future;
+	UINT64				submitTick;
 } __CTThreadTaskData, *P__CTThreadTaskData;
 
+#define __CT_THREAD_HISTOGRAM_SUB_BITS	3
+#define __CT_THREAD_HISTOGRAM_SUB_COUNT	(1 << __CT_THREAD_HISTOGRAM_SUB_BITS)
+
+static UINT32 __HCTThreadHistogramBucket(UINT64 usec) {
+
+	/// SUMMARY:
+	/// values below sub count get a bucket each
+	/// else bucket is picked by highest set bit and the sub bits below it
+
+	if (usec < __CT_THREAD_HISTOGRAM_SUB_COUNT)
+		return (UINT32)usec;
+
+	ULONG highBit;
+	_BitScanReverse(&highBit, (ULONG)min(usec, MAXULONG));
+
+	UINT32 shift = highBit - __CT_THREAD_HISTOGRAM_SUB_BITS;
+	return __CT_THREAD_HISTOGRAM_SUB_COUNT + (shift * __CT_THREAD_HISTOGRAM_SUB_COUNT) +
+		(UINT32)((usec >> shift) & (__CT_THREAD_HISTOGRAM_SUB_COUNT - 1));
+}
+
+static UINT64 __HCTThreadHistogramBucketEdge(UINT32 bucket) {
+	if (bucket < __CT_THREAD_HISTOGRAM_SUB_COUNT)
+		return bucket;
+
+	UINT32 shift	= (bucket - __CT_THREAD_HISTOGRAM_SUB_COUNT) / __CT_THREAD_HISTOGRAM_SUB_COUNT;
+	UINT64 sub		= (bucket - __CT_THREAD_HISTOGRAM_SUB_COUNT) % __CT_THREAD_HISTOGRAM_SUB_COUNT;
+	return ((__CT_THREAD_HISTOGRAM_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+static void __HCTThreadHistogramAdd(PCTThreadHistogram histogram, UINT64 usec) {
+	histogram->buckets[__HCTThreadHistogramBucket(usec)] += 1;
+	histogram->maxUsec = max(histogram->maxUsec, usec);
+	histogram->sampleCount += 1;
+}
+
+static void __HCTThreadHistogramRead(PCTThreadHistogram histogram, PCTThreadLatencyStats statsOut, BOOL reset) {
+
+	/// SUMMARY:
+	/// walk histogram, output upper edge of the buckets which hold the
+	/// 50th and 99th percentile sample
+	/// if (reset)
+	///		clear histogram
+
+	ZeroMemory(statsOut, sizeof(*statsOut));
+	statsOut->sampleCount	= histogram->sampleCount;
+	statsOut->maxUsec		= histogram->maxUsec;
+
+	UINT64 p50Rank	= (histogram->sampleCount * 50 + 99) / 100;
+	UINT64 p99Rank	= (histogram->sampleCount * 99 + 99) / 100;
+	UINT64 seen		= 0;
+
+	for (UINT32 bucket = 0; bucket < CT_THREAD_HISTOGRAM_BUCKETS && seen < p99Rank; bucket++) {
+		if (histogram->buckets[bucket] == 0) continue;
+
+		seen += histogram->buckets[bucket];
+
+		if (statsOut->p50Usec == 0 && seen >= p50Rank)
+			statsOut->p50Usec = min(__HCTThreadHistogramBucketEdge(bucket), statsOut->maxUsec);
+		if (seen >= p99Rank)
+			statsOut->p99Usec = min(__HCTThreadHistogramBucketEdge(bucket), statsOut->maxUsec);
+	}
+
+	if (reset == TRUE)
+		ZeroMemory(histogram, sizeof(*histogram));
+}
+
+static void __HCTThreadWake(PCTThread thread) {
+
+	/// only the submission which raises the signal pays for the wake
+	if (thread->wakeSignal == FALSE &&
+		InterlockedExchange(&thread->wakeSignal, TRUE) == FALSE)
+		WakeByAddressSingle((PVOID)&thread->wakeSignal);
+}
+
+static void __HCTThreadRunTasks(PCTThread thread) {
+
+	/// SUMMARY:
+	/// while (tasks are queued and budget of one queue's worth is left):
+	///		dequeue batch of tasks
+	///		record latency of every task in batch
+	///		for (all tasks in batch)
+	///			execute threadtask
+	///			complete and release future if task has one
+
+	__CTThreadTaskData	taskBatch[CT_THREAD_TASK_BATCH_SIZE];
+	UINT32				taskBudget	= CT_THREAD_TASK_QUEUE_CAPACITY;
+	UINT32				taskCount	= 0;
+
+	while (taskBudget > 0 &&
+		(taskCount = CTQueueDequeueBatch(thread->threadTaskQueue, taskBatch, min(taskBudget, CT_THREAD_TASK_BATCH_SIZE))) > 0) {
+
+		UINT64 RUN_TICK = CTClockTicks();
+
+		for (UINT32 taskIndex = 0; taskIndex < taskCount; taskIndex++) {
+			UINT64 SUBMIT_TICK = min(RUN_TICK, taskBatch[taskIndex].submitTick);
+			__HCTThreadHistogramAdd(
+				&thread->taskLatency,
+				CTClockTicksToUsec(RUN_TICK - SUBMIT_TICK)
+			);
+		}
+
+		for (UINT32 taskIndex = 0; taskIndex < taskCount; taskIndex++) {
+			P__CTThreadTaskData task = taskBatch + taskIndex;
+
+			task->taskFunc(
+				thread,
+				thread->threadData,
+				task->userInput
+			);
+
+			if (task->future != NULL) {
+				CTFutureComplete(task->future, task->userInput);
+				CTFutureRelease(&task->future);
+			}
+		}
+
+		taskBudget -= taskCount;
+	}
+}
+
+static void __HCTThreadWaitUntil(PCTThread thread, UINT64 deadlineUsec) {
+
+	/// SUMMARY:
+	/// until (deadline has passed or killsignal):
+	///		if (not paced)
+	///			wait on wakesignal for the time left
+	///		else if (time left is at least a msec more than the wait lead)
+	///			wait on wakesignal for the time left minus the lead
+	///			if (the wait timed out)
+	///				raise lead to its oversleep, or let it decay towards it
+	///		else if (time left is more than the final spin)
+	///			wait on high resolution timer until the final spin
+	///		else
+	///			spin until deadline
+	///		if (woken by a task submission)
+	///			ENTER LOCK, run queued threadtasks, LEAVE LOCK
+
+	BOOL PACED		= (thread->threadFlags & CT_THREAD_FLAG_PACED) != 0;
+	LONG NOT_WOKEN	= FALSE;
+
+	while (thread->killSignal == FALSE) {
+
+		UINT64 WAIT_START = CTClockUsec();
+		if (WAIT_START >= deadlineUsec) break;
+
+		UINT64 WAIT_LEFT = deadlineUsec - WAIT_START;
+		UINT64 WAIT_LEAD = min(
+			CT_THREAD_PACE_LEAD_MAX_USEC,
+			max(CT_THREAD_PACE_LEAD_MIN_USEC, thread->paceOversleepUsec + CT_THREAD_PACE_SPIN_USEC)
+		);
+
+		if (PACED == FALSE) {
+
+			WaitOnAddress(
+				&thread->wakeSignal,
+				&NOT_WOKEN,
+				sizeof(NOT_WOKEN),
+				(DWORD)((WAIT_LEFT + 999) / 1000)
+			);
+
+		} else if (WAIT_LEFT >= WAIT_LEAD + 1000) {
+
+			DWORD WAIT_MSEC = (DWORD)((WAIT_LEFT - WAIT_LEAD) / 1000);
+			BOOL WOKEN		= WaitOnAddress(
+				&thread->wakeSignal,
+				&NOT_WOKEN,
+				sizeof(NOT_WOKEN),
+				WAIT_MSEC
+			);
+
+			if (WOKEN == FALSE && GetLastError() == ERROR_TIMEOUT) {
+				UINT64 WAIT_TIME = CTClockUsec() - WAIT_START;
+				UINT64 OVERSLEEP = WAIT_TIME - min(WAIT_TIME, (UINT64)WAIT_MSEC * 1000);
+				thread->paceOversleepUsec = max(
+					OVERSLEEP,
+					(thread->paceOversleepUsec * 15 + OVERSLEEP) / 16
+				);
+			}
+
+		} else if (WAIT_LEFT > CT_THREAD_PACE_SPIN_USEC && thread->paceTimer != NULL) {
+
+			LARGE_INTEGER DUE_TIME;
+			DUE_TIME.QuadPart = -(INT64)((WAIT_LEFT - CT_THREAD_PACE_SPIN_USEC) * 10);
+			SetWaitableTimer(thread->paceTimer, &DUE_TIME, 0, NULL, NULL, FALSE);
+			WaitForSingleObject(thread->paceTimer, INFINITE);
+
+		} else {
+
+			CTClockSpinUntil(deadlineUsec);
+
+		}
+
+		if (InterlockedExchange(&thread->wakeSignal, FALSE) == TRUE) {
+			CTLockEnter(thread->threadLock);
+			__HCTThreadRunTasks(thread);
+			CTLockLeave(thread->threadLock);
+		}
+	}
+}
+
 static DWORD __HCTThreadProc(P__CTThreadInput threadInput) {
 
 	/// SUMMARY:
+	/// bind frame arena to this thread
 	/// call thread init
 	/// loop (forever)
 	///		ENTER LOCK
-	///		record start time
+	///		record start time and interval since last start
+	///		if (paced)
+	///			record how late the spin started
+	///		reset frame arena
 	///		call thread spin
-	///		loop (all threadtasks)
-	///			execute threadtask
+	///		run queued threadtasks
 	///		if (killsignal)
+	///			run threadtasks until no producer is mid-enqueue
 	///			call thread exit
 	///			exit
-	///		record end time
+	///		if (paced)
+	///			next deadline is one interval after the last deadline,
+	///			skipping (and counting) every deadline the spin ran past
+	///		else
+	///			next deadline is one interval after start time
 	///		LEAVE LOCK
-	///		sleep(spin_time - elasped time)
+	///		wait until next deadline, running threadtasks when woken
 
 	PCTThread thread	= threadInput->thread;
 	PVOID userInit		= threadInput->initUserInput;
 
+	CTArenaFrameSet(thread->threadFrameArena);
+
 	CTLockEnter(thread->threadLock);
 	thread->threadProc(
 		CT_THREADPROC_REASON_INIT,
@@ -52,17 +263,31 @@ static DWORD __HCTThreadProc(P__CTThreadInput threadInput) {
 
 	SetEvent(threadInput->initCompleteMsg);
 
-	UINT64 CLOCK_FREQUENCY_MSEC;
-	QueryPerformanceFrequency(&CLOCK_FREQUENCY_MSEC);
-	CLOCK_FREQUENCY_MSEC /= 1000;
+	BOOL	PACED				= (thread->threadFlags & CT_THREAD_FLAG_PACED) != 0;
+	UINT64	SPIN_INTERVAL		= thread->threadSpinIntervalUsec;
+	UINT64	LAST_SPIN_START		= 0;
+	thread->paceDeadlineUsec	= CTClockUsec();
 
 	while (TRUE) {
 
 		CTLockEnter(thread->threadLock);
 
-		INT64 SPIN_START;
-		QueryPerformanceCounter(&SPIN_START);
-		SPIN_START /= CLOCK_FREQUENCY_MSEC;
+		UINT64 SPIN_START = CTClockUsec();
+
+		if (thread->threadSpinCount > 0) {
+			thread->threadSpinLastIntervalUsec = SPIN_START - LAST_SPIN_START;
+			thread->threadSpinLastIntervalMsec = thread->threadSpinLastIntervalUsec / 1000;
+
+			if (PACED == TRUE) {
+				__HCTThreadHistogramAdd(
+					&thread->paceJitter,
+					SPIN_START - min(SPIN_START, thread->paceDeadlineUsec)
+				);
+			}
+		}
+		LAST_SPIN_START = SPIN_START;
+
+		CTArenaReset(thread->threadFrameArena);
 
 		thread->threadProc(
 			CT_THREADPROC_REASON_SPIN,
@@ -72,24 +297,16 @@ static DWORD __HCTThreadProc(P__CTThreadInput threadInput) {
 		);
 		thread->threadSpinCount++;
 
-		PCTIterator taskIter		= CTIteratorCreate(thread->threadTaskQueue);
-		P__CTThreadTaskData task	= NULL;
-		while ((task = CTIteratorIterate(taskIter)) != NULL) {
-			task->taskFunc(
-				thread,
-				thread->threadData,
-				task->userInput
-			);
-
-			if (task->taskCompleteMsg != NULL)
-				SetEvent(task->taskCompleteMsg);
-		}
-
-		CTIteratorDestroy(&taskIter);
-		CTDynListClear(thread->threadTaskQueue);
+		__HCTThreadRunTasks(thread);
 
 		if (thread->killSignal == TRUE) {
 
+			while (thread->taskProducerCount != 0) {
+				__HCTThreadRunTasks(thread);
+				SwitchToThread();
+			}
+			__HCTThreadRunTasks(thread);
+
 			thread->threadProc(
 				CT_THREADPROC_REASON_EXIT,
 				thread,
@@ -97,37 +314,41 @@ static DWORD __HCTThreadProc(P__CTThreadInput threadInput) {
 				NULL
 			);
 
-			CTDynListDestroy(&thread->threadTaskQueue);
+			if (thread->paceTimer != NULL)
+				CloseHandle(thread->paceTimer);
+
+			CTQueueDestroy(&thread->threadTaskQueue);
+			CTArenaDestroy(&thread->threadFrameArena);
 			CTLockDestroy(&thread->threadLock);
 			CTFree(thread->threadData);
 			CTFree(thread);
 			CTFree(threadInput);
+			CTAllocThreadCacheFlush();
+			CTEpochThreadRelease();
 
 			ExitThread(ERROR_SUCCESS);
 
 		}
 
-		INT64 SPIN_END;
-		QueryPerformanceCounter(&SPIN_END);
-		SPIN_END /= CLOCK_FREQUENCY_MSEC;
+		UINT64 NEXT_DEADLINE = SPIN_START + SPIN_INTERVAL;
 
-		CTLockLeave(thread->threadLock);
-		
-		INT64 SLEEP_START;
-		QueryPerformanceCounter(&SLEEP_START);
-		SLEEP_START /= CLOCK_FREQUENCY_MSEC;
+		if (PACED == TRUE) {
+			UINT64 SPIN_END	= CTClockUsec();
+			NEXT_DEADLINE	= thread->paceDeadlineUsec + SPIN_INTERVAL;
 
-		INT64 SLEEP_TIME = max(0, thread->threadSpinIntervalMsec - (SPIN_END - SPIN_START));
-		Sleep(SLEEP_TIME);
+			if (SPIN_END >= NEXT_DEADLINE) {
+				UINT64 MISSED = (SPIN_END - NEXT_DEADLINE) / SPIN_INTERVAL + 1;
+				thread->paceMissCount	+= MISSED;
+				NEXT_DEADLINE			+= MISSED * SPIN_INTERVAL;
+			}
 
-		INT64 SLEEP_END;
-		QueryPerformanceCounter(&SLEEP_END);
-		SLEEP_END /= CLOCK_FREQUENCY_MSEC;
+			thread->paceDeadlineUsec = NEXT_DEADLINE;
+		}
 
-		CTLockEnter(thread->threadLock);
-		thread->threadSpinLastIntervalMsec = (SPIN_END - SPIN_START) + (SLEEP_END - SLEEP_START);
 		CTLockLeave(thread->threadLock);
 
+		__HCTThreadWaitUntil(thread, NEXT_DEADLINE);
+
 	}
 
 }
@@ -139,25 +360,74 @@ CTCALL	PCTThread	CTThreadCreate(
 	UINT64				spinIntervalMsec,
 	BOOL				blockUntilInitComplete
 ) {
+	return CTThreadCreateEx(
+		threadProc,
+		threadDataSizeBytes,
+		threadInitInput,
+		spinIntervalMsec * 1000,
+		0,
+		blockUntilInitComplete
+	);
+}
+
+CTCALL	PCTThread	CTThreadCreateEx(
+	PCTFUNCTHREADPROC	threadProc,
+	SIZE_T				threadDataSizeBytes,
+	PVOID				threadInitInput,
+	UINT64				spinIntervalUsec,
+	UINT32				threadFlags,
+	BOOL				blockUntilInitComplete
+) {
 
 	if (threadProc == NULL) {
 		CTErrorSetBadObject("CTThreadCreate failed: threadProc was NULL");
 		return NULL;
 	}
+	if ((threadFlags & CT_THREAD_FLAG_PACED) != 0 && spinIntervalUsec == 0) {
+		CTErrorSetParamValue("CTThreadCreate failed: paced thread needs a spin interval");
+		return NULL;
+	}
 
-	PCTThread thread	= CTAlloc(sizeof(*thread));
+	/// SUMMARY:
+	/// create thread object
+	/// if (paced)
+	///		create high resolution timer, falling back to a plain one
+	///		on systems which do not have them
+	/// start thread, wait for its init if asked to
+
+	PCTThread thread	= CTAllocEx(sizeof(*thread), CT_MEMORY_TAG_BASE, TRUE);
 	thread->killSignal	= FALSE;
-	thread->threadData	= CTAlloc(min(4, threadDataSizeBytes));
+	thread->threadData	= CTAllocEx(max(4, threadDataSizeBytes), CT_MEMORY_TAG_BASE, TRUE);
 	thread->threadLock	= CTLockCreate();
 	thread->threadProc	= threadProc;
+	thread->threadFlags				= threadFlags;
 	thread->threadSpinCount			= 0;
-	thread->threadSpinIntervalMsec	= spinIntervalMsec;
-	thread->threadTaskQueue			= CTDynListCreate(
+	thread->threadSpinIntervalUsec	= spinIntervalUsec;
+	thread->threadSpinIntervalMsec	= spinIntervalUsec / 1000;
+	thread->threadTaskQueue			= CTQueueCreate(
 		sizeof(__CTThreadTaskData), 
-		CT_THREAD_TASK_QUEUE_NODE_SIZE
+		CT_THREAD_TASK_QUEUE_CAPACITY
 	);
+	thread->threadFrameArena		= CTArenaCreate(CT_ARENA_BLOCK_SIZE_DEFAULT);
+
+	if ((threadFlags & CT_THREAD_FLAG_PACED) != 0) {
+		thread->paceTimer = CreateWaitableTimerExW(
+			NULL,
+			NULL,
+			CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+			TIMER_ALL_ACCESS
+		);
+		if (thread->paceTimer == NULL) {
+			thread->paceTimer = CreateWaitableTimerExW(
+				NULL,
+				NULL,
+				0,
+				TIMER_ALL_ACCESS
+			);
+		}
+	}
 
-	P__CTThreadInput threadInput	= CTAlloc(sizeof(*threadInput));
+	P__CTThreadInput threadInput	= CTAllocEx(sizeof(*threadInput), CT_MEMORY_TAG_BASE, TRUE);
 	threadInput->thread				= thread;
 	threadInput->initUserInput		= threadInitInput;
 	threadInput->initCompleteMsg	= CreateEventA(
@@ -209,15 +479,52 @@ CTCALL	BOOL		CTThreadDestroy(PCTThread* pThread) {
 		return FALSE;
 	}
 
-	thread->killSignal = TRUE;
+	/// the thread frees itself once it sees killsignal, so everything
+	/// which touches it happens before the lock is released
+	HANDLE hThread		= thread->hThread;
+	thread->killSignal	= TRUE;
+	__HCTThreadWake(thread);
 	CTLockLeave(thread->threadLock);
 
-	WaitForSingleObject(thread->hThread, INFINITE);
+	WaitForSingleObject(hThread, INFINITE);
 
 	*pThread = NULL;
 	return TRUE;
 }
 
+static BOOL __HCTThreadEnqueue(PCTThread thread, PCTFUNCTHREADTASK pfTask, PVOID userInput, PCTFuture future) {
+
+	/// SUMMARY:
+	/// register as producer, then check killsignal
+	/// (the exiting thread waits for producers to leave before its last drain)
+	/// stamp and enqueue task (queue grows instead of waiting on the thread,
+	/// so a thread may queue tasks on itself)
+	/// wake thread if it is waiting between spins (unless asked not to)
+	/// unregister as producer (only after the wake, an exiting thread frees
+	/// itself once no producers are left)
+
+	InterlockedIncrement(&thread->taskProducerCount);
+	if (thread->killSignal == TRUE) {
+		InterlockedDecrement(&thread->taskProducerCount);
+		return FALSE;
+	}
+
+	__CTThreadTaskData task;
+	task.userInput	= userInput;
+	task.taskFunc	= pfTask;
+	task.future		= future;
+	task.submitTick	= CTClockTicks();
+
+	CTQueueEnqueue(thread->threadTaskQueue, &task);
+
+	if ((thread->threadFlags & CT_THREAD_FLAG_TASK_NO_WAKE) == 0)
+		__HCTThreadWake(thread);
+
+	InterlockedDecrement(&thread->taskProducerCount);
+
+	return TRUE;
+}
+
 CTCALL	BOOL		CTThreadTask(PCTThread thread, PCTFUNCTHREADTASK pfTask, PVOID userInput, BOOL sync) {
 	if (thread == NULL) {
 		CTErrorSetBadObject("CTThreadTask failed: thread was NULL");
@@ -228,34 +535,97 @@ CTCALL	BOOL		CTThreadTask(PCTThread thread, PCTFUNCTHREADTASK pfTask, PVOID user
 		return FALSE;
 	}
 
-	CTLockEnter(thread->threadLock);
-	if (thread->killSignal == TRUE) {
+	/// SUMMARY:
+	/// if (not sync)
+	///		enqueue task without a future
+	/// else
+	///		enqueue task with a future
+	///		wait for future, release it
+
+	if (sync == FALSE) {
+		if (__HCTThreadEnqueue(thread, pfTask, userInput, NULL) == FALSE) {
+			CTErrorSetFunction("CTThreadTask failed: thread is being destroyed");
+			return FALSE;
+		}
+		return TRUE;
+	}
+
+	PCTFuture future = CTThreadTaskAsync(thread, pfTask, userInput);
+	if (future == NULL) {
 		CTErrorSetFunction("CTThreadTask failed: thread is being destroyed");
-		CTLockLeave(thread->threadLock);
 		return FALSE;
 	}
 
-	CTDynListLock(thread->threadTaskQueue);
+	CTFutureWait(future, NULL);
+	CTFutureRelease(&future);
+
+	return TRUE;
+}
 
-	P__CTThreadTaskData task = CTDynListAdd(thread->threadTaskQueue);
-	task->userInput			= userInput;
-	task->taskFunc			= pfTask;
-	task->taskCompleteMsg	= NULL;
+CTCALL	PCTFuture	CTThreadTaskAsync(PCTThread thread, PCTFUNCTHREADTASK pfTask, PVOID userInput) {
+	if (thread == NULL) {
+		CTErrorSetBadObject("CTThreadTaskAsync failed: thread was NULL");
+		return NULL;
+	}
+	if (pfTask == NULL) {
+		CTErrorSetBadObject("CTThreadTaskAsync failed: pfTask was NULL");
+		return NULL;
+	}
 
-	HANDLE completeEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
-	if (sync == TRUE) {
-		task->taskCompleteMsg = completeEvent;
+	/// SUMMARY:
+	/// create future, the queued task holds a second reference
+	/// enqueue task
+	/// if (thread is being destroyed)
+	///		drop both references, raise error
+
+	PCTFuture future = CTFutureCreate();
+	CTFutureRetain(future);
+
+	if (__HCTThreadEnqueue(thread, pfTask, userInput, future) == FALSE) {
+		PCTFuture taskFuture = future;
+		CTFutureRelease(&taskFuture);
+		CTFutureRelease(&future);
+		CTErrorSetFunction("CTThreadTaskAsync failed: thread is being destroyed");
 	}
 
-	CTDynListUnlock(thread->threadTaskQueue);
+	return future;
+}
+
+CTCALL	BOOL		CTThreadTaskLatency(PCTThread thread, PCTThreadLatencyStats statsOut, BOOL reset) {
+	if (thread == NULL) {
+		CTErrorSetBadObject("CTThreadTaskLatency failed: thread was NULL");
+		return FALSE;
+	}
+	if (statsOut == NULL) {
+		CTErrorSetParamValue("CTThreadTaskLatency failed: statsOut was NULL");
+		return FALSE;
+	}
+
+	/// tasks only run while the thread holds its lock
+	CTLockEnter(thread->threadLock);
+	__HCTThreadHistogramRead(&thread->taskLatency, statsOut, reset);
 	CTLockLeave(thread->threadLock);
 
-	if (sync == TRUE) {
-		puts("waiting for sync object");
-		WaitForSingleObject(completeEvent, INFINITE);
+	return TRUE;
+}
+
+CTCALL	BOOL		CTThreadPaceJitter(PCTThread thread, PCTThreadLatencyStats statsOut, BOOL reset) {
+	if (thread == NULL) {
+		CTErrorSetBadObject("CTThreadPaceJitter failed: thread was NULL");
+		return FALSE;
+	}
+	if (statsOut == NULL) {
+		CTErrorSetParamValue("CTThreadPaceJitter failed: statsOut was NULL");
+		return FALSE;
+	}
+	if ((thread->threadFlags & CT_THREAD_FLAG_PACED) == 0) {
+		CTErrorSetFunction("CTThreadPaceJitter failed: thread is not paced");
+		return FALSE;
 	}
 
-	CloseHandle(completeEvent);
+	CTLockEnter(thread->threadLock);
+	__HCTThreadHistogramRead(&thread->paceJitter, statsOut, reset);
+	CTLockLeave(thread->threadLock);
 
 	return TRUE;
 }
@@ -11,6 +11,49 @@
 #ifndef _CT_THREAD_INCLUDE_
 #define _CT_THREAD_INCLUDE_ 
 
+//////////////////////////////////////////////////////////////////////////////
+///
+///								FUTURES
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// a future is completed once with a result pointer. waiters block on the
+/// state word itself (WaitOnAddress), so no kernel event is ever created, and
+/// released futures go back to a small pool. CTFutureThen sets the one
+/// continuation, which runs on the completing thread (or right away if the
+/// future is already complete). futures are reference counted: whoever
+/// creates or is handed one releases it with CTFutureRelease
+
+#define CT_FUTURE_STATE_PENDING		0
+#define CT_FUTURE_STATE_CHAINED		1
+#define CT_FUTURE_STATE_COMPLETE	2
+#define CT_FUTURE_POOL_MAX			0x100
+
+typedef void (*PCTFUNCFUTURETHEN)(
+	PVOID	future,
+	PVOID	result,
+	PVOID	input
+);
+
+typedef struct CTFuture {
+	volatile LONG		state;
+	volatile LONG		refCount;
+	PVOID				result;
+	PCTFUNCFUTURETHEN	thenFunc;
+	PVOID				thenInput;
+	PVOID				nextFree;
+} CTFuture, *PCTFuture;
+
+CTCALL	PCTFuture	CTFutureCreate(void);
+CTCALL	BOOL		CTFutureRetain(PCTFuture future);
+CTCALL	BOOL		CTFutureRelease(PCTFuture* pFuture);
+CTCALL	BOOL		CTFutureComplete(PCTFuture future, PVOID result);
+CTCALL	BOOL		CTFutureWait(PCTFuture future, PVOID* pResultOut);
+CTCALL	BOOL		CTFutureTryGet(PCTFuture future, PVOID* pResultOut);
+CTCALL	BOOL		CTFutureThen(PCTFuture future, PCTFUNCFUTURETHEN func, PVOID input);
+void	__CTFutureInit(void);
+void	__CTFutureCleanup(void);
+
 //////////////////////////////////////////////////////////////////////////////
 ///
 ///								THREAD HANDLING
@@ -33,19 +76,76 @@ typedef void (*PCTFUNCTHREADTASK)(
 	PVOID	input
 );
 
-#define CT_THREAD_TASK_QUEUE_NODE_SIZE	100
+/// tasks go through a lock-free queue, so CTThreadTask never waits on a
+/// spinning thread. taskProducerCount lets an exiting thread wait out
+/// producers which are mid-enqueue before it drains the queue a last time.
+/// CTThreadTaskAsync returns a future which completes with userInput once
+/// the task ran. between spins the thread waits on wakeSignal; every task
+/// submission raises it, so tasks run right away while the spin cadence
+/// stays put. the delay from submission to run is kept in a histogram of 8
+/// buckets per power of two microseconds, CTThreadTaskLatency reads p50/p99
+/// from it (rounded up to the bucket's upper edge). threads created with
+/// CT_THREAD_FLAG_TASK_NO_WAKE leave wakeSignal alone on submission, so
+/// tasks wait for the end of the next spin as they did before wakeups;
+/// this is kept to measure the difference against
+///
+/// threads created with CT_THREAD_FLAG_PACED start every spin on an absolute
+/// deadline, one interval after the last deadline, so time lost to a late
+/// wake does not add up over frames. the wait between spins is a wait on
+/// wakeSignal which ends early by the oversleep measured so far, a high
+/// resolution timer wait and a spin of CT_THREAD_PACE_SPIN_USEC at the end.
+/// a spin which runs past whole intervals drops those deadlines and counts
+/// them in paceMissCount. how late every spin started is kept like task
+/// latency and read with CTThreadPaceJitter
+
+#define CT_THREAD_HISTOGRAM_BUCKETS		0x100
+
+#define CT_THREAD_FLAG_PACED			0x01
+#define CT_THREAD_FLAG_TASK_NO_WAKE		0x02
+#define CT_THREAD_PACE_SPIN_USEC		0x200
+#define CT_THREAD_PACE_LEAD_MIN_USEC	0x400
+#define CT_THREAD_PACE_LEAD_MAX_USEC	0x2000
+
+#define CT_THREAD_TASK_QUEUE_CAPACITY	0x100
+#define CT_THREAD_TASK_BATCH_SIZE		0x20
+
+typedef struct CTThreadHistogram {
+	UINT64	sampleCount;
+	UINT64	maxUsec;
+	UINT32	buckets	[CT_THREAD_HISTOGRAM_BUCKETS];
+} CTThreadHistogram, *PCTThreadHistogram;
+
 typedef struct CTThread {
 	HANDLE				hThread;
 	PCTLock				threadLock;
 	PVOID				threadData;
 	PCTFUNCTHREADPROC	threadProc;
+	UINT32				threadFlags;
 	UINT64				threadSpinCount;
 	INT64				threadSpinIntervalMsec;
 	INT64				threadSpinLastIntervalMsec;
-	PCTDynList			threadTaskQueue;
+	INT64				threadSpinIntervalUsec;
+	INT64				threadSpinLastIntervalUsec;
+	PCTQueue			threadTaskQueue;
+	volatile LONG		taskProducerCount;
+	volatile LONG		wakeSignal;
+	CTThreadHistogram	taskLatency;
+	HANDLE				paceTimer;
+	UINT64				paceDeadlineUsec;
+	UINT64				paceOversleepUsec;
+	UINT64				paceMissCount;
+	CTThreadHistogram	paceJitter;
+	PCTArena			threadFrameArena;
 	BOOL				killSignal;
 } CTThread, *PCTThread;
 
+typedef struct CTThreadLatencyStats {
+	UINT64	sampleCount;
+	UINT64	p50Usec;
+	UINT64	p99Usec;
+	UINT64	maxUsec;
+} CTThreadLatencyStats, *PCTThreadLatencyStats;
+
 CTCALL	PCTThread	CTThreadCreate(
 	PCTFUNCTHREADPROC	threadProc,
 	SIZE_T				threadDataSizeBytes,
@@ -53,9 +153,70 @@ CTCALL	PCTThread	CTThreadCreate(
 	UINT64				spinIntervalMsec,
 	BOOL				blockUntilInitComplete
 );
+CTCALL	PCTThread	CTThreadCreateEx(
+	PCTFUNCTHREADPROC	threadProc,
+	SIZE_T				threadDataSizeBytes,
+	PVOID				threadInitInput,
+	UINT64				spinIntervalUsec,
+	UINT32				threadFlags,
+	BOOL				blockUntilInitComplete
+);
 CTCALL	BOOL		CTThreadDestroy(PCTThread* pThread);
 CTCALL	BOOL		CTThreadTask(PCTThread thread, PCTFUNCTHREADTASK pfTask, PVOID userInput, BOOL sync);
+CTCALL	PCTFuture	CTThreadTaskAsync(PCTThread thread, PCTFUNCTHREADTASK pfTask, PVOID userInput);
+CTCALL	BOOL		CTThreadTaskLatency(PCTThread thread, PCTThreadLatencyStats statsOut, BOOL reset);
+CTCALL	BOOL		CTThreadPaceJitter(PCTThread thread, PCTThreadLatencyStats statsOut, BOOL reset);
 CTCALL	BOOL		CTThreadLock(PCTThread thread);
 CTCALL	BOOL		CTThreadUnlock(PCTThread thread);
 
+//////////////////////////////////////////////////////////////////////////////
+///
+///								THREAD POOL
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+/// every pool worker owns a Chase-Lev deque: it pushes and pops its own
+/// tasks at the bottom while idle workers steal from the top of others.
+/// tasks submitted from outside the pool go into a shared deque which only
+/// takes a lock on push. workers which find nothing spin briefly and then
+/// sleep until new work is submitted. a full deque runs the task inline
+///
+/// a CTTaskGroup lives on the caller's stack and counts its unfinished
+/// tasks; CTTaskGroupWait runs and steals pool tasks until the count is 0, so
+/// it is safe to wait from inside a pool task. CTParallelFor cuts
+/// [begin, end) into ranges of grain indices and runs them on the default
+/// pool, which CogThornInit creates with one worker per hardware thread
+
+#define CT_THREADPOOL_WORKERS_MAX		0x40
+#define CT_THREADPOOL_DEQUE_CAPACITY	0x1000
+#define CT_THREADPOOL_SPIN_COUNT		0x400
+#define CT_PARALLEL_FOR_GRAIN_DEFAULT	0x40
+
+typedef void (*PCTFUNCPOOLTASK)(PVOID input);
+typedef void (*PCTFUNCPARALLELFOR)(INT64 indexBegin, INT64 indexEnd, PVOID input);
+
+typedef struct CTThreadPool {
+	UINT32			workerCount;
+	PVOID			workers;
+	PVOID			sharedDeque;
+	PCTLock			sharedLock;
+	HANDLE			wakeSignal;
+	volatile LONG	sleeperCount;
+	volatile LONG	killSignal;
+} CTThreadPool, *PCTThreadPool;
+
+typedef struct CTTaskGroup {
+	PCTThreadPool	pool;
+	volatile LONG	pendingCount;
+} CTTaskGroup, *PCTTaskGroup;
+
+CTCALL	PCTThreadPool	CTThreadPoolCreate(UINT32 workerCount);
+CTCALL	BOOL			CTThreadPoolDestroy(PCTThreadPool* pPool);
+CTCALL	PCTThreadPool	CTThreadPoolDefault(void);
+CTCALL	BOOL			CTThreadPoolSubmit(PCTThreadPool pool, PCTFUNCPOOLTASK func, PVOID input);
+CTCALL	BOOL			CTTaskGroupBegin(PCTThreadPool pool, PCTTaskGroup group);
+CTCALL	BOOL			CTTaskGroupSpawn(PCTTaskGroup group, PCTFUNCPOOLTASK func, PVOID input);
+CTCALL	BOOL			CTTaskGroupWait(PCTTaskGroup group);
+CTCALL	BOOL			CTParallelFor(INT64 begin, INT64 end, INT64 grain, PCTFUNCPARALLELFOR func, PVOID input);
+
 #endif
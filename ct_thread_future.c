@@ -0,0 +1,231 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_thread_future.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_data.h"
+#include "ct_base.h"
+#include "ct_thread.h"
+
+CTCALL	PCTFuture	CTFutureCreate(void) {
+
+	/// SUMMARY:
+	/// ENTER LOCK
+	/// pop future off pool if there is one
+	/// LEAVE LOCK
+	/// else allocate new future
+	/// reset future to pending with one reference
+
+	EnterCriticalSection(&__ctdata.threading.futureLock);
+
+	PCTFuture future = __ctdata.threading.futureFreeList;
+	if (future != NULL) {
+		__ctdata.threading.futureFreeList = future->nextFree;
+		__ctdata.threading.futureFreeCount -= 1;
+	}
+
+	LeaveCriticalSection(&__ctdata.threading.futureLock);
+
+	if (future == NULL)
+		future = CTAllocEx(sizeof(*future), CT_MEMORY_TAG_BASE, FALSE);
+
+	future->state		= CT_FUTURE_STATE_PENDING;
+	future->refCount	= 1;
+	future->result		= NULL;
+	future->thenFunc	= NULL;
+	future->thenInput	= NULL;
+	future->nextFree	= NULL;
+
+	return future;
+}
+
+CTCALL	BOOL		CTFutureRetain(PCTFuture future) {
+	if (future == NULL) {
+		CTErrorSetBadObject("CTFutureRetain failed: future was NULL");
+		return FALSE;
+	}
+
+	InterlockedIncrement(&future->refCount);
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTFutureRelease(PCTFuture* pFuture) {
+	if (pFuture == NULL) {
+		CTErrorSetBadObject("CTFutureRelease failed: pFuture was NULL");
+		return FALSE;
+	}
+
+	PCTFuture future = *pFuture;
+
+	if (future == NULL) {
+		CTErrorSetBadObject("CTFutureRelease failed: future was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// if (last reference was dropped)
+	///		ENTER LOCK
+	///		push future onto pool unless pool is full
+	///		LEAVE LOCK
+	///		else free future
+
+	*pFuture = NULL;
+
+	if (InterlockedDecrement(&future->refCount) != 0)
+		return TRUE;
+
+	EnterCriticalSection(&__ctdata.threading.futureLock);
+
+	if (__ctdata.threading.futureFreeCount < CT_FUTURE_POOL_MAX) {
+		future->nextFree					= __ctdata.threading.futureFreeList;
+		__ctdata.threading.futureFreeList	= future;
+		__ctdata.threading.futureFreeCount	+= 1;
+		future								= NULL;
+	}
+
+	LeaveCriticalSection(&__ctdata.threading.futureLock);
+
+	if (future != NULL)
+		CTFree(future);
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTFutureComplete(PCTFuture future, PVOID result) {
+	if (future == NULL) {
+		CTErrorSetBadObject("CTFutureComplete failed: future was NULL");
+		return FALSE;
+	}
+	if (future->state == CT_FUTURE_STATE_COMPLETE) {
+		CTErrorSetFunction("CTFutureComplete failed: future was already complete");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// store result, then swap state to complete (interlocked, so the result
+	/// is visible before the state is)
+	/// wake every waiter blocked on state
+	/// if (a continuation was chained before completion)
+	///		run continuation
+
+	future->result = result;
+
+	LONG prevState = InterlockedExchange(&future->state, CT_FUTURE_STATE_COMPLETE);
+	WakeByAddressAll((PVOID)&future->state);
+
+	if (prevState == CT_FUTURE_STATE_CHAINED) {
+		future->thenFunc(
+			future,
+			result,
+			future->thenInput
+		);
+	}
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTFutureWait(PCTFuture future, PVOID* pResultOut) {
+	if (future == NULL) {
+		CTErrorSetBadObject("CTFutureWait failed: future was NULL");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// while (future is not complete)
+	///		block until state word changes from the value last seen
+
+	LONG state = future->state;
+	while (state != CT_FUTURE_STATE_COMPLETE) {
+		WaitOnAddress(
+			&future->state,
+			&state,
+			sizeof(state),
+			INFINITE
+		);
+		state = future->state;
+	}
+
+	if (pResultOut != NULL)
+		*pResultOut = future->result;
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTFutureTryGet(PCTFuture future, PVOID* pResultOut) {
+	if (future == NULL) {
+		CTErrorSetBadObject("CTFutureTryGet failed: future was NULL");
+		return FALSE;
+	}
+
+	/// not being complete yet is expected here, so no error is raised
+
+	if (future->state != CT_FUTURE_STATE_COMPLETE)
+		return FALSE;
+
+	if (pResultOut != NULL)
+		*pResultOut = future->result;
+
+	return TRUE;
+}
+
+CTCALL	BOOL		CTFutureThen(PCTFuture future, PCTFUNCFUTURETHEN func, PVOID input) {
+	if (future == NULL) {
+		CTErrorSetBadObject("CTFutureThen failed: future was NULL");
+		return FALSE;
+	}
+	if (func == NULL) {
+		CTErrorSetParamValue("CTFutureThen failed: func was NULL");
+		return FALSE;
+	}
+	if (future->state == CT_FUTURE_STATE_CHAINED || future->thenFunc != NULL) {
+		CTErrorSetFunction("CTFutureThen failed: future already has a continuation");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// store continuation, then try to swap state from pending to chained
+	/// if (future completed first)
+	///		completer did not see the continuation, run it right here
+
+	future->thenFunc	= func;
+	future->thenInput	= input;
+
+	LONG prevState = InterlockedCompareExchange(
+		&future->state,
+		CT_FUTURE_STATE_CHAINED,
+		CT_FUTURE_STATE_PENDING
+	);
+
+	if (prevState == CT_FUTURE_STATE_COMPLETE) {
+		func(
+			future,
+			future->result,
+			input
+		);
+	}
+
+	return TRUE;
+}
+
+void	__CTFutureInit(void) {
+	InitializeCriticalSection(&__ctdata.threading.futureLock);
+	__ctdata.threading.futureFreeList	= NULL;
+	__ctdata.threading.futureFreeCount	= 0;
+}
+
+void	__CTFutureCleanup(void) {
+	PCTFuture future = __ctdata.threading.futureFreeList;
+	while (future != NULL) {
+		PCTFuture nextFuture = future->nextFree;
+		CTFree(future);
+		future = nextFuture;
+	}
+
+	__ctdata.threading.futureFreeList	= NULL;
+	__ctdata.threading.futureFreeCount	= 0;
+	DeleteCriticalSection(&__ctdata.threading.futureLock);
+}
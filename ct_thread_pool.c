@@ -0,0 +1,534 @@
+//////////////////////////////////////////////////////////////////////////////
+///	
+/// 							<ct_thread_pool.c>
+///								Bailey JT Brown
+///								2023
+/// 
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ct_data.h"
+#include "ct_base.h"
+#include "ct_thread.h"
+
+typedef struct __CTPoolTask {
+	PCTFUNCPOOLTASK	func;
+	PVOID			input;
+	PCTTaskGroup	group;
+} __CTPoolTask, *P__CTPoolTask;
+
+typedef struct __CTTaskDeque {
+	volatile LONG64		top;
+	BYTE				padTop		[CT_QUEUE_CACHE_LINE_SIZE - sizeof(LONG64)];
+	volatile LONG64		bottom;
+	BYTE				padBottom	[CT_QUEUE_CACHE_LINE_SIZE - sizeof(LONG64)];
+	P__CTPoolTask*		tasks;
+} __CTTaskDeque, *P__CTTaskDeque;
+
+typedef struct __CTPoolWorker {
+	__CTTaskDeque	deque;
+	PCTThreadPool	pool;
+	HANDLE			thread;
+	UINT32			workerIndex;
+	UINT32			stealSeed;
+} __CTPoolWorker, *P__CTPoolWorker;
+
+typedef struct __CTParallelForJob {
+	PCTFUNCPARALLELFOR	func;
+	PVOID				input;
+	INT64				end;
+	INT64				grain;
+	volatile LONG64		next;
+} __CTParallelForJob, *P__CTParallelForJob;
+
+#define __CT_THREADPOOL_DEQUE_MASK	(CT_THREADPOOL_DEQUE_CAPACITY - 1)
+
+static __declspec(thread) P__CTPoolWorker __ctPoolWorker = NULL;
+
+static BOOL __HCTDequePush(P__CTTaskDeque deque, P__CTPoolTask task) {
+
+	/// SUMMARY:
+	/// (only the owner pushes)
+	/// if (deque is full)
+	///		fail
+	/// write task at bottom, then publish it by moving bottom up
+	/// (interlocked store, so task is visible before bottom is)
+
+	LONG64 bottom	= deque->bottom;
+	LONG64 top		= deque->top;
+
+	if (bottom - top >= CT_THREADPOOL_DEQUE_CAPACITY)
+		return FALSE;
+
+	deque->tasks[bottom & __CT_THREADPOOL_DEQUE_MASK] = task;
+	InterlockedExchange64(&deque->bottom, bottom + 1);
+
+	return TRUE;
+}
+
+static P__CTPoolTask __HCTDequePop(P__CTTaskDeque deque) {
+
+	/// SUMMARY:
+	/// (only the owner pops)
+	/// reserve bottom task by moving bottom down (full fence before reading top)
+	/// if (deque was empty)
+	///		restore bottom, return nothing
+	/// if (task is the last one)
+	///		race thieves for it by moving top up, restore bottom
+	/// return task
+
+	LONG64 bottom = deque->bottom - 1;
+	InterlockedExchange64(&deque->bottom, bottom);
+	LONG64 top = deque->top;
+
+	if (top > bottom) {
+		deque->bottom = bottom + 1;
+		return NULL;
+	}
+
+	P__CTPoolTask task = deque->tasks[bottom & __CT_THREADPOOL_DEQUE_MASK];
+
+	if (top == bottom) {
+		if (InterlockedCompareExchange64(&deque->top, top + 1, top) != top)
+			task = NULL;
+		deque->bottom = bottom + 1;
+	}
+
+	return task;
+}
+
+static P__CTPoolTask __HCTDequeSteal(P__CTTaskDeque deque) {
+
+	/// SUMMARY:
+	/// read top, then bottom
+	/// if (deque is empty)
+	///		return nothing
+	/// read top task and claim it by moving top up
+	/// if (another thief or the owner got there first)
+	///		return nothing, caller moves on to another deque
+
+	LONG64 top		= deque->top;
+	LONG64 bottom	= deque->bottom;
+
+	if (top >= bottom)
+		return NULL;
+
+	P__CTPoolTask task = deque->tasks[top & __CT_THREADPOOL_DEQUE_MASK];
+
+	if (InterlockedCompareExchange64(&deque->top, top + 1, top) != top)
+		return NULL;
+
+	return task;
+}
+
+static P__CTPoolWorker __HCTPoolSelf(PCTThreadPool pool) {
+	P__CTPoolWorker worker = __ctPoolWorker;
+	return (worker != NULL && worker->pool == pool) ? worker : NULL;
+}
+
+static P__CTPoolTask __HCTPoolFindTask(PCTThreadPool pool, P__CTPoolWorker self) {
+
+	/// SUMMARY:
+	/// if (caller is a worker of pool)
+	///		pop own deque
+	/// steal from shared deque
+	/// steal from every other worker, starting at a random one
+
+	P__CTPoolTask task = NULL;
+
+	if (self != NULL && (task = __HCTDequePop(&self->deque)) != NULL)
+		return task;
+
+	if ((task = __HCTDequeSteal(pool->sharedDeque)) != NULL)
+		return task;
+
+	P__CTPoolWorker	workers		= pool->workers;
+	UINT32			victimFirst	= 0;
+
+	if (self != NULL) {
+		self->stealSeed ^= self->stealSeed << 13;
+		self->stealSeed ^= self->stealSeed >> 17;
+		self->stealSeed ^= self->stealSeed << 5;
+		victimFirst		= self->stealSeed % pool->workerCount;
+	}
+
+	for (UINT32 victimOffset = 0; victimOffset < pool->workerCount; victimOffset++) {
+		P__CTPoolWorker victim = workers + ((victimFirst + victimOffset) % pool->workerCount);
+		if (victim == self) continue;
+
+		if ((task = __HCTDequeSteal(&victim->deque)) != NULL)
+			return task;
+	}
+
+	return NULL;
+}
+
+static void __HCTPoolRunTask(P__CTPoolTask task) {
+	PCTTaskGroup group = task->group;
+
+	task->func(task->input);
+	CTFree(task);
+
+	if (group != NULL)
+		InterlockedDecrement(&group->pendingCount);
+}
+
+static void __HCTPoolPush(PCTThreadPool pool, PCTFUNCPOOLTASK func, PVOID input, PCTTaskGroup group) {
+
+	/// SUMMARY:
+	/// count task against its group
+	/// if (caller is a worker of pool)
+	///		push onto own deque
+	/// else
+	///		push onto shared deque under shared lock
+	/// if (deque was full)
+	///		run task right here
+	/// else if (any worker is asleep)
+	///		wake one
+
+	if (group != NULL)
+		InterlockedIncrement(&group->pendingCount);
+
+	P__CTPoolTask task	= CTAllocEx(sizeof(*task), CT_MEMORY_TAG_BASE, FALSE);
+	task->func			= func;
+	task->input			= input;
+	task->group			= group;
+
+	P__CTPoolWorker	self	= __HCTPoolSelf(pool);
+	BOOL			pushed	= FALSE;
+
+	if (self != NULL) {
+		pushed = __HCTDequePush(&self->deque, task);
+	} else {
+		CTLockEnter(pool->sharedLock);
+		pushed = __HCTDequePush(pool->sharedDeque, task);
+		CTLockLeave(pool->sharedLock);
+	}
+
+	if (pushed == FALSE) {
+		__HCTPoolRunTask(task);
+		return;
+	}
+
+	if (pool->sleeperCount > 0)
+		ReleaseSemaphore(pool->wakeSignal, 1, NULL);
+}
+
+static DWORD __HCTPoolWorkerProc(P__CTPoolWorker worker) {
+
+	/// SUMMARY:
+	/// bind worker to this thread
+	/// while (pool is not being destroyed):
+	///		find task and run it
+	///		if (nothing was found for a while)
+	///			register as sleeper, look once more (a push may have missed
+	///			the registration), then sleep until woken
+	/// run whatever is left in own deque
+
+	__ctPoolWorker = worker;
+
+	PCTThreadPool	pool		= worker->pool;
+	UINT32			idleSpins	= 0;
+
+	while (pool->killSignal == FALSE) {
+
+		P__CTPoolTask task = __HCTPoolFindTask(pool, worker);
+
+		if (task != NULL) {
+			__HCTPoolRunTask(task);
+			idleSpins = 0;
+			continue;
+		}
+
+		if (++idleSpins < CT_THREADPOOL_SPIN_COUNT) {
+			YieldProcessor();
+			continue;
+		}
+
+		InterlockedIncrement(&pool->sleeperCount);
+
+		task = __HCTPoolFindTask(pool, worker);
+		if (task == NULL && pool->killSignal == FALSE)
+			WaitForSingleObject(pool->wakeSignal, INFINITE);
+
+		InterlockedDecrement(&pool->sleeperCount);
+
+		if (task != NULL)
+			__HCTPoolRunTask(task);
+
+		idleSpins = 0;
+	}
+
+	P__CTPoolTask task = NULL;
+	while ((task = __HCTDequePop(&worker->deque)) != NULL) {
+		__HCTPoolRunTask(task);
+	}
+
+	__ctPoolWorker = NULL;
+	CTAllocThreadCacheFlush();
+	CTEpochThreadRelease();
+
+	return ERROR_SUCCESS;
+}
+
+static void __HCTParallelForRun(P__CTParallelForJob job) {
+
+	/// SUMMARY:
+	/// while (ranges are left):
+	///		claim next range of grain indices and run func on it
+
+	while (TRUE) {
+		INT64 rangeBegin = InterlockedExchangeAdd64(&job->next, job->grain);
+		if (rangeBegin >= job->end) return;
+
+		job->func(
+			rangeBegin,
+			min(rangeBegin + job->grain, job->end),
+			job->input
+		);
+	}
+}
+
+CTCALL	PCTThreadPool	CTThreadPoolCreate(UINT32 workerCount) {
+
+	/// SUMMARY:
+	/// if (worker count is 0)
+	///		use one worker per hardware thread
+	/// create shared deque, shared lock and wake semaphore
+	/// create every worker's deque, then start all worker threads
+
+	if (workerCount == 0) {
+		SYSTEM_INFO sysInfo;
+		GetSystemInfo(&sysInfo);
+		workerCount = sysInfo.dwNumberOfProcessors;
+	}
+	workerCount = max(1, min(workerCount, CT_THREADPOOL_WORKERS_MAX));
+
+	PCTThreadPool pool		= CTAllocEx(sizeof(*pool), CT_MEMORY_TAG_BASE, TRUE);
+	pool->workerCount		= workerCount;
+	pool->sharedLock		= CTLockCreate();
+	pool->wakeSignal		= CreateSemaphoreA(NULL, 0, CT_THREADPOOL_WORKERS_MAX, NULL);
+
+	P__CTTaskDeque sharedDeque	= CTAllocEx(sizeof(*sharedDeque), CT_MEMORY_TAG_BASE, TRUE);
+	sharedDeque->tasks			= CTAllocEx(CT_THREADPOOL_DEQUE_CAPACITY * sizeof(*sharedDeque->tasks), CT_MEMORY_TAG_BASE, FALSE);
+	pool->sharedDeque			= sharedDeque;
+
+	P__CTPoolWorker workers = CTAllocEx(workerCount * sizeof(*workers), CT_MEMORY_TAG_BASE, TRUE);
+	pool->workers			= workers;
+
+	for (UINT32 workerIndex = 0; workerIndex < workerCount; workerIndex++) {
+		workers[workerIndex].pool			= pool;
+		workers[workerIndex].workerIndex	= workerIndex;
+		workers[workerIndex].stealSeed		= (0x9E3779B9 ^ (workerIndex * 0x85EBCA6B)) | 1;
+		workers[workerIndex].deque.tasks	= CTAllocEx(
+			CT_THREADPOOL_DEQUE_CAPACITY * sizeof(*workers[workerIndex].deque.tasks),
+			CT_MEMORY_TAG_BASE,
+			FALSE
+		);
+	}
+
+	for (UINT32 workerIndex = 0; workerIndex < workerCount; workerIndex++) {
+		workers[workerIndex].thread = CreateThread(
+			NULL,
+			NULL,
+			__HCTPoolWorkerProc,
+			workers + workerIndex,
+			NULL,
+			NULL
+		);
+	}
+
+	return pool;
+}
+
+CTCALL	BOOL			CTThreadPoolDestroy(PCTThreadPool* pPool) {
+	if (pPool == NULL) {
+		CTErrorSetBadObject("CTThreadPoolDestroy failed: pPool was NULL");
+		return FALSE;
+	}
+
+	PCTThreadPool pool = *pPool;
+
+	if (pool == NULL) {
+		CTErrorSetBadObject("CTThreadPoolDestroy failed: pool was NULL");
+		return FALSE;
+	}
+	if (__HCTPoolSelf(pool) != NULL) {
+		CTErrorSetFunction("CTThreadPoolDestroy failed: pool can not be destroyed by its own worker");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// signal kill and wake every worker, wait for all of them to exit
+	/// run tasks still left in shared deque
+	/// free everything
+
+	InterlockedExchange(&pool->killSignal, TRUE);
+	ReleaseSemaphore(pool->wakeSignal, pool->workerCount, NULL);
+
+	P__CTPoolWorker workers = pool->workers;
+
+	for (UINT32 workerIndex = 0; workerIndex < pool->workerCount; workerIndex++) {
+		WaitForSingleObject(workers[workerIndex].thread, INFINITE);
+		CloseHandle(workers[workerIndex].thread);
+	}
+
+	P__CTTaskDeque	sharedDeque = pool->sharedDeque;
+	P__CTPoolTask	task		= NULL;
+	while ((task = __HCTDequeSteal(sharedDeque)) != NULL) {
+		__HCTPoolRunTask(task);
+	}
+
+	for (UINT32 workerIndex = 0; workerIndex < pool->workerCount; workerIndex++) {
+		CTFree(workers[workerIndex].deque.tasks);
+	}
+
+	CTFree(workers);
+	CTFree(sharedDeque->tasks);
+	CTFree(sharedDeque);
+	CTLockDestroy(&pool->sharedLock);
+	CloseHandle(pool->wakeSignal);
+	CTFree(pool);
+
+	*pPool = NULL;
+	return TRUE;
+}
+
+CTCALL	PCTThreadPool	CTThreadPoolDefault(void) {
+	return __ctdata.threading.pool;
+}
+
+CTCALL	BOOL			CTThreadPoolSubmit(PCTThreadPool pool, PCTFUNCPOOLTASK func, PVOID input) {
+	if (pool == NULL) {
+		CTErrorSetBadObject("CTThreadPoolSubmit failed: pool was NULL");
+		return FALSE;
+	}
+	if (func == NULL) {
+		CTErrorSetParamValue("CTThreadPoolSubmit failed: func was NULL");
+		return FALSE;
+	}
+	if (pool->killSignal == TRUE) {
+		CTErrorSetFunction("CTThreadPoolSubmit failed: pool is being destroyed");
+		return FALSE;
+	}
+
+	__HCTPoolPush(pool, func, input, NULL);
+
+	return TRUE;
+}
+
+CTCALL	BOOL			CTTaskGroupBegin(PCTThreadPool pool, PCTTaskGroup group) {
+	if (pool == NULL) {
+		CTErrorSetBadObject("CTTaskGroupBegin failed: pool was NULL");
+		return FALSE;
+	}
+	if (group == NULL) {
+		CTErrorSetBadObject("CTTaskGroupBegin failed: group was NULL");
+		return FALSE;
+	}
+
+	group->pool			= pool;
+	group->pendingCount	= 0;
+
+	return TRUE;
+}
+
+CTCALL	BOOL			CTTaskGroupSpawn(PCTTaskGroup group, PCTFUNCPOOLTASK func, PVOID input) {
+	if (group == NULL || group->pool == NULL) {
+		CTErrorSetBadObject("CTTaskGroupSpawn failed: group was NULL or not begun");
+		return FALSE;
+	}
+	if (func == NULL) {
+		CTErrorSetParamValue("CTTaskGroupSpawn failed: func was NULL");
+		return FALSE;
+	}
+	if (group->pool->killSignal == TRUE) {
+		CTErrorSetFunction("CTTaskGroupSpawn failed: pool is being destroyed");
+		return FALSE;
+	}
+
+	__HCTPoolPush(group->pool, func, input, group);
+
+	return TRUE;
+}
+
+CTCALL	BOOL			CTTaskGroupWait(PCTTaskGroup group) {
+	if (group == NULL || group->pool == NULL) {
+		CTErrorSetBadObject("CTTaskGroupWait failed: group was NULL or not begun");
+		return FALSE;
+	}
+
+	/// SUMMARY:
+	/// while (group has unfinished tasks):
+	///		find any pool task and run it
+	///		if (nothing was found)
+	///			pause, yield the processor after a while
+	///			(the rest of the group is running on other workers)
+
+	PCTThreadPool	pool		= group->pool;
+	P__CTPoolWorker	self		= __HCTPoolSelf(pool);
+	UINT32			idleSpins	= 0;
+
+	while (group->pendingCount > 0) {
+
+		P__CTPoolTask task = __HCTPoolFindTask(pool, self);
+
+		if (task != NULL) {
+			__HCTPoolRunTask(task);
+			idleSpins = 0;
+			continue;
+		}
+
+		if (++idleSpins < CT_THREADPOOL_SPIN_COUNT)
+			YieldProcessor();
+		else
+			SwitchToThread();
+	}
+
+	return TRUE;
+}
+
+CTCALL	BOOL			CTParallelFor(INT64 begin, INT64 end, INT64 grain, PCTFUNCPARALLELFOR func, PVOID input) {
+	if (func == NULL) {
+		CTErrorSetParamValue("CTParallelFor failed: func was NULL");
+		return FALSE;
+	}
+	if (end <= begin)
+		return TRUE;
+
+	/// SUMMARY:
+	/// cut range into pieces of grain indices, claimed through a shared counter
+	/// spawn one helper per worker (capped by piece count - 1) on default pool
+	/// claim pieces on this thread too, then wait for the helpers
+	/// (without a default pool everything runs on this thread)
+
+	if (grain <= 0)
+		grain = CT_PARALLEL_FOR_GRAIN_DEFAULT;
+
+	__CTParallelForJob job = { 0 };
+	job.func	= func;
+	job.input	= input;
+	job.end		= end;
+	job.grain	= grain;
+	job.next	= begin;
+
+	PCTThreadPool	pool		= CTThreadPoolDefault();
+	INT64			pieceCount	= ((end - begin) + grain - 1) / grain;
+
+	if (pool == NULL || pieceCount < 2) {
+		__HCTParallelForRun(&job);
+		return TRUE;
+	}
+
+	CTTaskGroup group;
+	CTTaskGroupBegin(pool, &group);
+
+	INT64 helperCount = min((INT64)pool->workerCount, pieceCount - 1);
+	for (INT64 helperIndex = 0; helperIndex < helperCount; helperIndex++) {
+		__HCTPoolPush(pool, __HCTParallelForRun, &job, &group);
+	}
+
+	__HCTParallelForRun(&job);
+	CTTaskGroupWait(&group);
+
+	return TRUE;
+}
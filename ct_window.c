@@ -67,6 +67,8 @@ static LRESULT CALLBACK __HCTWindowProc(HWND window, UINT message, WPARAM wParam
 	case CT_WINDOW_CLOSEMESSAGE: {
 		UnregisterClassA(ctwin->wndClassName, NULL);
 		CTLockDestroy(&ctwin->lock);
+		if (ctwin->presentBuffer != NULL)
+			CTGFXFree(ctwin->presentBuffer);
 		CTGFXFree(ctwin);
 
 		message = WM_CLOSE;
@@ -83,16 +85,42 @@ static LRESULT CALLBACK __HCTWindowProc(HWND window, UINT message, WPARAM wParam
 			goto __CTWinProcEnd;
 		}
 
-		if (ctwin->frameBuffer == NULL) {
+		if (ctwin->frameBuffer == NULL && ctwin->swapChain == NULL) {
 			goto __CTWinProcEnd;
 		}
 
 		PAINTSTRUCT paintObj;
 		HDC paintDC = BeginPaint(ctwin->hwnd, &paintObj);
 
-		CTFrameBufferLock(ctwin->frameBuffer);
+		/// a swap chain hands out its latest completed buffer, which the
+		/// render thread never writes to, so only a plain framebuffer
+		/// needs to be locked while it is being read
 
-		PCTFB frameBuffer = ctwin->frameBuffer;
+		PCTFB frameBuffer = NULL;
+		if (ctwin->swapChain != NULL) {
+			frameBuffer = CTSwapChainAcquireFront(ctwin->swapChain, NULL);
+		} else {
+			frameBuffer = ctwin->frameBuffer;
+			CTFrameBufferLock(frameBuffer);
+		}
+
+		/// compact formats are expanded to BGRA here, into a buffer
+		/// owned by the window which grows as needed
+
+		PCTColor presentColor = frameBuffer->color;
+		if (frameBuffer->format != CT_COLOR_FORMAT_BGRA8888) {
+
+			SIZE_T pixelCount = (SIZE_T)frameBuffer->width * frameBuffer->height;
+			if (ctwin->presentBufferPixels < pixelCount) {
+				if (ctwin->presentBuffer != NULL)
+					CTGFXFree(ctwin->presentBuffer);
+				ctwin->presentBuffer		= CTGFXAlloc(sizeof(CTColor) * pixelCount);
+				ctwin->presentBufferPixels	= pixelCount;
+			}
+
+			CTFrameBufferConvert(frameBuffer, ctwin->presentBuffer);
+			presentColor = ctwin->presentBuffer;
+		}
 
 		BITMAP rbBitmap;
 		rbBitmap.bmType			= 0;
@@ -101,7 +129,7 @@ static LRESULT CALLBACK __HCTWindowProc(HWND window, UINT message, WPARAM wParam
 		rbBitmap.bmWidthBytes	= frameBuffer->width * sizeof(CTColor);
 		rbBitmap.bmPlanes		= 1;
 		rbBitmap.bmBitsPixel	= 32;
-		rbBitmap.bmBits			= frameBuffer->color;
+		rbBitmap.bmBits			= presentColor;
 
 		HBITMAP hBitMap = CreateBitmapIndirect(&rbBitmap);
 
@@ -175,7 +203,11 @@ static LRESULT CALLBACK __HCTWindowProc(HWND window, UINT message, WPARAM wParam
 			blendFunc
 		);
 
-		CTFrameBufferUnlock(ctwin->frameBuffer);
+		if (ctwin->swapChain != NULL) {
+			CTSwapChainReleaseFront(ctwin->swapChain);
+		} else {
+			CTFrameBufferUnlock(frameBuffer);
+		}
 
 		DeleteObject(borderBrush);
 
@@ -210,6 +242,7 @@ CTCALL	PCTWin	CTWindowCreate(DWORD type, PCHAR title, UINT32 width, UINT32 heigh
 	PCTWin window		= CTGFXAlloc(sizeof(*window));
 	window->type		= type;
 	window->frameBuffer = NULL;
+	window->swapChain	= NULL;
 	window->lock		= CTLockCreate();
 	window->shouldClose	= FALSE;
 
@@ -337,6 +370,19 @@ CTCALL	BOOL	CTWindowSetFrameBuffer(PCTWin window, PCTFB frameBuffer) {
 	return TRUE;
 }
 
+CTCALL	BOOL	CTWindowSetSwapChain(PCTWin window, PCTSwapChain swapChain) {
+	if (window == NULL) {
+		CTErrorSetBadObject("CTWindowSetSwapChain failed because window was NULL");
+		return FALSE;
+	}
+
+	CTWindowLock(window);
+	window->swapChain = swapChain;
+	CTWindowUnlock(window);
+
+	return TRUE;
+}
+
 CTCALL	BOOL	CTWindowUpdate(PCTWindow window) {
 	if (window == NULL) {
 		CTErrorSetBadObject("CTWindowUpdate failed because window was NULL");
@@ -25,12 +25,15 @@
 
 #define CT_WINDOW_NAME_SIZE			0xFF
 typedef struct CTWindow {
-	DWORD	type;
-	PCTLock	lock;
-	HWND	hwnd;
-	PCTFB	frameBuffer;
-	BOOL	shouldClose;
-	CHAR	wndClassName[CT_WINDOW_NAME_SIZE];
+	DWORD			type;
+	PCTLock			lock;
+	HWND			hwnd;
+	PCTFB			frameBuffer;
+	PCTSwapChain	swapChain;
+	PCTColor		presentBuffer;
+	SIZE_T			presentBufferPixels;
+	BOOL			shouldClose;
+	CHAR			wndClassName[CT_WINDOW_NAME_SIZE];
 } CTWindow, *PCTWindow, CTWin, *PCTWin;
 
 CTCALL	PCTWin	CTWindowCreate(DWORD type, PCHAR title, UINT32 width, UINT32 height);
@@ -39,6 +42,7 @@ CTCALL	BOOL	CTWindowUnlock(PCTWin window);
 CTCALL	BOOL	CTWindowSetTitle(PCTWin window, PCHAR title);
 CTCALL	BOOL	CTWindowSetSize(PCTWin window, UINT32 width, UINT height);
 CTCALL	BOOL	CTWindowSetFrameBuffer(PCTWin window, PCTFB frameBuffer);
+CTCALL	BOOL	CTWindowSetSwapChain(PCTWin window, PCTSwapChain swapChain);
 CTCALL	BOOL	CTWindowUpdate(PCTWindow window);
 CTCALL	BOOL	CTWindowRefresh(PCTWindow window);
 CTCALL	BOOL	CTWindowShouldClose(PCTWindow window);
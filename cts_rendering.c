@@ -10,6 +10,9 @@
 #include "ct_data.h"
 
 #include <stdio.h>
+#include <math.h>
+#include <intrin.h>
+#include <immintrin.h>
 
 static __forceinline void __HCTCallObjectGProc(PCTGO obj, UINT32 reason, PVOID input) {
 	obj->gProc(
@@ -27,6 +30,232 @@ static BOOL __HCTDefaultSubShaderPix(CTPixCtx ctx, PCTPixel pixel, PVOID object)
 	return TRUE;
 }
 
+static FLOAT __HCTObjectCullRadius(PCTMesh mesh, PCTSubShader subShader) {
+
+	/// custom prim shaders may move vertices anywhere, so they are never culled
+	if (mesh == NULL)
+		return 0.0f;
+	if (subShader->disableGTransform == TRUE || subShader->subPrimShader != __HCTDefaultSubShaderPrim)
+		return CT_GOBJECT_NO_CULL_RADIUS;
+
+	return mesh->boundRadius;
+}
+
+static void __HCTObjStoreGrowArray(PVOID* pArray, SIZE_T elemSize, UINT32 count, UINT32 newCapacity) {
+	PVOID newArray = CTAllocEx(elemSize * newCapacity, CT_MEMORY_TAG_GFX, TRUE);
+	if (*pArray != NULL) {
+		memcpy(newArray, *pArray, elemSize * count);
+		CTFree(*pArray);
+	}
+	*pArray = newArray;
+}
+
+static UINT32 __HCTObjStoreAdd(PCTGO object) {
+	P__CTGObjectStore store = &__ctdata.sys.rendering.objStore;
+
+	/// SUMMARY:
+	/// if (store is full)
+	///		grow every array to double capacity
+	/// append object at end of dense arrays
+	/// return dense index
+
+	if (store->count == store->capacity) {
+		UINT32 newCapacity = max(CT_GOBJECT_STORE_CAPACITY_MIN, store->capacity * 2);
+
+		__HCTObjStoreGrowArray((PVOID*)&store->posX,		sizeof(FLOAT),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->posY,		sizeof(FLOAT),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->sclX,		sizeof(FLOAT),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->sclY,		sizeof(FLOAT),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->rot,			sizeof(FLOAT),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->depth,		sizeof(FLOAT),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->cullRadius,	sizeof(FLOAT),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->visible,		sizeof(BYTE),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->alpha,		sizeof(BYTE),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->drawMask,	sizeof(BYTE),	store->count, newCapacity);
+		__HCTObjStoreGrowArray((PVOID*)&store->objects,		sizeof(PCTGO),	store->count, newCapacity);
+
+		store->capacity = newCapacity;
+	}
+
+	UINT32 index = store->count++;
+	store->objects[index]	= object;
+	store->drawMask[index]	= FALSE;
+
+	return index;
+}
+
+static void __HCTObjStoreRemove(UINT32 index) {
+	P__CTGObjectStore store = &__ctdata.sys.rendering.objStore;
+
+	/// move last entry into the hole and repoint its object
+	UINT32 last = --store->count;
+	if (index != last) {
+		store->posX[index]			= store->posX[last];
+		store->posY[index]			= store->posY[last];
+		store->sclX[index]			= store->sclX[last];
+		store->sclY[index]			= store->sclY[last];
+		store->rot[index]			= store->rot[last];
+		store->depth[index]			= store->depth[last];
+		store->cullRadius[index]	= store->cullRadius[last];
+		store->visible[index]		= store->visible[last];
+		store->alpha[index]			= store->alpha[last];
+		store->drawMask[index]		= store->drawMask[last];
+		store->objects[index]		= store->objects[last];
+
+		store->objects[index]->hotIndex = index;
+	}
+}
+
+static void __HCTObjStoreQueue(PCTGO object) {
+	P__CTGObjectStore store = &__ctdata.sys.rendering.objStore;
+
+	object->hotIndex = __CT_GOBJECT_HOT_PENDING;
+
+	PVOID head;
+	do {
+		head				= store->pendingHead;
+		object->pendingNext	= head;
+	} while (InterlockedCompareExchangePointer(&store->pendingHead, object, head) != head);
+}
+
+static void __HCTObjStoreFlushPending(void) {
+	P__CTGObjectStore store = &__ctdata.sys.rendering.objStore;
+
+	/// SUMMARY:
+	/// take whole pending stack, reverse it back into creation order
+	/// for (all pending objects)
+	///		add object to store and copy its pending fields in
+
+	PCTGO pending = InterlockedExchangePointer(&store->pendingHead, NULL);
+	PCTGO ordered = NULL;
+
+	while (pending != NULL) {
+		PCTGO next				= pending->pendingNext;
+		pending->pendingNext	= ordered;
+		ordered					= pending;
+		pending					= next;
+	}
+
+	while (ordered != NULL) {
+		PCTGO	object		= ordered;
+		UINT32	hotIndex	= __HCTObjStoreAdd(object);
+		ordered				= object->pendingNext;
+
+		store->posX[hotIndex]		= object->pendingTransform.pos.x;
+		store->posY[hotIndex]		= object->pendingTransform.pos.y;
+		store->sclX[hotIndex]		= object->pendingTransform.scl.x;
+		store->sclY[hotIndex]		= object->pendingTransform.scl.y;
+		store->rot[hotIndex]		= object->pendingTransform.rot;
+		store->depth[hotIndex]		= object->pendingTransform.depth;
+		store->cullRadius[hotIndex]	= __HCTObjectCullRadius(object->mesh, object->subShader);
+		store->visible[hotIndex]	= object->pendingVisible;
+		store->alpha[hotIndex]		= object->pendingAlpha;
+
+		object->pendingNext	= NULL;
+		object->hotIndex	= hotIndex;
+	}
+}
+
+static BOOL __HCTObjectHotEnter(PCTGO object) {
+
+	/// an object still in INIT is only known to its creator
+	if (object->hotIndex == __CT_GOBJECT_HOT_UNPUBLISHED)
+		return FALSE;
+
+	CTLockEnter(__ctdata.sys.rendering.lock);
+	return TRUE;
+}
+
+static void __HCTObjectHotLeave(BOOL locked) {
+	if (locked == TRUE)
+		CTLockLeave(__ctdata.sys.rendering.lock);
+}
+
+static void __HCTObjStoreDestroy(void) {
+	P__CTGObjectStore store = &__ctdata.sys.rendering.objStore;
+
+	if (store->capacity != 0) {
+		CTFree(store->posX);
+		CTFree(store->posY);
+		CTFree(store->sclX);
+		CTFree(store->sclY);
+		CTFree(store->rot);
+		CTFree(store->depth);
+		CTFree(store->cullRadius);
+		CTFree(store->visible);
+		CTFree(store->alpha);
+		CTFree(store->drawMask);
+		CTFree(store->objects);
+	}
+
+	ZeroMemory(store, sizeof(*store));
+}
+
+static void __HCTObjStoreCull(PCTCamera camera, PCTFB renderTarget) {
+	P__CTGObjectStore store = &__ctdata.sys.rendering.objStore;
+
+	/// SUMMARY:
+	/// bound camera view (x in [-1, 1], y in [-h/w, h/w] after camera scale
+	/// and rotation) by a world space circle around camera position
+	/// for (all objects, 4 at a time with SSE)
+	///		object bound = circle of cullRadius * larger scale axis at position
+	///		draw mask = visible AND bound circles overlap
+	/// finish remaining objects one at a time
+
+	FLOAT camSclX	= fabsf(camera->transform.scl.x);
+	FLOAT camSclY	= fabsf(camera->transform.scl.y);
+	FLOAT aspect	= (FLOAT)renderTarget->height / (FLOAT)renderTarget->width;
+
+	FLOAT viewRadius = CT_GOBJECT_NO_CULL_RADIUS;
+	if (camSclX != 0.0f && camSclY != 0.0f) {
+		FLOAT halfWidth		= 1.0f / camSclX;
+		FLOAT halfHeight	= aspect / camSclY;
+		viewRadius			= sqrtf((halfWidth * halfWidth) + (halfHeight * halfHeight));
+	}
+
+	/// expands a 4 bit compare mask into 4 bytes of 0 or 1
+	static const UINT32 maskExpand[16] = {
+		0x00000000, 0x00000001, 0x00000100, 0x00000101,
+		0x00010000, 0x00010001, 0x00010100, 0x00010101,
+		0x01000000, 0x01000001, 0x01000100, 0x01000101,
+		0x01010000, 0x01010001, 0x01010100, 0x01010101
+	};
+
+	__m128 vCamX		= _mm_set1_ps(camera->transform.pos.x);
+	__m128 vCamY		= _mm_set1_ps(camera->transform.pos.y);
+	__m128 vViewRadius	= _mm_set1_ps(viewRadius);
+	__m128 vAbsMask		= _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+	UINT32 index = 0;
+
+	for (; index + 4 <= store->count; index += 4) {
+		__m128 dX		= _mm_sub_ps(_mm_loadu_ps(store->posX + index), vCamX);
+		__m128 dY		= _mm_sub_ps(_mm_loadu_ps(store->posY + index), vCamY);
+		__m128 dist2	= _mm_add_ps(_mm_mul_ps(dX, dX), _mm_mul_ps(dY, dY));
+
+		__m128 sclMax	= _mm_max_ps(
+			_mm_and_ps(_mm_loadu_ps(store->sclX + index), vAbsMask),
+			_mm_and_ps(_mm_loadu_ps(store->sclY + index), vAbsMask)
+		);
+		__m128 reach	= _mm_add_ps(vViewRadius, _mm_mul_ps(_mm_loadu_ps(store->cullRadius + index), sclMax));
+		INT32 inView	= _mm_movemask_ps(_mm_cmple_ps(dist2, _mm_mul_ps(reach, reach)));
+
+		UINT32 visibleBytes;
+		memcpy(&visibleBytes, store->visible + index, sizeof(visibleBytes));
+		visibleBytes &= maskExpand[inView];
+		memcpy(store->drawMask + index, &visibleBytes, sizeof(visibleBytes));
+	}
+
+	for (; index < store->count; index++) {
+		FLOAT dX		= store->posX[index] - camera->transform.pos.x;
+		FLOAT dY		= store->posY[index] - camera->transform.pos.y;
+		FLOAT sclMax	= max(fabsf(store->sclX[index]), fabsf(store->sclY[index]));
+		FLOAT reach		= viewRadius + (store->cullRadius[index] * sclMax);
+
+		store->drawMask[index] = store->visible[index] & (((dX * dX) + (dY * dY)) <= (reach * reach));
+	}
+}
+
 CTCALL	PCTSubShader	CTSubShaderCreateEx(
 	PCTSUBSPRIM primShader,
 	PCTSUBSPIX	pixShader,
@@ -101,27 +330,34 @@ CTCALL	PCTGO	CTGraphicsObjectCreate(
 		return NULL;
 	}
 
-	CTLockEnter(__ctdata.sys.rendering.lock);
-	CTDynListLock(__ctdata.sys.rendering.objList);
+	/// SUMMARY:
+	/// reserve object in objList (only takes the list's writer lock)
+	/// fill object and its pending hot data
+	/// call INIT
+	/// queue object for the object store, publish it in objList
 
 	PCTGO obj	= CTDynListAdd(__ctdata.sys.rendering.objList);
 	ZeroMemory(obj, sizeof(*obj));
+	obj->hotIndex			= __CT_GOBJECT_HOT_UNPUBLISHED;
 	obj->destroySignal		= FALSE;
 	obj->age				= 0;
-	obj->gData				= CTAlloc(max(4, gDataSizeBytes));
+	obj->gData				= (gDataSizeBytes <= CT_GOBJECT_INLINE_DATA_SIZE) ?
+		obj->gDataInline : CTAlloc(gDataSizeBytes);
 	obj->gDataSizeBytes		= gDataSizeBytes;
 	obj->mesh				= mesh;
 	obj->texture			= texture;
 	obj->outlineColor		= CTColorCreate(0, 0, 0, 0);
 	obj->outlineSizePixels	= 1;
 	obj->subShader			= subShader;
-	obj->alpha				= 255;
-	obj->transform.pos		= position;
-	obj->transform.rot		= rotation;
-	obj->transform.scl		= scale;
-	obj->transform.depth	= layer;
-	obj->visible			= TRUE;
 	obj->gProc				= gProc;
+	obj->pendingTransform	= (CTTransform) {
+		.pos	= position,
+		.scl	= scale,
+		.rot	= rotation,
+		.depth	= layer
+	};
+	obj->pendingVisible		= TRUE;
+	obj->pendingAlpha		= 255;
 
 	__HCTCallObjectGProc(
 		obj,
@@ -129,8 +365,8 @@ CTCALL	PCTGO	CTGraphicsObjectCreate(
 		initInput
 	);
 
-	CTDynListUnlock(__ctdata.sys.rendering.objList);
-	CTLockLeave(__ctdata.sys.rendering.lock);
+	__HCTObjStoreQueue(obj);
+	CTDynListPublish(__ctdata.sys.rendering.objList, obj);
 
 	return obj;
 }
@@ -153,6 +389,11 @@ CTCALL	BOOL	CTGraphicsObjectDestroy(PCTGO* pGObject) {
 	}
 
 	object->destroySignal = TRUE;
+	if (object->hotIndex >= __CT_GOBJECT_HOT_PENDING)
+		object->pendingVisible = FALSE;
+	else
+		__ctdata.sys.rendering.objStore.visible[object->hotIndex] = FALSE;
+	__ctdata.sys.rendering.objStore.destroyPending++;
 
 	*pGObject = NULL;
 
@@ -160,31 +401,203 @@ CTCALL	BOOL	CTGraphicsObjectDestroy(PCTGO* pGObject) {
 	return TRUE;
 }
 
+CTCALL	BOOL	CTGraphicsObjectGetTransform(PCTGO object, PCTTransform transformOut) {
+	if (object == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectGetTransform failed: object was NULL");
+		return FALSE;
+	}
+	if (transformOut == NULL) {
+		CTErrorSetParamValue("CTGraphicsObjectGetTransform failed: transformOut was NULL");
+		return FALSE;
+	}
+
+	BOOL locked = __HCTObjectHotEnter(object);
+
+	P__CTGObjectStore store = &__ctdata.sys.rendering.objStore;
+	if (object->hotIndex >= __CT_GOBJECT_HOT_PENDING) {
+		*transformOut = object->pendingTransform;
+	} else {
+		transformOut->pos.x	= store->posX[object->hotIndex];
+		transformOut->pos.y	= store->posY[object->hotIndex];
+		transformOut->scl.x	= store->sclX[object->hotIndex];
+		transformOut->scl.y	= store->sclY[object->hotIndex];
+		transformOut->rot	= store->rot[object->hotIndex];
+		transformOut->depth	= store->depth[object->hotIndex];
+	}
+
+	__HCTObjectHotLeave(locked);
+	return TRUE;
+}
+
+CTCALL	BOOL	CTGraphicsObjectSetTransform(PCTGO object, CTTransform transform) {
+	if (object == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectSetTransform failed: object was NULL");
+		return FALSE;
+	}
+
+	BOOL locked = __HCTObjectHotEnter(object);
+
+	P__CTGObjectStore store = &__ctdata.sys.rendering.objStore;
+	if (object->hotIndex >= __CT_GOBJECT_HOT_PENDING) {
+		object->pendingTransform = transform;
+	} else {
+		store->posX[object->hotIndex]	= transform.pos.x;
+		store->posY[object->hotIndex]	= transform.pos.y;
+		store->sclX[object->hotIndex]	= transform.scl.x;
+		store->sclY[object->hotIndex]	= transform.scl.y;
+		store->rot[object->hotIndex]	= transform.rot;
+		store->depth[object->hotIndex]	= transform.depth;
+	}
+
+	__HCTObjectHotLeave(locked);
+	return TRUE;
+}
+
+CTCALL	BOOL	CTGraphicsObjectGetVisible(PCTGO object) {
+	if (object == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectGetVisible failed: object was NULL");
+		return FALSE;
+	}
+
+	BOOL locked		= __HCTObjectHotEnter(object);
+	BOOL visible	= (object->hotIndex >= __CT_GOBJECT_HOT_PENDING) ?
+		object->pendingVisible : __ctdata.sys.rendering.objStore.visible[object->hotIndex];
+	__HCTObjectHotLeave(locked);
+
+	return visible;
+}
+
+CTCALL	BOOL	CTGraphicsObjectSetVisible(PCTGO object, BOOL visible) {
+	if (object == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectSetVisible failed: object was NULL");
+		return FALSE;
+	}
+
+	BOOL locked = __HCTObjectHotEnter(object);
+
+	if (object->destroySignal == FALSE) {
+		if (object->hotIndex >= __CT_GOBJECT_HOT_PENDING)
+			object->pendingVisible = (visible != FALSE);
+		else
+			__ctdata.sys.rendering.objStore.visible[object->hotIndex] = (visible != FALSE);
+	}
+
+	__HCTObjectHotLeave(locked);
+	return TRUE;
+}
+
+CTCALL	BYTE	CTGraphicsObjectGetAlpha(PCTGO object) {
+	if (object == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectGetAlpha failed: object was NULL");
+		return 0;
+	}
+
+	BOOL locked	= __HCTObjectHotEnter(object);
+	BYTE alpha	= (object->hotIndex >= __CT_GOBJECT_HOT_PENDING) ?
+		object->pendingAlpha : __ctdata.sys.rendering.objStore.alpha[object->hotIndex];
+	__HCTObjectHotLeave(locked);
+
+	return alpha;
+}
+
+CTCALL	BOOL	CTGraphicsObjectSetAlpha(PCTGO object, BYTE alpha) {
+	if (object == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectSetAlpha failed: object was NULL");
+		return FALSE;
+	}
+
+	BOOL locked = __HCTObjectHotEnter(object);
+
+	if (object->hotIndex >= __CT_GOBJECT_HOT_PENDING)
+		object->pendingAlpha = alpha;
+	else
+		__ctdata.sys.rendering.objStore.alpha[object->hotIndex] = alpha;
+
+	__HCTObjectHotLeave(locked);
+
+	return TRUE;
+}
+
+CTCALL	BOOL	CTGraphicsObjectSetMesh(PCTGO object, PCTMesh mesh) {
+	if (object == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectSetMesh failed: object was NULL");
+		return FALSE;
+	}
+
+	BOOL locked = __HCTObjectHotEnter(object);
+
+	/// queued objects get their cull radius when they enter the store
+	object->mesh = mesh;
+	if (object->hotIndex < __CT_GOBJECT_HOT_PENDING) {
+		__ctdata.sys.rendering.objStore.cullRadius[object->hotIndex] =
+			__HCTObjectCullRadius(object->mesh, object->subShader);
+	}
+
+	__HCTObjectHotLeave(locked);
+	return TRUE;
+}
+
+CTCALL	BOOL	CTGraphicsObjectSetSubShader(PCTGO object, PCTSubShader subShader) {
+	if (object == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectSetSubShader failed: object was NULL");
+		return FALSE;
+	}
+	if (subShader == NULL) {
+		CTErrorSetBadObject("CTGraphicsObjectSetSubShader failed: subShader was NULL");
+		return FALSE;
+	}
+
+	BOOL locked = __HCTObjectHotEnter(object);
+
+	/// queued objects get their cull radius when they enter the store
+	object->subShader = subShader;
+	if (object->hotIndex < __CT_GOBJECT_HOT_PENDING) {
+		__ctdata.sys.rendering.objStore.cullRadius[object->hotIndex] =
+			__HCTObjectCullRadius(object->mesh, object->subShader);
+	}
+
+	__HCTObjectHotLeave(locked);
+	return TRUE;
+}
+
 typedef struct __CTSurfCreateDat {
 	PCHAR		title;
 	UINT32		winType;
 	UINT32		width, height, resX, resY;
+	UINT32		bufferCount;
+	UINT32		colorFormat;
+	UINT32		fbFlags;
 	PCTSurface	outSurf;
 } __CTSurfCreateDat, *P__CTSurfCreateDat;
 
 static void __HCTSurfaceCreateFunc(PCTThread thread, PVOID threadData, P__CTSurfCreateDat dat) {
 	PCTSurface surface		= CTDynListAdd(__ctdata.sys.rendering.surfaceList);
 	surface->destroySignal	= FALSE;
-	surface->window			= CTWindowCreate(
-		dat->winType,
-		dat->title,
-		dat->width,
-		dat->height
-	);
-	surface->frameBuffer = CTFrameBufferCreate(
+	surface->renderReleased	= FALSE;
+	surface->frameDirty		= FALSE;
+	surface->window			= NULL;
+	surface->swapChain		= CTSwapChainCreateEx(
 		dat->resX,
-		dat->resY
-	);
-	CTWindowSetFrameBuffer(
-		surface->window,
-		surface->frameBuffer
+		dat->resY,
+		dat->bufferCount,
+		dat->colorFormat,
+		dat->fbFlags
 	);
 
+	if (dat->winType != CT_SURFACE_HEADLESS) {
+		surface->window = CTWindowCreate(
+			dat->winType,
+			dat->title,
+			dat->width,
+			dat->height
+		);
+		CTWindowSetSwapChain(
+			surface->window,
+			surface->swapChain
+		);
+	}
+
+	CTDynListPublish(__ctdata.sys.rendering.surfaceList, surface);
 	dat->outSurf = surface;
 }
 
@@ -196,23 +609,63 @@ CTCALL	PCTSurface	CTSurfaceCreate(
 	UINT32	resX,
 	UINT32	resY
 ) {
-	if (width == 0 || height == 0 || resX == 0 || resY == 0) {
-		CTErrorSetParamValue("CTSurfaceCreate failed: dimensions or resolution was invalid");
+	return CTSurfaceCreateEx(
+		title,
+		windowType,
+		width,
+		height,
+		resX,
+		resY,
+		CT_SURFACE_DEFAULT_BUFFERS,
+		CT_COLOR_FORMAT_BGRA8888,
+		0
+	);
+}
+
+CTCALL	PCTSurface	CTSurfaceCreateEx(
+	PCHAR	title,
+	UINT32	windowType,
+	UINT32	width,
+	UINT32	height,
+	UINT32	resX,
+	UINT32	resY,
+	UINT32	bufferCount,
+	UINT32	colorFormat,
+	UINT32	fbFlags
+) {
+	if (resX == 0 || resY == 0) {
+		CTErrorSetParamValue("CTSurfaceCreate failed: resolution was invalid");
+		return FALSE;
+	}
+	if (windowType != CT_SURFACE_HEADLESS && (width == 0 || height == 0)) {
+		CTErrorSetParamValue("CTSurfaceCreate failed: dimensions were invalid");
+		return FALSE;
+	}
+	if (bufferCount < CT_SWAPCHAIN_BUFFERS_MIN || bufferCount > CT_SWAPCHAIN_BUFFERS_MAX) {
+		CTErrorSetParamValue("CTSurfaceCreate failed: bufferCount was invalid");
+		return FALSE;
+	}
+	if (colorFormat > CT_COLOR_FORMAT_INDEXED8) {
+		CTErrorSetParamValue("CTSurfaceCreate failed: colorFormat was invalid");
 		return FALSE;
 	}
 
 	__CTSurfCreateDat dat = {
-		.title		= title,
-		.winType	= windowType,
-		.width		= width,
-		.height		= height,
-		.resX		= resX,
-		.resY		= resY,
-		.outSurf	= NULL
+		.title			= title,
+		.winType		= windowType,
+		.width			= width,
+		.height			= height,
+		.resX			= resX,
+		.resY			= resY,
+		.bufferCount	= bufferCount,
+		.colorFormat	= colorFormat,
+		.fbFlags		= fbFlags,
+		.outSurf		= NULL
 	};
 
+	/// windows are created on the present thread, which pumps them
 	CTThreadTask(
-		__ctdata.sys.rendering.thread,
+		__ctdata.sys.rendering.presentThread,
 		__HCTSurfaceCreateFunc,
 		&dat,
 		TRUE
@@ -230,7 +683,9 @@ CTCALL	BOOL		CTSurfaceShouldClose(PCTSurface surface) {
 		return FALSE;
 	}
 
-	BOOL shouldClose = CTWindowShouldClose(surface->window);
+	BOOL shouldClose = FALSE;
+	if (surface->window != NULL)
+		shouldClose = CTWindowShouldClose(surface->window);
 	CTLockLeave(__ctdata.sys.rendering.lock);
 	
 	return shouldClose;
@@ -275,6 +730,7 @@ static void __HCTCameraCreateTask(PCTThread thread, PVOID threadData, P__CTCamCr
 	cam->targetType		= CT_CAMERA_TARGET_NONE;
 	cam->targetTexture	= NULL;
 	cam->targetSurface	= NULL;
+	CTDynListPublish(__ctdata.sys.rendering.cameraList, cam);
 	dat->outCam			= cam;
 }
 
@@ -359,6 +815,11 @@ CTCALL	BOOL		CTCameraSetTargetSurface(PCTCamera camera, PCTSurface surface) {
 		CTLockLeave(__ctdata.sys.rendering.lock);
 		return FALSE;
 	}
+	if (surface->destroySignal == TRUE) {
+		CTErrorSetBadObject("CTCameraSetTargetSurface failed: surface is being destroyed");
+		CTLockLeave(__ctdata.sys.rendering.lock);
+		return FALSE;
+	}
 
 	camera->targetType		= CT_CAMERA_TARGET_SURFACE;
 	camera->targetTexture	= NULL;
@@ -395,6 +856,8 @@ typedef struct __CTRTShaderData {
 	PCTGO		object;
 	PCTCamera	camera;
 	PCTFB		renderTarget;
+	CTTransform	transform;
+	BYTE		alpha;
 } __CTRTShaderData, *P__CTRTShaderData;
 
 static void __HCTRenderThreadPrimShader(
@@ -416,9 +879,9 @@ static void __HCTRenderThreadPrimShader(
 	if (applyTransform == TRUE) {
 		CTMatrix tform = CTMatrixTransform(
 			CTMatrixIdentity(),
-			data->object->transform.pos,
-			data->object->transform.scl,
-			data->object->transform.rot
+			data->transform.pos,
+			data->transform.scl,
+			data->transform.rot
 		);
 
 		prim->vertex = CTMatrixApply(
@@ -472,19 +935,26 @@ static BOOL __HCTRenderThreadPixShader(
 
 	default:
 
-		if (data->object->texture == NULL) {
-			*(PDWORD)&pixColor = (DWORD)0;
-			
-		} else {
+		if (data->object->texture != NULL) {
 			pixColor = CTSSample(
 				data->object->texture,
 				ctx.UV,
 				CTS_SAMPLE_METHOD_CUTOFF
 			);
+
+		} else if (data->object->compactTexture != NULL) {
+			pixColor = CTSSampleTexture(
+				data->object->compactTexture,
+				ctx.UV,
+				CTS_SAMPLE_METHOD_CUTOFF
+			);
+
+		} else {
+			*(PDWORD)&pixColor = (DWORD)0;
 		}
 
-		if (applyAlpha == TRUE && data->object->alpha != 255) {
-			pixColor.a = (pixColor.a * data->object->alpha) >> 8;
+		if (applyAlpha == TRUE && data->alpha != 255) {
+			pixColor.a = (pixColor.a * data->alpha) >> 8;
 		}
 
 		break;
@@ -502,22 +972,25 @@ static BOOL __HCTRenderThreadPixShader(
 	return keepPixel;
 }
 
-static __forceinline void __HCTDrawGraphicsObject(PCTGO object, PCTCamera camera) {
+static __forceinline void __HCTDrawGraphicsObject(PCTGO object, PCTCamera camera, PCTFB renderTarget) {
 
 	if (object->mesh == NULL)
 		return;
 
-	PCTFB renderTarget = NULL;
-	if (camera->targetType == CT_CAMERA_TARGET_TEXTURE) {
-		renderTarget = camera->targetTexture;
-	} else {
-		renderTarget = camera->targetSurface->frameBuffer;
-	}
+	P__CTGObjectStore	store		= &__ctdata.sys.rendering.objStore;
+	UINT32				hotIndex	= object->hotIndex;
 
 	__CTRTShaderData shaderData = {
 		.object			= object,
 		.camera			= camera,
-		.renderTarget	= renderTarget
+		.renderTarget	= renderTarget,
+		.transform		= {
+			.pos	= { store->posX[hotIndex], store->posY[hotIndex] },
+			.scl	= { store->sclX[hotIndex], store->sclY[hotIndex] },
+			.rot	= store->rot[hotIndex],
+			.depth	= store->depth[hotIndex]
+		},
+		.alpha			= store->alpha[hotIndex]
 	};
 
 	/// DRAW OBJECT OUTLINE
@@ -538,7 +1011,7 @@ static __forceinline void __HCTDrawGraphicsObject(PCTGO object, PCTCamera camera
 			shaderData.object->mesh,
 			__ctdata.sys.rendering.shader,
 			&shaderData,
-			shaderData.object->transform.depth
+			shaderData.transform.depth
 		);
 
 	}
@@ -550,10 +1023,99 @@ static __forceinline void __HCTDrawGraphicsObject(PCTGO object, PCTCamera camera
 		shaderData.object->mesh,
 		__ctdata.sys.rendering.shader,
 		&shaderData,
-		shaderData.object->transform.depth
+		shaderData.transform.depth
 	);
 }
 
+static void __HCTSurfacePresentAll(void) {
+
+	/// SUMMARY:
+	/// loop (all surfaces)
+	///		if (render thread released surface)
+	///			destroy window and swap chain, remove surface
+	///			skip
+	///		present latest published buffer to consumers
+	///		update surface window (WM_PAINT reads the front buffer here)
+
+	PCTSurface surface = NULL;
+	CTDynListReadBegin(__ctdata.sys.rendering.surfaceList);
+	CT_DYNLIST_FOREACH(__ctdata.sys.rendering.surfaceList, surface) {
+
+		if (surface->renderReleased == TRUE) {
+			if (surface->window != NULL)
+				CTWindowDestroy(&surface->window);
+			CTSwapChainDestroy(&surface->swapChain);
+			CTDynListRemove(__ctdata.sys.rendering.surfaceList, surface);
+			continue;
+		}
+
+		CTSwapChainPresent(surface->swapChain);
+
+		if (surface->window != NULL)
+			CTWindowUpdate(surface->window);
+
+	}
+	CTDynListReadEnd(__ctdata.sys.rendering.surfaceList);
+}
+
+static void __HCTSurfacePresentTask(PCTThread thread, PVOID threadData, PVOID input) {
+	__HCTSurfacePresentAll();
+}
+
+void __CTPresentThreadProc(
+	UINT32		reason,
+	PCTThread	thread,
+	PVOID		threadData,
+	PVOID		input
+) {
+
+	switch (reason)
+	{
+
+	case CT_THREADPROC_REASON_INIT:
+
+		__ctdata.sys.rendering.surfaceList = CTDynListCreateEx(
+			sizeof(CTSurface),
+			CT_RTHREAD_SURFACE_NODE_SIZE,
+			CT_DYNLIST_FLAG_EPOCH
+		);
+
+		break;
+
+	case CT_THREADPROC_REASON_SPIN:
+
+		/// render thread wakes this thread with a task for every frame it
+		/// publishes, spinning keeps windows pumped when nothing is drawn
+
+		__HCTSurfacePresentAll();
+
+		break;
+
+	case CT_THREADPROC_REASON_EXIT:
+
+		/// render thread is gone by now, so every surface can be freed
+
+		{
+			PCTSurface surface = NULL;
+			CTDynListReadBegin(__ctdata.sys.rendering.surfaceList);
+			CT_DYNLIST_FOREACH(__ctdata.sys.rendering.surfaceList, surface) {
+				if (surface->window != NULL)
+					CTWindowDestroy(&surface->window);
+				CTSwapChainDestroy(&surface->swapChain);
+			}
+			CTDynListReadEnd(__ctdata.sys.rendering.surfaceList);
+		}
+
+		CTDynListDestroy(&__ctdata.sys.rendering.surfaceList);
+
+		break;
+
+	default:
+		break;
+	}
+
+}
+
 void __CTRenderThreadProc(
 	UINT32		reason,
 	PCTThread	thread,
@@ -573,19 +1135,16 @@ void __CTRenderThreadProc(
 
 		__ctdata.sys.rendering.lock			= CTLockCreate();
 		__ctdata.sys.rendering.logStream	= CTLogStreamCreate("$renderlog.txt", NULL, NULL);
-		__ctdata.sys.rendering.objList		= CTDynListCreate(
+		__ctdata.sys.rendering.objList		= CTDynListCreateEx(
 			sizeof(CTGO),
-			CT_RTHREAD_GOBJ_NODE_SIZE
+			CT_RTHREAD_GOBJ_NODE_SIZE,
+			CT_DYNLIST_FLAG_EPOCH
 		);
-		__ctdata.sys.rendering.cameraList = CTDynListCreate(
+		__ctdata.sys.rendering.cameraList = CTDynListCreateEx(
 			sizeof(CTCamera),
-			CT_RTHREAD_CAMERA_NODE_SIZE
+			CT_RTHREAD_CAMERA_NODE_SIZE,
+			CT_DYNLIST_FLAG_EPOCH
 		);
-		__ctdata.sys.rendering.surfaceList = CTDynListCreate(
-			sizeof(CTSurface),
-			CT_RTHREAD_SURFACE_NODE_SIZE
-		);
-
 		__ctdata.sys.rendering.shader = CTShaderCreate(
 			__HCTRenderThreadPrimShader,
 			__HCTRenderThreadPixShader,
@@ -610,48 +1169,60 @@ void __CTRenderThreadProc(
 	case CT_THREADPROC_REASON_SPIN:
 
 		/// SUMMARY:
+		/// move objects queued since last spin into the object store
 		/// if (cycles % clean interval == 0)
 		///		clean camera/object buffers
+		/// if (any object is SIGNALED TO BE DESTROYED)
+		///		loop (all objects)
+		///			if (object is SIGNALED TO BE DESTROYED)
+		///				if (object is still queued)
+		///					leave it for next spin
+		///				CALL DESTROY
+		///				destroy object and its object store entry
 		/// loop (all cameras)
 		///		if (camera is SIGNALED TO BE DESTROYED)
 		///			destroy camera
 		///			skip
+		///		if (camera targets a surface SIGNALED TO BE DESTROYED)
+		///			clear camera target, the surface is released below
 		///		if (camera has NO TARGET)
 		///			skip
 		///		get framebuffer
 		///		LOCK FRAMEBUFFER
 		///		CLEAR FRAMEBUFFER
-		///		loop (all objects)	
-		///			if (object is NOT VISIBLE) 
-		///				skip
-		///			if (object is SIGNALED TO BE DESTROYED)
-		///				CALL DESTROY
-		///				destroy object
+		///		cull object store against camera view (SIMD sweep)
+		///		loop (all objects in object store)
+		///			if (object is NOT VISIBLE)
 		///				skip
 		///			CALL PRE-RENDER
-		///			setup shader parameters
-		///			setup shader inputs
-		///			draw renderObject
+		///			if (object was not culled)
+		///				setup shader parameters
+		///				setup shader inputs
+		///				draw renderObject
 		///			CALL POST-RENDER
 		///			increment object age
-		///		loop (all surfaces)
-		///			if (surface signaled destroy)
-		///				remove surface
-		///				skip
-		///			update surface window
 		///		UNLOCK FRAMEBUFFER
+		/// loop (all surfaces)
+		///		if (surface signaled destroy)
+		///			release it to the present thread (no camera targets it
+		///			anymore, and the render lock keeps new targets out)
+		///			skip
+		///		if (surface was drawn to)
+		///			publish back buffer
+		/// if (any surface was published)
+		///		wake present thread to present it
 
 		CTLockEnter(__ctdata.sys.rendering.lock);
 
+		__HCTObjStoreFlushPending();
+
 		if ((thread->threadSpinCount % CT_RTHREAD_CLEAN_INTERVAL) == 0) {
 
 			UINT32 objCountBefore = __ctdata.sys.rendering.objList->elementsUsedCount;
 			UINT32 camCountBefore = __ctdata.sys.rendering.cameraList->elementsUsedCount;
-			UINT32 surfCountBefore = __ctdata.sys.rendering.surfaceList->elementsUsedCount;
 
 			CTDynListClean(__ctdata.sys.rendering.objList);
 			CTDynListClean(__ctdata.sys.rendering.cameraList);
-			CTDynListClean(__ctdata.sys.rendering.surfaceList);
 			__ctdata.sys.rendering.defaultSubShader = CTSubShaderCreate(
 				__HCTDefaultSubShaderPrim,
 				__HCTDefaultSubShaderPix
@@ -659,24 +1230,58 @@ void __CTRenderThreadProc(
 
 			UINT32 objCountAfter = __ctdata.sys.rendering.objList->elementsUsedCount;
 			UINT32 camCountAfter = __ctdata.sys.rendering.cameraList->elementsUsedCount;
-			UINT32 surfCountAfter = __ctdata.sys.rendering.surfaceList->elementsUsedCount;
-
-			puts("CTRT: cleaning...");
 
 			CTLogInfo(
 				__ctdata.sys.rendering.logStream,
 				"Cleaned %d Graphics Objects and %d Cameras",
 				objCountBefore - objCountAfter,
-				camCountBefore - camCountAfter,
-				surfCountBefore - surfCountAfter
+				camCountBefore - camCountAfter
 			);
 
 		}
 
-		PCTIterator camIter = CTIteratorCreate(__ctdata.sys.rendering.cameraList);
+		if (__ctdata.sys.rendering.objStore.destroyPending > 0) {
+
+			PCTGO	object		= NULL;
+			UINT32	deferred	= 0;
+
+			CTDynListReadBegin(__ctdata.sys.rendering.objList);
+			CT_DYNLIST_FOREACH(__ctdata.sys.rendering.objList, object) {
+
+				if (object->destroySignal == FALSE) {
+					continue;
+				}
+
+				/// queued after this spin's flush, destroy it next spin
+				if (object->hotIndex >= __CT_GOBJECT_HOT_PENDING) {
+					deferred++;
+					continue;
+				}
+
+				__HCTCallObjectGProc(
+					object,
+					CT_GPROC_REASON_DESTROY,
+					NULL
+				);
+				if (object->gData != object->gDataInline)
+					CTFree(object->gData);
+				__HCTObjStoreRemove(object->hotIndex);
+				CTDynListRemove(
+					__ctdata.sys.rendering.objList,
+					object
+				);
+
+			}
+			CTDynListReadEnd(__ctdata.sys.rendering.objList);
+
+			__ctdata.sys.rendering.objStore.destroyPending = deferred;
+
+		}
+
 		PCTCamera	camera  = NULL;
 
-		while ((camera = CTIteratorIterate(camIter)) != NULL) {
+		CTDynListReadBegin(__ctdata.sys.rendering.cameraList);
+		CT_DYNLIST_FOREACH(__ctdata.sys.rendering.cameraList, camera) {
 
 			if (camera->destroySignal == TRUE) {
 				CTDynListRemove(
@@ -686,6 +1291,12 @@ void __CTRenderThreadProc(
 				continue;
 			}
 
+			if (camera->targetType == CT_CAMERA_TARGET_SURFACE &&
+				camera->targetSurface->destroySignal == TRUE) {
+				camera->targetType		= CT_CAMERA_TARGET_NONE;
+				camera->targetSurface	= NULL;
+			}
+
 			if (camera->targetType == CT_CAMERA_TARGET_NONE) {
 				continue;
 			}
@@ -695,46 +1306,39 @@ void __CTRenderThreadProc(
 				renderTarget = camera->targetTexture;
 			}
 			if (camera->targetType == CT_CAMERA_TARGET_SURFACE) {
-				renderTarget = camera->targetSurface->frameBuffer;
+				renderTarget = CTSwapChainBackBuffer(camera->targetSurface->swapChain);
+				camera->targetSurface->frameDirty = TRUE;
 			}
 
 			CTFrameBufferLock(renderTarget);
 			CTFrameBufferClear(renderTarget, TRUE, TRUE);
 
-			PCTIterator gObjIter = CTIteratorCreate(__ctdata.sys.rendering.objList);
-			PCTGO		object	 = NULL;
-			while ((object = CTIteratorIterate(gObjIter)) != NULL) {
+			__HCTObjStoreCull(camera, renderTarget);
 
-				if (object->visible == FALSE) {
-					continue;
-				}
-
-				if (object->destroySignal == TRUE) {
+			P__CTGObjectStore	store		= &__ctdata.sys.rendering.objStore;
+			UINT32				drawCount	= store->count;
 
-					__HCTCallObjectGProc(
-						object,
-						CT_GPROC_REASON_DESTROY,
-						NULL
-					);
-					CTFree(object->gData);
-					CTDynListRemove(
-						__ctdata.sys.rendering.objList,
-						object
-					);
+			for (UINT32 objIndex = 0; objIndex < drawCount; objIndex++) {
 
+				if (store->visible[objIndex] == FALSE) {
 					continue;
 				}
 
+				PCTGO object = store->objects[objIndex];
+
 				__HCTCallObjectGProc(
 					object,
 					CT_GPROC_REASON_PRE_RENDER,
 					NULL
 				);
 
-				__HCTDrawGraphicsObject(
-					object,
-					camera
-				);
+				if (store->drawMask[objIndex] == TRUE) {
+					__HCTDrawGraphicsObject(
+						object,
+						camera,
+						renderTarget
+					);
+				}
 
 				__HCTCallObjectGProc(
 					object,
@@ -746,38 +1350,42 @@ void __CTRenderThreadProc(
 
 			} // END OBJECT LOOP
 
-			CTIteratorDestroy(&gObjIter);
 			CTFrameBufferUnlock(renderTarget);
 
 		} // END CAMERA LOOP
 
-		CTIteratorDestroy(&camIter);
+		CTDynListReadEnd(__ctdata.sys.rendering.cameraList);
 
-		PCTIterator surfIter = CTIteratorCreate(__ctdata.sys.rendering.surfaceList);
-		PCTSurface	surface	 = NULL;
-		while ((surface = CTIteratorIterate(surfIter)) != NULL) {
+		PCTSurface	surface			= NULL;
+		UINT32		publishCount	= 0;
+		CTDynListReadBegin(__ctdata.sys.rendering.surfaceList);
+		CT_DYNLIST_FOREACH(__ctdata.sys.rendering.surfaceList, surface) {
 
 			if (surface->destroySignal == TRUE) {
-				CTFrameBufferDestroy(&surface->frameBuffer);
-				CTWindowDestroy(&surface->window);
-				CTDynListRemove(__ctdata.sys.rendering.surfaceList, surface);
+				surface->renderReleased = TRUE;
 				continue;
 			}
 
-			CTWindowUpdate(surface->window);
+			if (surface->frameDirty == TRUE) {
+				CTSwapChainPublish(surface->swapChain);
+				surface->frameDirty = FALSE;
+				publishCount++;
+			}
 
 		}
 
-		CTIteratorDestroy(&surfIter);
+		CTDynListReadEnd(__ctdata.sys.rendering.surfaceList);
 
-		CTLockLeave(__ctdata.sys.rendering.lock);
+		if (publishCount > 0) {
+			CTThreadTask(
+				__ctdata.sys.rendering.presentThread,
+				__HCTSurfacePresentTask,
+				NULL,
+				FALSE
+			);
+		}
 
-		printf(
-			"CTRT: objs: %d | %d msec taken... | %f FPS\n", 
-			__ctdata.sys.rendering.objList->elementsUsedCount,
-			thread->threadSpinLastIntervalMsec,
-			1000.0f / (FLOAT)thread->threadSpinLastIntervalMsec
-		);
+		CTLockLeave(__ctdata.sys.rendering.lock);
 
 		break;
 
@@ -791,8 +1399,8 @@ void __CTRenderThreadProc(
 		CTLockEnter(__ctdata.sys.rendering.lock);
 		CTLockDestroy(&__ctdata.sys.rendering.lock);
 		CTDynListDestroy(&__ctdata.sys.rendering.objList);
+		__HCTObjStoreDestroy();
 		CTDynListDestroy(&__ctdata.sys.rendering.cameraList);
-		CTDynListDestroy(&__ctdata.sys.rendering.surfaceList);
 		CTLogStreamDestroy(&__ctdata.sys.rendering.logStream);
 		CTSubShaderDestroy(&__ctdata.sys.rendering.defaultSubShader);
 
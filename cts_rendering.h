@@ -77,20 +77,42 @@ typedef struct CTTransform {
 	FLOAT	depth;
 } CTTransform, *PCTTransform, CTTForm, *PCTTForm;
 
+/// gData of up to CT_GOBJECT_INLINE_DATA_SIZE bytes is stored inline in the
+/// object's own objList slot, only larger gData is allocated separately
+///
+/// transform, visibility and alpha are hot render data and do not live in
+/// the object, they are kept in the render system's object store (see
+/// __CTGObjectStore) and accessed through the getters/setters below. mesh
+/// and subShader decide the object's cull bound, so change them through
+/// CTGraphicsObjectSetMesh/SetSubShader. objects outside of a camera's view
+/// are culled and not drawn for that camera, but every visible object still
+/// gets its PRE_RENDER/POST_RENDER calls and ages
+///
+/// CTGraphicsObjectCreate never waits for a frame to finish: it only takes
+/// objList's writer lock, runs INIT and queues the object. the render thread
+/// moves queued objects into the object store at the start of its next
+/// spin, until then their hot data is kept in the object's pending fields
+
+#define CT_GOBJECT_INLINE_DATA_SIZE	128
 typedef struct CTGObject {
-	BOOL			visible;
 	BOOL			destroySignal;
+	UINT32			hotIndex;
 	FLOAT			age;
 	UINT32			outlineSizePixels;
 	PCTFB			texture;
+	PCTTexture		compactTexture;
 	PCTMesh			mesh;
 	PCTSubShader	subShader;
-	BYTE			alpha;
 	CTColor			outlineColor;
-	CTTForm			transform;
 	SIZE_T			gDataSizeBytes;
 	PVOID			gData;
 	PCTFUNCGOPROC	gProc;
+	CTTransform		pendingTransform;
+	BYTE			pendingVisible;
+	BYTE			pendingAlpha;
+	PVOID			pendingNext;
+	__declspec(align(16))
+	BYTE			gDataInline [CT_GOBJECT_INLINE_DATA_SIZE];
 } CTGObject, *PCTGObject, CTGO, *PCTGO;
 
 CTCALL	PCTGO	CTGraphicsObjectCreate(
@@ -106,6 +128,14 @@ CTCALL	PCTGO	CTGraphicsObjectCreate(
 	PVOID			initInput
 );
 CTCALL	BOOL	CTGraphicsObjectDestroy(PCTGO* pGObject);
+CTCALL	BOOL	CTGraphicsObjectGetTransform(PCTGO object, PCTTransform transformOut);
+CTCALL	BOOL	CTGraphicsObjectSetTransform(PCTGO object, CTTransform transform);
+CTCALL	BOOL	CTGraphicsObjectGetVisible(PCTGO object);
+CTCALL	BOOL	CTGraphicsObjectSetVisible(PCTGO object, BOOL visible);
+CTCALL	BYTE	CTGraphicsObjectGetAlpha(PCTGO object);
+CTCALL	BOOL	CTGraphicsObjectSetAlpha(PCTGO object, BYTE alpha);
+CTCALL	BOOL	CTGraphicsObjectSetMesh(PCTGO object, PCTMesh mesh);
+CTCALL	BOOL	CTGraphicsObjectSetSubShader(PCTGO object, PCTSubShader subShader);
 
 //////////////////////////////////////////////////////////////////////////////
 ///
@@ -113,10 +143,20 @@ CTCALL	BOOL	CTGraphicsObjectDestroy(PCTGO* pGObject);
 /// 
 //////////////////////////////////////////////////////////////////////////////
 
+/// surfaces are owned by the present thread, which creates their windows,
+/// pumps them and presents their swap chains to consumers. the render
+/// thread only draws into the back buffer and publishes it. a destroyed
+/// surface is freed by the present thread once the render thread has set
+/// renderReleased
+
+#define CT_SURFACE_HEADLESS			0
+#define CT_SURFACE_DEFAULT_BUFFERS	3
 typedef struct CTSurface {
-	BOOL		destroySignal;
-	PCTWindow	window;
-	PCTFB		frameBuffer;
+	BOOL			destroySignal;
+	volatile BOOL	renderReleased;
+	BOOL			frameDirty;
+	PCTWindow		window;
+	PCTSwapChain	swapChain;
 } CTSurface, *PCTSurface;
 
 CTCALL	PCTSurface	CTSurfaceCreate(
@@ -127,6 +167,17 @@ CTCALL	PCTSurface	CTSurfaceCreate(
 	UINT32	resX,
 	UINT32	resY
 );
+CTCALL	PCTSurface	CTSurfaceCreateEx(
+	PCHAR	title,
+	UINT32	windowType,
+	UINT32	width,
+	UINT32	height,
+	UINT32	resX,
+	UINT32	resY,
+	UINT32	bufferCount,
+	UINT32	colorFormat,
+	UINT32	fbFlags
+);
 CTCALL	BOOL		CTSurfaceShouldClose(PCTSurface surface);
 CTCALL	BOOL		CTSurfaceDestroy(PCTSurface* pSurface);
 
@@ -164,6 +215,7 @@ CTCALL	BOOL		CTCameraDestroy(PCTCamera* pCamera);
 //////////////////////////////////////////////////////////////////////////////
 
 #define CT_RTHREAD_SPINTIME_MSEC		(1000 / 40)
+#define CT_RTHREAD_SPINTIME_USEC		(1000000 / 40)
 #define CT_RTHREAD_GOBJ_NODE_SIZE		2048
 #define CT_RTHREAD_CAMERA_NODE_SIZE		32
 #define CT_RTHREAD_SURFACE_NODE_SIZE	32
@@ -171,6 +223,40 @@ CTCALL	BOOL		CTCameraDestroy(PCTCamera* pCamera);
 #define CT_RTHREAD_DITHER_MAX_ALPHA		247
 #define CT_RTHREAD_DITHER_MIN_ALPHA		7
 
+/// hot graphics object data, stored as parallel dense arrays (structure of
+/// arrays) so the per camera cull pass streams through only what it needs.
+/// an object's dense index is its hotIndex, removal moves the last entry
+/// into the hole. cullRadius is the mesh bound in object space, objects
+/// which can not be bounded (custom prim shader) get CT_GOBJECT_NO_CULL_RADIUS
+
+/// objects which are not in the store yet have a hotIndex of HOT_PENDING
+/// once queued, and HOT_UNPUBLISHED while their creator still runs INIT
+/// (the creator is the only thread which knows of them then, so their
+/// pending fields are written without the lock). pendingHead is a lock-free
+/// stack of queued objects linked through pendingNext
+
+#define CT_GOBJECT_STORE_CAPACITY_MIN	0x100
+#define CT_GOBJECT_NO_CULL_RADIUS		1e18f
+#define __CT_GOBJECT_HOT_PENDING		0xFFFFFFFE
+#define __CT_GOBJECT_HOT_UNPUBLISHED	0xFFFFFFFF
+typedef struct __CTGObjectStore {
+	UINT32	count;
+	UINT32	capacity;
+	UINT32	destroyPending;
+	PVOID	pendingHead;
+	PFLOAT	posX;
+	PFLOAT	posY;
+	PFLOAT	sclX;
+	PFLOAT	sclY;
+	PFLOAT	rot;
+	PFLOAT	depth;
+	PFLOAT	cullRadius;
+	PBYTE	visible;
+	PBYTE	alpha;
+	PBYTE	drawMask;
+	PCTGO*	objects;
+} __CTGObjectStore, *P__CTGObjectStore;
+
 void __CTRenderThreadProc(
 	UINT32		reason, 
 	PCTThread	thread, 
@@ -178,4 +264,11 @@ void __CTRenderThreadProc(
 	PVOID		input
 );
 
+void __CTPresentThreadProc(
+	UINT32		reason,
+	PCTThread	thread,
+	PVOID		threadData,
+	PVOID		input
+);
+
 #endif